@@ -19,186 +19,8 @@ extern "C" {
 #include <cstdlib>
 #include <linux/videodev2.h>
 #include <fstream>
-bool init_udp_socket(const std::string& ip, uint16_t port);
-void close_udp_socket();
-void send_rtp_packets(AVCodecContext* codec_ctx, AVPacket* pkt);
-void send_single_nal(uint8_t* nal, int size);
-void send_fu_a(uint8_t* nal, int size);
-void send_sps_pps(AVCodecContext* codec_ctx);
-void send_udp(uint8_t* packet, size_t packet_size);
-int encodeFrame(AVCodecContext* codec_context, AVFrame* frame);
-
-
-// RTP头（12字节）
-struct RTPHeader {
-  uint8_t cc : 4;      // CSRC计数
-  uint8_t extension : 1;
-  uint8_t padding : 1;
-  uint8_t version : 2; // 固定为2
-  uint8_t pt : 7;      // 负载类型（如96）
-  uint8_t marker : 1;
-  uint16_t seq;        // 序列号
-  uint32_t timestamp;  // 时间戳
-  uint32_t ssrc;       // 同步源标识
-};
-
-// 序列号和时间戳全局变量
-static uint16_t g_sequence = 0;
-static uint32_t g_timestamp = 0;
-
-//UDP套接字全局变量
-int sock = -1;
-sockaddr_in server_addr;
-
-//初始化UDP套接字
-bool init_udp_socket(const std::string& ip, uint16_t port) {
-    sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sock < 0) {
-        std::cerr << "Socket creation failed!" << std::endl;
-        return false;
-    }
-
-    std::memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    server_addr.sin_addr.s_addr = inet_addr(ip.c_str());
-    std::cout << "Socket creation succeed, port " <<port<< std::endl;
-
-
-    return true;
-}
-
-// 关闭UDP套接字
-void close_udp_socket() {
-    if (sock >= 0) {
-        close(sock);
-        sock = -1;
-        std::cout << "Socket closed." << std::endl;
-    }
-}
-
-void send_rtp_packets(AVCodecContext* codec_ctx, AVPacket* pkt) {
-  uint8_t* nal_data = pkt->data;
-  int nal_size = pkt->size;
-  uint8_t nal_type = nal_data[0] & 0x1F; // 取NAL类型低5位
-
-  // 强制发送SPS/PPS（关键帧前）
-  if (nal_type == 5) { // IDR帧
-    send_sps_pps(codec_ctx); // 发送SPS/PPS（见后续代码）
-  }
-
-  // 分片或直接发送
-  const int MTU = 1400;
-  if (nal_size <= MTU) {
-    send_single_nal(nal_data, nal_size);
-  } else {
-    send_fu_a(nal_data, nal_size);
-  }
-}
-
-
-void send_single_nal(uint8_t* nal, int size) {
-  // 构造RTP包：RTP头 + NAL数据
-  unsigned char packet[12 + size]; 
-  RTPHeader* header = (RTPHeader*)packet;
-  
-  // 填充RTP头
-  header->version = 2;
-  header->pt = 96;
-  header->seq = htons(g_sequence++);
-  header->timestamp = htonl(g_timestamp);
-  header->ssrc = htonl(0x12345678);
-  header->marker = 1; // 假设一帧一包
-
-  // 复制NAL数据
-  memcpy(packet + 12, nal, size);
-
-  // 发送UDP包（伪代码）
-  send_udp(packet, sizeof(packet));
-}
-
-void send_fu_a(uint8_t* nal, int size) {
-  const int FU_HEADER_SIZE = 2;
-  const int MAX_PAYLOAD = 1400 - 12 - FU_HEADER_SIZE;
-  uint8_t nal_header = nal[0];
-  
-  int offset = 1; // 跳过NAL头
-  int remaining = size - 1;
-  bool is_first = true;
-
-  while (remaining > 0) {
-    int payload_size = std::min(MAX_PAYLOAD, remaining);
-    unsigned char packet[12 + FU_HEADER_SIZE + payload_size];
-    RTPHeader* header = (RTPHeader*)packet;
-
-    // 填充RTP头
-    header->version = 2;
-    header->pt = 96;
-    header->seq = htons(g_sequence++);
-    header->timestamp = htonl(g_timestamp);
-    header->ssrc = htonl(0x12345678);
-    header->marker = (remaining <= payload_size) ? 1 : 0;
-
-    // 构造FU Indicator和FU Header
-    uint8_t fu_indicator = (nal_header & 0xE0) | 28; // FU-A类型为28
-    uint8_t fu_header = 0;
-    if (is_first) {
-      fu_header |= 0x80; // Start位
-    } else if (payload_size >= remaining) {
-      fu_header |= 0x40; // End位
-    }
-    fu_header |= (nal_header & 0x1F); // NAL类型
-
-    // 填充FU头
-    packet[12] = fu_indicator;
-    packet[13] = fu_header;
-
-    // 复制数据
-    memcpy(packet + 14, nal + offset, payload_size);
-
-    // 发送
-    send_udp(packet, sizeof(packet));
-
-    offset += payload_size;
-    remaining -= payload_size;
-    is_first = false;
-  }
-
-  // 更新时间戳（每帧递增）
-  g_timestamp += 90000 / 30; // 假设30fps
-}
-
-void send_sps_pps(AVCodecContext* codec_ctx) {
-  // 从extradata提取SPS/PPS
-  uint8_t* sps = codec_ctx->extradata + 4; // 假设extradata格式为[0,0,0,1, sps...]
-  int sps_len = codec_ctx->extradata[4] == 0x67 ? codec_ctx->extradata[5] << 8 | codec_ctx->extradata[6] : 0;
-  
-  uint8_t* pps = sps + sps_len + 4; // [0,0,0,1, pps...]
-  int pps_len = codec_ctx->extradata_size - (sps_len + 8);
-
-  // 发送SPS
-  send_single_nal(sps - 4, sps_len + 4); // 包含起始码
-
-  // 发送PPS
-  send_single_nal(pps - 4, pps_len + 4);
-}
-
-// send_udp函数：通过UDP发送数据包
-void send_udp(uint8_t* packet, size_t packet_size) {
-    if (sock < 0) {
-        std::cerr << "Socket creation failed!" << std::endl;
-        return;
-    }
-
-    // 发送数据
-    ssize_t sent_len = sendto(sock, packet, packet_size, 0, (struct sockaddr*)&server_addr, sizeof(server_addr));
-    if (sent_len < 0) {
-        std::cerr << "Failed to send UDP packet!" << std::endl;
-    } else {
-        std::cout << "Sent " << sent_len << " bytes." << std::endl;
-    }
-
-}
+#include "rtpPacketizer.h"
+int encodeFrame(AVCodecContext* codec_context, AVFrame* frame, RtpPacketizer& packetizer);
 
 struct Buffer {
     void* start;
@@ -231,7 +53,7 @@ void saveFrameAsYUV(AVFrame* out_frame, int width, int height, const char* filen
 }
 
 // 辅助函数：将一个 AVFrame 编码成 H.264 并写入文件
-int encodeFrame(AVCodecContext* codec_context, AVFrame* frame) {
+int encodeFrame(AVCodecContext* codec_context, AVFrame* frame, RtpPacketizer& packetizer) {
     int ret = avcodec_send_frame(codec_context, frame);
     if (ret < 0) {
         std::cerr << "Error sending frame for encoding: " << ret << std::endl;
@@ -257,8 +79,10 @@ int encodeFrame(AVCodecContext* codec_context, AVFrame* frame) {
         }
         // 将编码后的数据写入文件
         // outfile.write(reinterpret_cast<char*>(pkt->data), pkt->size);
-        // 将编码后的数据打包为RTP
-        send_rtp_packets(codec_context, pkt);
+        // 将编码后的数据打包为RTP：按起始码拆分 NAL，整帧用一次 sendmmsg 发出
+        AVRational rtp_time_base = {1, 90000};
+        uint32_t timestamp = static_cast<uint32_t>(av_rescale_q(pkt->pts, codec_context->time_base, rtp_time_base));
+        packetizer.packetize(pkt->data, pkt->size, timestamp);
 
 
 
@@ -428,10 +252,14 @@ int main() {
     //     return -1;
     // }
 
-     // 初始化UDP套接字
-    if (!init_udp_socket("127.0.0.1", 12345)) {
+     // 初始化RTP打包和UDP套接字
+    RtpPacketizer packetizer;
+    if (!packetizer.open("127.0.0.1", 12345)) {
         return 1;
     }
+    if (codec_context->extradata_size > 0) {
+        packetizer.setParameterSets(codec_context->extradata, codec_context->extradata_size);
+    }
     
     /////////////////////////////////主循环///////////////////////////////////////
 
@@ -484,7 +312,7 @@ int main() {
         // saveFrameAsYUV(out_frame, 640, 480, "output.yuv");
 
         // 对当前帧进行编码，并写入到输出文件
-        if (encodeFrame(codec_context, out_frame) < 0) {
+        if (encodeFrame(codec_context, out_frame, packetizer) < 0) {
             std::cerr << "Failed to encode frame " << i << std::endl;
             av_frame_free(&out_frame);
             break;
@@ -507,7 +335,7 @@ int main() {
     }
 
      // 7. 刷新编码器（送入 NULL 帧以获得延迟的包）
-    encodeFrame(codec_context, nullptr);
+    encodeFrame(codec_context, nullptr, packetizer);
 
     // 11. 释放资源
     sws_freeContext(sws_ctx);
@@ -521,6 +349,6 @@ int main() {
     std::cout << "H.264 编码完成，输出文件为 output.h264" << std::endl;
 
     // 关闭UDP套接字
-    close_udp_socket();
+    packetizer.close();
     return 0;
 }
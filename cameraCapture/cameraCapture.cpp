@@ -1,22 +1,75 @@
 #include "cameraCapture.h"
 
-CameraCapture::CameraCapture(int width = 640, int height = 480, const char* devName = "/dev/video0") : width_(width), height_(height), devName_(devName), running_(false){}
+CaptureDevice::~CaptureDevice(){
+    for (auto& buffer : buffers) {
+        if (buffer.start != MAP_FAILED) munmap(buffer.start, buffer.length);
+    }
+    if (fd != -1) close(fd);
+}
+
+FrameLease& FrameLease::operator=(FrameLease&& other) noexcept {
+    if (this == &other) return *this;
+    release();
+    device_ = std::move(other.device_);
+    index_ = other.index_;
+    data_ = other.data_;
+    size_ = other.size_;
+    timestampUs_ = other.timestampUs_;
+    sequence_ = other.sequence_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+    return *this;
+}
+
+void FrameLease::release(){
+    if (!device_) return;
+
+    // stop() 之后设备已经停止流，缓冲区不再入队，只等最后一个持有者释放映射
+    if (device_->streaming) {
+        struct v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index  = index_;
+        if (ioctl(device_->fd, VIDIOC_QBUF, &buf) == -1) perror("重新入队缓冲区失败");
+    }
+
+    device_.reset();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+CameraCapture::CameraCapture(int width, int height, const char* devName, int bufferCount) : width_(width), height_(height), devName_(devName), bufferCount_(bufferCount), running_(false),
+    stopFd_(-1), policy_(DropPolicy::LatestFrame), everyN_(1),
+    captured_(0), delivered_(0), dropped_(0), driverDropped_(0),
+    lastLatencyUs_(0), maxLatencyUs_(0), totalLatencyUs_(0), lastSequence_(0), haveSequence_(false){}
 
 CameraCapture::~CameraCapture(){
     stop();
 }
 
 void CameraCapture::start(FrameCallback callback){
+    // 旧接口在租约之上实现：拷贝一份再立即释放租约
+    start(LeaseCallback([callback](FrameLease lease) {
+        std::vector<uint8_t> frame(lease.data(), lease.data() + lease.size());
+        lease.release();
+        callback(frame);
+    }));
+}
+
+void CameraCapture::start(LeaseCallback callback){
      std::lock_guard<std::mutex> lock(mutex_);
         if (running_) return;
 
         // 初始化设备
-        fd_ = open(devName_.c_str(), O_RDWR);
-        if (fd_ == -1) throw std::runtime_error("无法打开摄像头设备");
+        device_ = std::make_shared<CaptureDevice>();
+        device_->fd = open(devName_.c_str(), O_RDWR | O_NONBLOCK);
+        int fd = device_->fd;
+        if (fd == -1) throw std::runtime_error("无法打开摄像头设备");
 
         // 查询设备能力
         struct v4l2_capability cap;
-        if (ioctl(fd_, VIDIOC_QUERYCAP, &cap) == -1) throw std::runtime_error("查询设备能力失败");
+        if (ioctl(fd, VIDIOC_QUERYCAP, &cap) == -1) throw std::runtime_error("查询设备能力失败");
         std::cout << "摄像头设备： " << cap.card << std::endl;
 
         // 设置视频格式
@@ -27,17 +80,21 @@ void CameraCapture::start(FrameCallback callback){
         fmt.fmt.pix.height = height_;
         fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
         fmt.fmt.pix.field = V4L2_FIELD_INTERLACED;
-        if (ioctl(fd_, VIDIOC_S_FMT, &fmt) == -1) throw std::runtime_error("设置视频格式失败");
+        if (ioctl(fd, VIDIOC_S_FMT, &fmt) == -1) throw std::runtime_error("设置视频格式失败");
 
         std::cout << "视频格式设置为 YUYV 640x480" << std::endl;
 
         // 请求缓冲区
         struct v4l2_requestbuffers req;
         memset(&req, 0, sizeof(req));
-        req.count = 4;
+        req.count = bufferCount_;
         req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
         req.memory = V4L2_MEMORY_MMAP;
-        if (ioctl(fd_, VIDIOC_REQBUFS, &req) == -1) throw std::runtime_error("请求缓冲区失败");
+        if (ioctl(fd, VIDIOC_REQBUFS, &req) == -1) throw std::runtime_error("请求缓冲区失败");
+        if (req.count < 2) throw std::runtime_error("缓冲区数量不足");
+        bufferCount_ = req.count;
+        device_->buffers.assign(req.count, Buffer{MAP_FAILED, 0});
+        std::vector<Buffer>& buffers = device_->buffers;
 
         // 映射缓冲区
         for (unsigned int i = 0; i < req.count; ++i) {
@@ -46,10 +103,10 @@ void CameraCapture::start(FrameCallback callback){
             buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
             buf.memory = V4L2_MEMORY_MMAP;
             buf.index = i;
-            if (ioctl(fd_, VIDIOC_QUERYBUF, &buf) == -1) throw std::runtime_error("查询缓冲区失败");
-            buffers_[i].length = buf.length;
-            buffers_[i].start = (mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, buf.m.offset));
-            if (buffers_[i].start == MAP_FAILED) throw std::runtime_error("映射缓冲区失败");
+            if (ioctl(fd, VIDIOC_QUERYBUF, &buf) == -1) throw std::runtime_error("查询缓冲区失败");
+            buffers[i].start = (mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset));
+            buffers[i].length = buf.length;
+            if (buffers[i].start == MAP_FAILED) throw std::runtime_error("映射缓冲区失败");
         }
 
             // 将缓冲区入队
@@ -59,7 +116,7 @@ void CameraCapture::start(FrameCallback callback){
             buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
             buf.memory = V4L2_MEMORY_MMAP;
             buf.index  = i;
-            if (ioctl(fd_, VIDIOC_QBUF, &buf) == -1) {
+            if (ioctl(fd, VIDIOC_QBUF, &buf) == -1) {
                 throw std::runtime_error("缓冲区入队失败");
                 
             }
@@ -67,8 +124,8 @@ void CameraCapture::start(FrameCallback callback){
 
         // 启动视频流
         type_ = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        int ret = ioctl(fd_, VIDIOC_STREAMON, &type_);
-        // if (ioctl(fd_, VIDIOC_STREAMON, type) == -1) throw std::runtime_error("启动视频流失败");
+        int ret = ioctl(fd, VIDIOC_STREAMON, &type_);
+        // if (ioctl(fd, VIDIOC_STREAMON, type) == -1) throw std::runtime_error("启动视频流失败");
         if (ret == -1) {
             std::cerr << "VIDIOC_STREAMON failed: " 
                     << strerror(errno) << " (" << errno << ")" << std::endl;
@@ -76,6 +133,11 @@ void CameraCapture::start(FrameCallback callback){
         }
 
 
+        stopFd_ = eventfd(0, EFD_NONBLOCK);
+        if (stopFd_ == -1) throw std::runtime_error("创建 eventfd 失败");
+
+        haveSequence_ = false;
+        device_->streaming = true;
         running_ = true;
         captureThread_ = std::thread(&CameraCapture::captureLoop, this, std::move(callback));
 }
@@ -84,41 +146,144 @@ void CameraCapture::stop(){
     std::lock_guard<std::mutex> lock(mutex_);
     if (!running_) return;
 
+    // 唤醒 epoll_wait，采集线程不会卡在阻塞的 ioctl 里
     running_ = false;
+    uint64_t one = 1;
+    if (write(stopFd_, &one, sizeof(one)) != sizeof(one)) perror("唤醒采集线程失败");
     if (captureThread_.joinable()) captureThread_.join();
+    close(stopFd_);
+    stopFd_ = -1;
 
-        // 停止视频流
-        if (ioctl(fd_, VIDIOC_STREAMOFF, &type_) == -1) perror("停止视频流失败");
+        // 停止视频流，之后释放的租约不再入队
+        device_->streaming = false;
+        if (ioctl(device_->fd, VIDIOC_STREAMOFF, &type_) == -1) perror("停止视频流失败");
 
-        // 释放缓冲区
-        for (auto& buffer : buffers_) {
-            munmap(buffer.start, buffer.length);
-        }
-        close(fd_);
+        // 释放缓冲区：还有租约未释放时由最后一个租约 munmap 并关闭设备
+        device_.reset();
 }
 
-void CameraCapture::captureLoop(FrameCallback callback){
-    while (running_) {
-        struct v4l2_buffer buf;
-        memset(&buf, 0, sizeof(buf));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+void CameraCapture::setDropPolicy(DropPolicy policy, int n){
+    everyN_ = n < 1 ? 1 : n;
+    policy_ = policy;
+}
+
+CaptureStats CameraCapture::getStats() const{
+    CaptureStats stats;
+    stats.captured = captured_;
+    stats.delivered = delivered_;
+    stats.dropped = dropped_;
+    stats.driverDropped = driverDropped_;
+    stats.lastLatencyUs = lastLatencyUs_;
+    stats.maxLatencyUs = maxLatencyUs_;
+    stats.meanLatencyUs = stats.delivered ? double(totalLatencyUs_) / stats.delivered : 0.0;
+    return stats;
+}
 
-        if (ioctl(fd_, VIDIOC_DQBUF, &buf) == -1) {
-            perror("取出缓冲区失败");
+// 从驱动取出一帧，没有可取的帧时返回 false
+bool CameraCapture::dequeue(FrameLease& lease){
+    struct v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+
+    while (ioctl(device_->fd, VIDIOC_DQBUF, &buf) == -1) {
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN) perror("取出缓冲区失败");
+        return false;
+    }
+
+    if (haveSequence_ && buf.sequence > lastSequence_ + 1) driverDropped_ += buf.sequence - lastSequence_ - 1;
+    lastSequence_ = buf.sequence;
+    haveSequence_ = true;
+    captured_++;
+
+    // 不拷贝：租约直接指向 mmap 缓冲区，租约释放时才重新入队
+    lease.device_ = device_;
+    lease.index_ = buf.index;
+    lease.data_ = static_cast<const uint8_t*>(device_->buffers[buf.index].start);
+    lease.size_ = buf.bytesused ? buf.bytesused : device_->buffers[buf.index].length;
+    lease.timestampUs_ = int64_t(buf.timestamp.tv_sec) * 1000000 + buf.timestamp.tv_usec;
+    lease.sequence_ = buf.sequence;
+    monotonic_ = (buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+    return true;
+}
+
+void CameraCapture::deliver(LeaseCallback& callback, FrameLease lease){
+    // 延迟用驱动时间戳所用的时钟计算
+    struct timespec now;
+    clock_gettime(monotonic_ ? CLOCK_MONOTONIC : CLOCK_REALTIME, &now);
+    int64_t latency = int64_t(now.tv_sec) * 1000000 + now.tv_nsec / 1000 - lease.timestampUs();
+
+    lastLatencyUs_ = latency;
+    if (latency > maxLatencyUs_) maxLatencyUs_ = latency;
+    totalLatencyUs_ += latency;
+    delivered_++;
+
+    callback(std::move(lease));
+}
+
+void CameraCapture::captureLoop(LeaseCallback callback){
+    int epfd = epoll_create1(0);
+    if (epfd == -1) {
+        perror("创建 epoll 失败");
+        return;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = device_->fd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, device_->fd, &ev);
+    ev.data.fd = stopFd_;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, stopFd_, &ev);
+
+    std::vector<FrameLease> frames;
+    frames.reserve(bufferCount_);
+
+    while (running_) {
+        struct epoll_event events[2];
+        int n = epoll_wait(epfd, events, 2, -1);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait 失败");
             break;
         }
 
-        std::vector<uint8_t> frame(
-            static_cast<uint8_t*>(buffers_[buf.index].start),
-            static_cast<uint8_t*>(buffers_[buf.index].start) + buffers_[buf.index].length
-        );
-        callback(frame);
+        bool stopRequested = false, ready = false;
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == stopFd_) stopRequested = true;
+            else ready = true;
+        }
+        if (stopRequested || !running_) break;
+        if (!ready) continue;
+
+        // 取出驱动里所有已完成的帧，再按丢帧策略决定交付哪些
+        FrameLease lease;
+        while (dequeue(lease)) frames.push_back(std::move(lease));
+        if (frames.empty()) continue;
 
-        // 重新入队缓冲区
-        if (ioctl(fd_, VIDIOC_QBUF, &buf) == -1) {
-            perror("重新入队缓冲区失败");
+        switch (policy_.load()) {
+        case DropPolicy::LatestFrame:
+            // 更早的帧已经过时，先重新入队再交付最新的一帧
+            dropped_ += frames.size() - 1;
+            for (size_t i = 0; i + 1 < frames.size(); i++) frames[i].release();
+            deliver(callback, std::move(frames.back()));
+            break;
+        case DropPolicy::Fifo:
+            for (auto& frame : frames) deliver(callback, std::move(frame));
+            break;
+        case DropPolicy::EveryNth:
+            for (auto& frame : frames) {
+                if (frame.sequence() % everyN_ == 0) deliver(callback, std::move(frame));
+                else {
+                    frame.release();
+                    dropped_++;
+                }
+            }
             break;
         }
+        frames.clear();
     }
-}
 
+    close(epfd);
+}
@@ -7,43 +7,131 @@
 #include <sys/ioctl.h>
 #include <linux/videodev2.h>
 #include <cstring>
+#include <cstdint>
 #include <vector>
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 struct Buffer {
     void* start;
     size_t length;
 };
 
+// 打开的设备和它的 mmap 缓冲区。由 CameraCapture 和所有未释放的 FrameLease 共享，
+// 最后一个持有者释放时才 munmap 并关闭设备，所以 stop() 之后租约仍然可以安全访问。
+struct CaptureDevice {
+    int fd = -1;
+    std::vector<Buffer> buffers;
+    std::atomic<bool> streaming{false};
+
+    ~CaptureDevice();
+};
+
+// 一帧的租约：直接指向驱动的 mmap 缓冲区，不做拷贝。只能移动不能复制，
+// 租约被释放（release() 或析构）时缓冲区重新入队给驱动。
+// 持有租约期间驱动少一个可用缓冲区，所以应尽快释放。
+class FrameLease
+{
+public:
+    FrameLease() = default;
+    ~FrameLease() { release(); }
+
+    FrameLease(FrameLease&& other) noexcept { *this = std::move(other); }
+    FrameLease& operator=(FrameLease&& other) noexcept;
+
+    FrameLease(const FrameLease&) = delete;
+    FrameLease& operator=(const FrameLease&) = delete;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    int64_t timestampUs() const { return timestampUs_; }   // 驱动给出的采集时间（通常是 CLOCK_MONOTONIC），微秒
+    uint32_t sequence() const { return sequence_; }         // 驱动的帧序号，不连续说明驱动丢了帧
+    explicit operator bool() const { return device_ != nullptr; }
+
+    void release();   // 将缓冲区重新入队，之后 data() 不再有效
+
+private:
+    friend class CameraCapture;
+
+    std::shared_ptr<CaptureDevice> device_;
+    unsigned index_ = 0;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    int64_t timestampUs_ = 0;
+    uint32_t sequence_ = 0;
+};
+
+// 回调跟不上采集速度时如何丢帧
+enum class DropPolicy {
+    LatestFrame,   // 只交付驱动里最新的一帧，更早的直接重新入队（默认，适合实时链路）
+    Fifo,          // 按顺序交付每一帧，回调慢时由驱动在缓冲区用尽后丢帧
+    EveryNth       // 每 N 帧交付一帧（按驱动帧序号），其余直接重新入队
+};
+
+struct CaptureStats {
+    uint64_t captured;       // 从驱动取出的帧数
+    uint64_t delivered;      // 交给回调的帧数
+    uint64_t dropped;        // 按丢帧策略丢掉的帧数
+    uint64_t driverDropped;  // 驱动帧序号的缺口，即驱动因没有空闲缓冲区而丢掉的帧数
+    int64_t lastLatencyUs;   // 最近一帧从采集到调用回调的延迟
+    int64_t maxLatencyUs;    // 最大延迟
+    double meanLatencyUs;    // 平均延迟
+};
+
 class CameraCapture
 {
 public:
     using FrameCallback = std::function<void(const std::vector<uint8_t>& frame)>;
+    using LeaseCallback = std::function<void(FrameLease lease)>;
 
-    CameraCapture(int width, int height, const char* devName);
+    // bufferCount 是向驱动请求的 mmap 缓冲区数量，驱动可能会调整
+    CameraCapture(int width = 640, int height = 480, const char* devName = "/dev/video0", int bufferCount = 4);
     ~CameraCapture();
 
+    // 零拷贝：回调拿到缓冲区的租约，可以把它移交给其他线程，释放时缓冲区才重新入队
+    void start(LeaseCallback callback);
+    // 兼容旧接口：每帧拷贝到一个 vector，回调返回后缓冲区立即重新入队
     void start(FrameCallback callback);
     void stop();
+
+    // 可以在运行中修改；EveryNth 时 n 是抽取间隔
+    void setDropPolicy(DropPolicy policy, int n = 1);
+    CaptureStats getStats() const;
+
+    int bufferCount() const { return bufferCount_; }
 private:
-    void captureLoop(FrameCallback callback);
+    void captureLoop(LeaseCallback callback);
+    bool dequeue(FrameLease& lease);
+    void deliver(LeaseCallback& callback, FrameLease lease);
 
-    int fd_;
     int type_;
-    Buffer buffers_[4];
+    std::shared_ptr<CaptureDevice> device_;
     std::string devName_;
     int width_;
     int height_;
+    int bufferCount_;
     std::atomic<bool> running_;
     std::thread captureThread_;
     std::mutex mutex_;
 
-    
+    int stopFd_;                        // eventfd，stop() 用它唤醒 epoll_wait
+    std::atomic<DropPolicy> policy_;
+    std::atomic<int> everyN_;
+
+    std::atomic<uint64_t> captured_, delivered_, dropped_, driverDropped_;
+    std::atomic<int64_t> lastLatencyUs_, maxLatencyUs_, totalLatencyUs_;
+    uint32_t lastSequence_;
+    bool haveSequence_;
+    bool monotonic_ = true;             // 驱动时间戳是否基于 CLOCK_MONOTONIC
+
+
 };
 
 
-#endif //VIDEO_PREPROCESS_H
\ No newline at end of file
+#endif //VIDEO_PREPROCESS_H
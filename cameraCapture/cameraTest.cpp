@@ -34,6 +34,11 @@ void test_camera_capture() {
         // 停止摄像头
         camera.stop();
 
+        CaptureStats stats = camera.getStats();
+        cout << "采集 " << stats.captured << " 帧，交付 " << stats.delivered << " 帧，丢弃 " << stats.dropped
+             << " 帧，驱动丢帧 " << stats.driverDropped << "，平均延迟 " << stats.meanLatencyUs << " us，最大延迟 "
+             << stats.maxLatencyUs << " us" << endl;
+
         cout << "测试完成！检查生成的 test_frame.yuv 文件" << endl;
     } catch (const exception& e) {
         cerr << "CameraCapture 测试失败: " << e.what() << endl;
@@ -0,0 +1,89 @@
+/*! \file bench_aggregation.cpp
+ *  \brief Compares aggregated PPDUs against one PPDU per packet.
+ *
+ *  This file first checks that an aggregate of two packets survives encoding and decoding,
+ *  including when one of its subframes is corrupted on the air. It then reports, for each
+ *  PHY rate, the air time and goodput of sending 1500 byte packets one per PPDU and
+ *  aggregated up to MAX_FRAME_SIZE bytes per PPDU.
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include "aggregator.h"
+#include "frame_builder.h"
+#include "modulator.h"
+#include "ppdu.h"
+
+using namespace fun;
+
+int payload_length = 1500;   //!< Bytes per packet
+int num_packets = 1000;      //!< Packets per measurement
+int gap_samples = 80;        //!< Idle samples between PPDUs, same as transmitter::start_async()
+double sample_rate = 20e6;   //!< 802.11a sample rate used to convert samples to time
+
+/*!
+ * \brief Encodes an aggregate at rate and decodes it, optionally destroying one symbol.
+ * \return The number of packets recovered.
+ */
+int round_trip(const std::vector<unsigned char> & ampdu, Rate rate, int corrupt_symbol)
+{
+    RateParams rate_params = RateParams(rate);
+    int num_symbols = ppdu::data_symbol_count(ampdu.size(), rate);
+
+    std::vector<unsigned char> data(num_symbols * rate_params.dbps / 8 + 1);
+    std::vector<unsigned char> coded(num_symbols * rate_params.dbps * 2);
+    std::vector<unsigned char> bits(num_symbols * rate_params.cbps);
+    ppdu::encode_data_bits(ampdu.data(), ampdu.size(), rate, data.data(), coded.data(), bits.data(), SERVICE_AGGREGATED);
+
+    std::vector<std::complex<double> > samples = modulator::modulate(bits, rate);
+    if(corrupt_symbol >= 0)
+        for(int x = corrupt_symbol * 48; x < (corrupt_symbol + 2) * 48; x++)
+            samples[x] = -samples[x];
+
+    ppdu frame = ppdu(rate, ampdu.size());
+    if(!frame.decode_data(samples) || !frame.is_aggregated()) return 0;
+    return aggregator::unpack(frame.get_payload()).size();
+}
+
+int main(int argc, char * argv[]){
+
+    std::cout << "Benchmarking aggregation..." << std::endl;
+
+    std::vector<std::vector<unsigned char> > packets(num_packets, std::vector<unsigned char>(payload_length));
+    for(int x = 0; x < num_packets; x++)
+        for(int y = 0; y < payload_length; y++)
+            packets[x][y] = rand();
+
+    // Check that intact subframes are recovered
+    std::vector<unsigned char> ampdu;
+    int packed = aggregator::pack(packets, 0, ampdu, MAX_FRAME_SIZE);
+    printf("Aggregate of %d packets: %d bytes, clean %d recovered, first subframe corrupted %d recovered\n",
+           packed, (int)ampdu.size(), round_trip(ampdu, RATE_1_2_QPSK, -1), round_trip(ampdu, RATE_1_2_QPSK, 10));
+
+    for(int r = RATE_1_2_BPSK; r <= RATE_3_4_QAM64; r++)
+    {
+        Rate rate = Rate(r);
+
+        long long single_samples = 0;
+        for(int x = 0; x < num_packets; x++)
+            single_samples += frame_builder::frame_length(payload_length, rate) + gap_samples;
+
+        long long aggregate_samples = 0;
+        int aggregate_frames = 0;
+        for(int x = 0; x < num_packets; x += packed, aggregate_frames++)
+        {
+            packed = aggregator::pack(packets, x, ampdu, MAX_FRAME_SIZE);
+            aggregate_samples += frame_builder::frame_length(ampdu.size(), rate) + gap_samples;
+        }
+
+        double bits = 8.0 * payload_length * num_packets;
+        double single_mbps = bits / (single_samples / sample_rate) / 1e6;
+        double aggregate_mbps = bits / (aggregate_samples / sample_rate) / 1e6;
+
+        printf("%-10s one per PPDU %6.2f Mbit/s (%4d PPDUs)  aggregated %6.2f Mbit/s (%4d PPDUs)  %+5.1f%%\n",
+               RateParams(rate).name.c_str(), single_mbps, num_packets, aggregate_mbps, aggregate_frames,
+               100.0 * (aggregate_mbps / single_mbps - 1));
+    }
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*! \file bench_crc32.cpp
+ *  \brief Benchmarks the crc32 engines against boost::crc_32_type.
+ *
+ *  This file checks that every crc32 engine matches boost::crc_32_type and reports
+ *  the throughput of each in GB/s for a short frame, an MTU sized frame and a large
+ *  aggregate.
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <boost/crc.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "crc32.h"
+
+using namespace fun;
+
+long long bytes_per_run = 64 * 1024 * 1024; //!< Bytes checksummed per measurement
+
+/*!
+ * \brief Times one function over #bytes_per_run bytes.
+ * \return Throughput in GB/s.
+ */
+template<typename F>
+double measure(F f, int length)
+{
+    long long iterations = bytes_per_run / length;
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+    for(long long i = 0; i < iterations; i++) f();
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::local_time() - start;
+    return double(iterations * length) / (elapsed.total_microseconds() * 1e3);
+}
+
+int main(int argc, char * argv[]){
+
+    std::cout << "Benchmarking crc32..." << std::endl;
+    printf("PCLMULQDQ: %s\n", crc32::pclmul_supported() ? "supported" : "not supported");
+
+    int lengths[] = {64, 1506, 65536};
+    std::vector<unsigned char> data(lengths[2]);
+    for(int x = 0; x < data.size(); x++) data[x] = rand();
+
+    volatile unsigned int sink = 0;
+    for(int length : lengths)
+    {
+        boost::crc_32_type reference;
+        reference.process_bytes(data.data(), length);
+
+        crc32 slicing(crc32::SLICING_BY_16), pclmul(crc32::PCLMUL);
+        slicing.process_bytes(data.data(), length);
+        pclmul.process_bytes(data.data(), length);
+        bool match = slicing.checksum() == reference.checksum() && pclmul.checksum() == reference.checksum();
+
+        double boost_gbps = measure([&]{ boost::crc_32_type c; c.process_bytes(data.data(), length); sink = c.checksum(); }, length);
+        double slicing_gbps = measure([&]{ crc32 c(crc32::SLICING_BY_16); c.process_bytes(data.data(), length); sink = c.checksum(); }, length);
+        double pclmul_gbps = measure([&]{ crc32 c(crc32::PCLMUL); c.process_bytes(data.data(), length); sink = c.checksum(); }, length);
+
+        printf("%6d bytes (%s): boost %6.2f GB/s  slicing-by-16 %6.2f GB/s  pclmul %6.2f GB/s\n",
+               length, match ? "match" : "MISMATCH", boost_gbps, slicing_gbps, pclmul_gbps);
+    }
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*! \file bench_frame_builder.cpp
+ *  \brief Benchmarks the frame builder at every PHY rate.
+ *
+ *  This file builds 1500 byte frames at each rate with the original chain of temporary
+ *  vectors (CRC, scrambler, convolutional encoder, puncturer, interleaver and
+ *  modulator each into a new vector, then symbol_mapper::map, fft::inverse, cyclic prefix
+ *  copy, preamble copy) and with frame_builder::build_frame_into, checks that both produce
+ *  the same samples and reports frames per second for each.
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <arpa/inet.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "frame_builder.h"
+#include "ppdu.h"
+#include "symbol_mapper.h"
+#include "preamble.h"
+#include "parity.h"
+#include "viterbi.h"
+#include "puncturer.h"
+#include "interleaver.h"
+#include "modulator.h"
+#include "crc32.h"
+#include "scrambler.h"
+
+using namespace fun;
+
+int payload_length = 1500; //!< Bytes per frame
+int iterations = 500;      //!< Frames per measurement
+
+/*!
+ * \brief Encodes the SIGNAL and DATA fields the way ppdu::encode used to, one temporary per stage.
+ *  This does not go through ppdu::encode_data_bits, which frame_builder::build_frame_into uses.
+ */
+std::vector<std::complex<double> > reference_encode(const std::vector<unsigned char> & payload, Rate rate)
+{
+    RateParams rate_params = RateParams(rate);
+
+    // SIGNAL field: rate, length and parity, 1/2 coded and interleaved, BPSK
+    unsigned int header_field = ((rate_params.rate_field & 0xF) << 13) | (payload.size() & 0xFFF);
+    if(parity(header_field) == 1) header_field |= 131072;
+    header_field <<= 6;
+    unsigned char header_bytes[4];
+    unsigned int h = htonl(header_field) >> 8;
+    memcpy(header_bytes, &h, 3);
+
+    std::vector<unsigned char> header_symbols(48);
+    viterbi v;
+    v.conv_encode(header_bytes, &header_symbols[0], 18);
+    std::vector<std::complex<double> > header = modulator::modulate(interleaver::interleave(header_symbols), RATE_1_2_BPSK);
+
+    // DATA field: service, payload and CRC, padded to whole symbols
+    int num_symbols = std::ceil(double(16 + 8 * (payload.size() + 4) + 6) / double(rate_params.dbps));
+    int num_data_bits = num_symbols * rate_params.dbps;
+    int num_data_bytes = num_data_bits / 8;
+
+    std::vector<unsigned char> data(num_data_bytes + 1, 0);
+    memcpy(&data[2], payload.data(), payload.size());
+    crc32 crc;
+    crc.process_bytes(&data[0], 2 + payload.size());
+    unsigned int calculated_crc = crc.checksum();
+    memcpy(&data[2 + payload.size()], &calculated_crc, 4);
+
+    // Scramble into a copy and zero the tail bits
+    std::vector<unsigned char> scrambled(data);
+    scrambler::get(SCRAMBLER_DEFAULT_SEED).apply(&scrambled[0], (num_data_bits + 7) / 8);
+    for(int x = num_data_bits - 6; x < num_data_bits; x++) scrambled[x / 8] &= ~(0x80 >> (x % 8));
+
+    std::vector<unsigned char> encoded(num_data_bits * 2, 0);
+    v.conv_encode(&scrambled[0], encoded.data(), num_data_bits - 6);
+    std::vector<unsigned char> punctured = puncturer::puncture(encoded, rate_params);
+    std::vector<unsigned char> interleaved = interleaver::interleave(punctured, rate);
+    std::vector<std::complex<double> > modulated = modulator::modulate(interleaved, rate);
+
+    std::vector<std::complex<double> > samples(header.size() + modulated.size());
+    memcpy(&samples[0], &header[0], header.size() * sizeof(std::complex<double>));
+    memcpy(&samples[header.size()], &modulated[0], modulated.size() * sizeof(std::complex<double>));
+    return samples;
+}
+
+/*!
+ * \brief Builds a frame the way frame_builder::build_frame used to, one temporary per stage.
+ */
+std::vector<std::complex<double> > reference_build(fft & ifft, std::vector<unsigned char> payload, Rate rate)
+{
+    std::vector<std::complex<double> > samples = reference_encode(payload, rate);
+
+    symbol_mapper mapper = symbol_mapper();
+    std::vector<std::complex<double> > mapped = mapper.map(samples);
+
+    ifft.inverse(mapped);
+
+    std::vector<std::complex<double> > prefixed(mapped.size() * 80 / 64);
+    for(int x = 0; x < mapped.size() / 64; x++)
+    {
+        memcpy(&prefixed[x*80], &mapped[x*64+48], 16*sizeof(std::complex<double>));
+        memcpy(&prefixed[x*80+16], &mapped[x*64], 64*sizeof(std::complex<double>));
+    }
+
+    std::vector<std::complex<double> > frame(prefixed.size() + 320);
+    memcpy(&frame[0], &PREAMBLE_SAMPLES[0], 320 * sizeof(std::complex<double>));
+    memcpy(&frame[320], &prefixed[0], prefixed.size() * sizeof(std::complex<double>));
+    return frame;
+}
+
+/*!
+ * \brief Times one function over #iterations frames.
+ * \return Frames per second.
+ */
+template<typename F>
+double measure(F f)
+{
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+    for(int i = 0; i < iterations; i++) f();
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::local_time() - start;
+    return iterations * 1e6 / elapsed.total_microseconds();
+}
+
+int main(int argc, char * argv[]){
+
+    std::cout << "Benchmarking frame builder..." << std::endl;
+
+    std::vector<unsigned char> payload(payload_length);
+    for(int x = 0; x < payload.size(); x++) payload[x] = rand();
+
+    fft ifft(64);
+    frame_builder builder;
+    std::vector<std::complex<double> > frame(frame_builder::frame_length(payload_length, RATE_1_2_BPSK));
+
+    for(int r = RATE_1_2_BPSK; r <= RATE_3_4_QAM64; r++)
+    {
+        Rate rate = Rate(r);
+
+        std::vector<std::complex<double> > reference = reference_build(ifft, payload, rate);
+        int length = builder.build_frame_into(payload.data(), payload.size(), rate, frame.data(), frame.size());
+        double max_error = length == reference.size() ? 0 : 1;
+        for(int x = 0; x < length && x < reference.size(); x++) max_error = std::max(max_error, std::abs(frame[x] - reference[x]));
+
+        double reference_fps = measure([&]{ reference_build(ifft, payload, rate); });
+        double into_fps = measure([&]{ builder.build_frame_into(payload.data(), payload.size(), rate, frame.data(), frame.size()); });
+
+        printf("%-10s %6d samples (max error %.1e): reference %8.0f frames/s  build_frame_into %8.0f frames/s  (%.2fx)\n",
+               RateParams(rate).name.c_str(), length, max_error, reference_fps, into_fps, into_fps / reference_fps);
+    }
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*! \file bench_link_capacity.cpp
+ *  \brief Prints the link capacity model for every PHY rate.
+ *
+ *  For each PHY rate this file reports the air time of a full PPDU, the MPDU throughput with
+ *  one MPDU per PPDU and with aggregation, and the encoder bitrate that link_capacity
+ *  recommends for RTP packets of the given size, i.e. what VideoEncoder::set_bitrate()
+ *  should be given when the link switches to that rate.
+ *
+ *  It then compares RTP fragments of a fixed MTU with fragments sized by
+ *  link_capacity::aligned_length() (as TransmitSink does for RtpPacketizer::setFragmentSize()):
+ *  the pad bits per full fragment, and the padding share of the data symbols and the air time
+ *  of one large NAL unit sent one fragment per PPDU.
+ *
+ *  Usage: bench_link_capacity [sample_rate] [mpdu_length]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include "link_capacity.h"
+#include "ppdu.h"
+
+using namespace fun;
+
+double sample_rate = 5e6;    //!< Same default as the transmitter
+int mpdu_length = 1200;      //!< Bytes per RTP packet
+int gap_samples = 80;        //!< Idle samples between PPDUs, same as transmitter::start_async()
+int nal_length = 60000;      //!< Bytes in the NAL unit that is fragmented
+
+/*!
+ * \brief Fragments nal_length bytes into FU-A packets of at most packet_length bytes.
+ * \param pad_share Output: pad bits over all data symbol bits.
+ * \return Air time of all the PPDUs in seconds.
+ */
+double fragment_nal(const link_capacity & capacity, Rate rate, int packet_length, double & pad_share)
+{
+    int payload = packet_length - 14;   // RTP header + FU indicator + FU header
+    long long pad = 0, symbol_bits = 0;
+    double airtime = 0;
+    for(int remaining = nal_length - 1; remaining > 0; remaining -= payload)
+    {
+        int length = 14 + (remaining < payload ? remaining : payload);
+        pad += link_capacity::padding_bits(length, rate);
+        symbol_bits += (long long)ppdu::data_symbol_count(length, rate) * RateParams(rate).dbps;
+        airtime += capacity.ppdu_airtime(length, rate);
+    }
+    pad_share = double(pad) / symbol_bits;
+    return airtime;
+}
+
+int main(int argc, char * argv[]){
+
+    if(argc > 1) sample_rate = atof(argv[1]);
+    if(argc > 2) mpdu_length = atoi(argv[2]);
+
+    link_capacity capacity(sample_rate, gap_samples);
+
+    printf("Sample rate %.1f MHz, symbol %.1f us, %d byte MPDUs, %d per aggregate\n",
+           sample_rate / 1e6, capacity.symbol_duration() * 1e6, mpdu_length,
+           link_capacity::mpdus_per_ppdu(mpdu_length));
+
+    for(int r = RATE_1_2_BPSK; r <= RATE_3_4_QAM64; r++)
+    {
+        Rate rate = Rate(r);
+        RateParams rate_params = RateParams(rate);
+        double peak = rate_params.dbps / capacity.symbol_duration();
+
+        printf("%-10s peak %6.2f Mbit/s  max PPDU %6.2f ms  one per PPDU %6.2f Mbit/s  aggregated %6.2f Mbit/s  video %6.2f Mbit/s\n",
+               rate_params.name.c_str(), peak / 1e6,
+               capacity.ppdu_airtime(MAX_FRAME_SIZE, rate) * 1e3,
+               capacity.payload_throughput(rate, mpdu_length, false) / 1e6,
+               capacity.payload_throughput(rate, mpdu_length, true) / 1e6,
+               capacity.video_bitrate(rate, mpdu_length) / 1e6);
+    }
+
+    printf("\nFragmenting a %d byte NAL unit, one fragment per PPDU, MTU %d\n", nal_length, mpdu_length);
+    for(int r = RATE_1_2_BPSK; r <= RATE_3_4_QAM64; r++)
+    {
+        Rate rate = Rate(r);
+        int aligned = link_capacity::aligned_length(mpdu_length, rate);
+
+        double fixed_share, aligned_share;
+        double fixed_time = fragment_nal(capacity, rate, mpdu_length, fixed_share);
+        double aligned_time = fragment_nal(capacity, rate, aligned, aligned_share);
+
+        printf("%-10s fixed %4d B pad %3d bits (%5.2f%%)  aligned %4d B pad %d bits (%5.2f%%)  air time %+5.2f%%\n",
+               RateParams(rate).name.c_str(), mpdu_length, link_capacity::padding_bits(mpdu_length, rate),
+               100.0 * fixed_share, aligned, link_capacity::padding_bits(aligned, rate),
+               100.0 * aligned_share, 100.0 * (aligned_time / fixed_time - 1));
+    }
+
+    return 0;
+}
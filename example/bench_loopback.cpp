@@ -0,0 +1,109 @@
+/*! \file bench_loopback.cpp
+ *  \brief Runs the full transmitter to receiver path through a loopback_radio.
+ *
+ *  This file connects a transmitter (asynchronous pipeline) and a receiver to the same
+ *  loopback_radio, so that every sample the transmitter sends goes through the rx_ring and
+ *  the receiver_chain without any hardware. For each PHY rate it reports how many frames
+ *  arrived, the goodput and how much faster than real time the system ran, and the latency
+ *  from transmitter::submit_frame() to the receiver callback.
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "loopback_radio.h"
+#include "transmitter.h"
+#include "receiver.h"
+
+using namespace fun;
+
+int payload_length = 1500;   //!< Bytes per packet
+int num_packets = 500;       //!< Packets per rate
+double sample_rate = 5e6;    //!< Sample rate used for the loopback timestamps and the real time factor
+
+std::vector<boost::posix_time::ptime> submit_times(num_packets);    //!< Submission time of each packet
+std::atomic<int> rx_count(0);                                       //!< Packets received for the current rate
+std::atomic<long long> latency_sum_us(0);                           //!< Sum of the latencies
+std::atomic<long long> latency_max_us(0);                           //!< Maximum latency
+
+/*!
+ * \brief The receiver callback. The first 4 bytes of every packet are its index.
+ */
+void on_packets(std::vector<std::vector<unsigned char> > packets)
+{
+    boost::posix_time::ptime now = boost::posix_time::microsec_clock::local_time();
+    for(int x = 0; x < packets.size(); x++)
+    {
+        if(packets[x].size() != payload_length) continue;
+        int index;
+        memcpy(&index, packets[x].data(), sizeof(index));
+        if(index < 0 || index >= num_packets) continue;
+
+        long long latency = (now - submit_times[index]).total_microseconds();
+        latency_sum_us += latency;
+        if(latency > latency_max_us) latency_max_us = latency;
+        rx_count++;
+    }
+}
+
+int main(int argc, char * argv[]){
+
+    std::cout << "Benchmarking the transmitter -> loopback_radio -> receiver path..." << std::endl;
+
+    std::shared_ptr<loopback_radio> radio = std::make_shared<loopback_radio>(sample_rate);
+    receiver rx(&on_packets, radio);
+    transmitter tx(radio);
+    tx.start_async();
+
+    std::vector<unsigned char> payload(payload_length);
+    for(int y = 0; y < payload_length; y++) payload[y] = rand();
+
+    // Zeros sent after each rate to push the last frames through the receiver chain, which
+    // moves the data one block along per rx_ring block
+    std::vector<std::complex<double> > zeros(RADIO_RX_BLOCK * 8);
+
+    for(int r = RATE_1_2_BPSK; r <= RATE_3_4_QAM64; r++)
+    {
+        Rate rate = Rate(r);
+        rx_count = 0;
+        latency_sum_us = 0;
+        latency_max_us = 0;
+        unsigned long long first_sample = radio->get_tx_samples();
+
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+        for(int x = 0; x < num_packets; x++)
+        {
+            memcpy(payload.data(), &x, sizeof(x));
+            submit_times[x] = boost::posix_time::microsec_clock::local_time();
+            tx.submit_frame(payload, rate);
+        }
+        tx.flush();
+        radio->send_burst(zeros);
+
+        // Wait until the receiver has caught up
+        while(radio->get_rx_ring()->num_blocks() > 0)
+        {
+            int count = rx_count;
+            usleep(50000);
+            if(count == rx_count) break;
+        }
+        boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::local_time() - start;
+
+        double seconds = elapsed.total_microseconds() / 1e6;
+        double air_seconds = (radio->get_tx_samples() - first_sample) / sample_rate;
+        int received = rx_count;
+        printf("%-10s received %4d/%d  goodput %7.2f Mbit/s  %5.1fx real time  latency mean %7.2f ms max %7.2f ms\n",
+               RateParams(rate).name.c_str(), received, num_packets,
+               8.0 * payload_length * received / seconds / 1e6, air_seconds / seconds,
+               received ? latency_sum_us / 1000.0 / received : 0.0, latency_max_us / 1000.0);
+    }
+
+    tx.stop_async();
+
+    rx_stats stats = rx.get_rx_stats();
+    printf("RX stream: %llu samples, %llu ring full, %llu timeouts\n", stats.samples, stats.ring_full, stats.timeouts);
+
+    return 0;
+}
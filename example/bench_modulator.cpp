@@ -0,0 +1,121 @@
+/*! \file bench_modulator.cpp
+ *  \brief Benchmarks the modulator against per-bit QAM encoding/decoding.
+ *
+ *  For every modulation this file maps and demaps a large block of random coded
+ *  bits with the modulator class (constellation tables and the vectorized demapper)
+ *  and with the original per-subcarrier QAM template loops, checks that both give
+ *  the same result and prints the throughput of each.
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "modulator.h"
+#include "qam.h"
+
+using namespace fun;
+
+void bench_modulation(Rate rate);
+
+int num_symbols = 20000;   //!< OFDM symbols per run
+int iterations = 10;       //!< Runs averaged for each measurement
+
+int main(int argc, char * argv[]){
+
+    std::cout << "Benchmarking modulator..." << std::endl;
+    bench_modulation(RATE_1_2_BPSK);
+    bench_modulation(RATE_1_2_QPSK);
+    bench_modulation(RATE_1_2_QAM16);
+    bench_modulation(RATE_2_3_QAM64);
+
+    return 0;
+}
+
+/*!
+ * \brief Reference mapper: per-bit QAM::encode() for each axis of each subcarrier.
+ */
+template<int NumBits>
+void qam_modulate(double power, bool real_only, const std::vector<unsigned char> & bits, std::vector<std::complex<double> > & out)
+{
+    QAM<NumBits> qam(power);
+    double * comp = reinterpret_cast<double *>(out.data());
+    if(real_only)
+        for(int x = 0; x < out.size(); x++) { qam.encode((const char *)&bits[x], &comp[x*2]); comp[x*2+1] = 0; }
+    else
+        for(int x = 0; x < out.size() * 2; x++) qam.encode((const char *)&bits[x*NumBits], &comp[x]);
+}
+
+/*!
+ * \brief Reference demapper: QAM::decode() for each axis of each subcarrier.
+ */
+template<int NumBits>
+void qam_demodulate(double power, bool real_only, const std::vector<std::complex<double> > & samples, std::vector<unsigned char> & bits)
+{
+    QAM<NumBits> qam(power);
+    for(int s = 0; s < samples.size(); s++)
+    {
+        qam.decode(samples[s].real(), &bits[s*NumBits*(real_only ? 1 : 2)]);
+        if(!real_only) qam.decode(samples[s].imag(), &bits[s*NumBits*2+NumBits]);
+    }
+}
+
+/*!
+ * \brief Runs the reference loops for the modulation used by rate.
+ */
+void reference(Rate rate, bool demod, std::vector<unsigned char> & bits, std::vector<std::complex<double> > & samples)
+{
+    switch(RateParams(rate).bpsc)
+    {
+        case 1: demod ? qam_demodulate<1>(1.0, true, samples, bits) : qam_modulate<1>(1.0, true, bits, samples); break;
+        case 2: demod ? qam_demodulate<1>(0.5, false, samples, bits) : qam_modulate<1>(0.5, false, bits, samples); break;
+        case 4: demod ? qam_demodulate<2>(0.5, false, samples, bits) : qam_modulate<2>(0.5, false, bits, samples); break;
+        case 6: demod ? qam_demodulate<3>(0.5, false, samples, bits) : qam_modulate<3>(0.5, false, bits, samples); break;
+    }
+}
+
+/*!
+ * \brief Times one function over #iterations runs.
+ * \return Mega subcarriers per second.
+ */
+template<typename F>
+double measure(int subcarriers, F f)
+{
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+    for(int i = 0; i < iterations; i++) f();
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::local_time() - start;
+    return double(subcarriers) * iterations / elapsed.total_microseconds();
+}
+
+/*!
+ * \brief Benchmarks mapping and demapping for one modulation.
+ * \param rate Any PHY rate using the modulation to be tested.
+ */
+void bench_modulation(Rate rate)
+{
+    RateParams rp(rate);
+    int subcarriers = num_symbols * 48;
+
+    std::vector<unsigned char> bits(subcarriers * rp.bpsc);
+    for(int x = 0; x < bits.size(); x++) bits[x] = rand() & 1;
+
+    std::vector<std::complex<double> > ref_samples(subcarriers), samples(subcarriers);
+    std::vector<unsigned char> ref_bits(bits.size()), soft_bits(bits.size());
+
+    double ref_map = measure(subcarriers, [&]{ reference(rate, false, bits, ref_samples); });
+    double map = measure(subcarriers, [&]{ modulator::modulate(bits.data(), bits.size(), rate, samples.data()); });
+
+    // Add some noise so that the soft bits are not all saturated
+    for(int x = 0; x < samples.size(); x++)
+        samples[x] += std::complex<double>(rand() / double(RAND_MAX) - 0.5, rand() / double(RAND_MAX) - 0.5) * 0.2;
+
+    double ref_demap = measure(subcarriers, [&]{ reference(rate, true, ref_bits, samples); });
+    double demap = measure(subcarriers, [&]{ modulator::demodulate(samples.data(), samples.size(), rate, soft_bits.data()); });
+
+    std::vector<std::complex<double> > check(subcarriers);
+    modulator::modulate(bits.data(), bits.size(), rate, check.data());
+    bool match = (check == ref_samples) && (soft_bits == ref_bits);
+
+    std::string name = rp.name.substr(rp.name.find(' ') + 1);
+    printf("%-6s map: %8.2f -> %8.2f Msc/s   demap: %8.2f -> %8.2f Msc/s   %s\n",
+           name.c_str(), ref_map, map, ref_demap, demap, match ? "match" : "MISMATCH");
+}
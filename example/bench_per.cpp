@@ -0,0 +1,152 @@
+/*! \file bench_per.cpp
+ *  \brief Packet error rate sweep over PHY rate and SNR through the channel_model.
+ *
+ *  For every PHY rate and SNR this file builds a stream of frames with the frame_builder,
+ *  passes it through a channel_model with the requested impairments and runs it through a
+ *  fresh receiver_chain the same way test_sim does. It prints one CSV line per point with
+ *  the packet error rate, the goodput, the receiver CPU time per packet and the mean of the
+ *  receiver's own SNR, EVM and CFO estimates over the detected frames. Payloads, noise
+ *  and multipath all come from --seed, so the same command gives the same PER.
+ *
+ *  Example: bench_per --snr-min 0 --snr-max 30 --cfo 2000 --delay-spread 1 > per.csv
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <cstring>
+#include <random>
+#include <ctime>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include "frame_builder.h"
+#include "receiver_chain.h"
+#include "channel_model.h"
+
+using namespace fun;
+namespace po = boost::program_options;
+
+double sample_rate = 5e6;   //!< Sample rate, the same as the usrp default
+int gap_samples = 400;      //!< Idle samples between frames
+int chunk_size = 4096;      //!< Samples handed to the receiver_chain per call
+
+/*!
+ * \brief CPU time of the whole process (all receiver_chain threads) in microseconds.
+ */
+double cpu_time_us()
+{
+    timespec t;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return t.tv_sec * 1e6 + t.tv_nsec / 1e3;
+}
+
+int main(int argc, char * argv[]){
+
+    int num_packets, payload_length, rate_min, rate_max;
+    double snr_min, snr_max, snr_step;
+    channel_params params;
+
+    po::options_description desc("Options");
+    desc.add_options()
+        ("help", "Print this message")
+        ("packets", po::value<int>(&num_packets)->default_value(200), "Packets per point")
+        ("length", po::value<int>(&payload_length)->default_value(1500), "Payload bytes per packet")
+        ("rate-min", po::value<int>(&rate_min)->default_value(RATE_1_2_BPSK), "First Rate (0 = 1/2 BPSK)")
+        ("rate-max", po::value<int>(&rate_max)->default_value(RATE_3_4_QAM64), "Last Rate (10 = 3/4 QAM64)")
+        ("snr-min", po::value<double>(&snr_min)->default_value(0), "First SNR in dB")
+        ("snr-max", po::value<double>(&snr_max)->default_value(30), "Last SNR in dB")
+        ("snr-step", po::value<double>(&snr_step)->default_value(2), "SNR step in dB")
+        ("cfo", po::value<double>(&params.cfo_hz)->default_value(0), "Carrier frequency offset in Hz")
+        ("sampling-offset", po::value<double>(&params.sampling_offset_ppm)->default_value(0), "Sample clock offset in ppm")
+        ("delay-spread", po::value<double>(&params.delay_spread)->default_value(0), "RMS delay spread in samples, 0 for flat")
+        ("phase-noise", po::value<double>(&params.phase_noise_hz)->default_value(0), "Phase noise linewidth in Hz")
+        ("iq-gain", po::value<double>(&params.iq_gain_db)->default_value(0), "IQ amplitude imbalance in dB")
+        ("iq-phase", po::value<double>(&params.iq_phase_deg)->default_value(0), "IQ phase imbalance in degrees")
+        ("seed", po::value<unsigned long long>(&params.seed)->default_value(1), "Seed for payloads, noise and multipath");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if(vm.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+
+    frame_builder fb;
+    std::mt19937_64 random(params.seed);
+
+    printf("rate,snr_db,packets,received,per,goodput_mbps,rx_cpu_us_per_packet,detected,est_snr_db,evm_db,cfo_hz\n");
+
+    for(int r = rate_min; r <= rate_max; r++)
+    {
+        Rate rate = Rate(r);
+
+        // Build the stream once per rate, the first 4 bytes of each payload are its index
+        std::vector<std::vector<unsigned char> > payloads(num_packets, std::vector<unsigned char>(payload_length));
+        std::vector<std::complex<double> > stream(gap_samples);
+        double signal_power = 0;
+        for(int x = 0; x < num_packets; x++)
+        {
+            for(int y = 0; y < payload_length; y++) payloads[x][y] = random();
+            memcpy(payloads[x].data(), &x, sizeof(x));
+
+            std::vector<std::complex<double> > frame = fb.build_frame(payloads[x], rate);
+            signal_power += channel_model::mean_power(frame.data(), frame.size()) / num_packets;
+            stream.insert(stream.end(), frame.begin(), frame.end());
+            stream.insert(stream.end(), gap_samples, 0);
+        }
+        // Each process_samples() call moves the data one block along the receiver chain, so
+        // a few chunks after the last frame push it through all of them
+        stream.insert(stream.end(), 8 * chunk_size, 0);
+        double air_time = num_packets * (frame_builder::frame_length(payload_length, rate) + gap_samples) / sample_rate;
+
+        for(double snr = snr_min; snr <= snr_max + 1e-9; snr += snr_step)
+        {
+            channel_params point = params;
+            point.snr_db = snr;
+            point.signal_power = signal_power;
+            channel_model channel(point, sample_rate);
+
+            receiver_chain chain;
+            std::vector<bool> seen(num_packets, false);
+            std::vector<std::complex<double> > impaired;
+            int received = 0, detected = 0;
+            double rx_cpu = 0, est_snr = 0, evm = 0, cfo = 0;
+
+            for(int x = 0; x < stream.size(); x += chunk_size)
+            {
+                int count = std::min(chunk_size, int(stream.size()) - x);
+                channel.apply(&stream[x], count, impaired);
+                if(impaired.size() <= CARRYOVER_LENGTH) continue;
+
+                double start = cpu_time_us();
+                std::vector<rx_frame> frames = chain.process_frames(impaired.data(), impaired.size());
+                rx_cpu += cpu_time_us() - start;
+
+                for(int f = 0; f < frames.size(); f++)
+                {
+                    detected++;
+                    est_snr += frames[f].snr_db;
+                    evm += frames[f].evm_db;
+                    cfo += frames[f].cfo * sample_rate;
+
+                    int index;
+                    const std::vector<unsigned char> & packet = frames[f].payload;
+                    if(!frames[f].crc_ok || packet.size() != payload_length) continue;
+                    memcpy(&index, packet.data(), sizeof(index));
+                    if(index < 0 || index >= num_packets || seen[index] || packet != payloads[index]) continue;
+                    seen[index] = true;
+                    received++;
+                }
+            }
+
+            int n = std::max(detected, 1);
+            printf("%s,%.1f,%d,%d,%.4f,%.3f,%.1f,%d,%.1f,%.1f,%.0f\n", RateParams(rate).name.c_str(), snr, num_packets, received,
+                   1.0 - double(received) / num_packets, 8.0 * payload_length * received / air_time / 1e6,
+                   rx_cpu / num_packets, detected, est_snr / n, evm / n, cfo / n);
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*! \file bench_sample_convert.cpp
+ *  \brief Benchmarks the host sample format conversions.
+ *
+ *  This file times the transmit side scale-and-convert and the receive side conversion
+ *  for each host format, one USRP_CONVERT_CHUNK at a time the way the usrp class does it,
+ *  and compares them with the scalar loops (the old copy-and-scale of send_burst_sync
+ *  for fc64).
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "sample_convert.h"
+#include "usrp.h"
+
+using namespace fun;
+
+int total_samples = 20000000; //!< Samples converted per measurement
+double amp = 0.5;             //!< Transmit amplitude
+
+/*!
+ * \brief Times one chunk conversion over #total_samples samples.
+ * \return Million samples per second.
+ */
+template<typename F>
+double measure(F f)
+{
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+    for(int i = 0; i < total_samples / USRP_CONVERT_CHUNK; i++) f();
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::local_time() - start;
+    return double(total_samples / USRP_CONVERT_CHUNK * USRP_CONVERT_CHUNK) / elapsed.total_microseconds();
+}
+
+int main(int argc, char * argv[]){
+
+    std::cout << "Benchmarking sample conversion..." << std::endl;
+    printf("AVX2: %s\n", sample_convert::simd_supported() ? "supported" : "not supported");
+
+    int n = USRP_CONVERT_CHUNK;
+    std::vector<std::complex<double> > samples(n), doubles(n);
+    std::vector<std::complex<float> > floats(n);
+    std::vector<std::complex<short> > shorts(n);
+    for(int x = 0; x < n; x++) samples[x] = std::complex<double>(rand() / double(RAND_MAX) - 0.5, rand() / double(RAND_MAX) - 0.5);
+
+    // Transmit side
+    double copy_scale = measure([&]{
+        std::vector<std::complex<double> > copy = samples;
+        for(int x = 0; x < n; x++) copy[x] *= amp;
+    });
+    double fc64 = measure([&]{ sample_convert::scale_fc64(samples.data(), n, amp, doubles.data()); });
+    double fc32_scalar = measure([&]{ for(int x = 0; x < n; x++) floats[x] = std::complex<float>(samples[x] * amp); });
+    double fc32 = measure([&]{ sample_convert::to_fc32(samples.data(), n, amp, floats.data()); });
+    double sc16_scalar = measure([&]{
+        for(int x = 0; x < n; x++)
+            shorts[x] = std::complex<short>(std::lrint(samples[x].real() * amp * SC16_SCALE), std::lrint(samples[x].imag() * amp * SC16_SCALE));
+    });
+    double sc16 = measure([&]{ sample_convert::to_sc16(samples.data(), n, amp, shorts.data()); });
+
+    printf("TX fc64 (16 B/sample): copy + scale %8.1f MS/s   fused scale %8.1f MS/s\n", copy_scale, fc64);
+    printf("TX fc32 ( 8 B/sample): scalar       %8.1f MS/s   SIMD        %8.1f MS/s\n", fc32_scalar, fc32);
+    printf("TX sc16 ( 4 B/sample): scalar       %8.1f MS/s   SIMD        %8.1f MS/s\n", sc16_scalar, sc16);
+
+    // Receive side
+    double rx_fc32_scalar = measure([&]{ for(int x = 0; x < n; x++) doubles[x] = std::complex<double>(floats[x]); });
+    double rx_fc32 = measure([&]{ sample_convert::from_fc32(floats.data(), n, doubles.data()); });
+    double rx_sc16_scalar = measure([&]{
+        for(int x = 0; x < n; x++) doubles[x] = std::complex<double>(shorts[x].real() / SC16_SCALE, shorts[x].imag() / SC16_SCALE);
+    });
+    double rx_sc16 = measure([&]{ sample_convert::from_sc16(shorts.data(), n, doubles.data()); });
+
+    printf("RX fc32:               scalar       %8.1f MS/s   SIMD        %8.1f MS/s\n", rx_fc32_scalar, rx_fc32);
+    printf("RX sc16:               scalar       %8.1f MS/s   SIMD        %8.1f MS/s\n", rx_sc16_scalar, rx_sc16);
+
+    return 0;
+}
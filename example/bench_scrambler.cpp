@@ -0,0 +1,80 @@
+/*! \file bench_scrambler.cpp
+ *  \brief Benchmarks the scrambler against the Viterbi decoder.
+ *
+ *  This file times scrambling a 1500 byte payload with the table driven scrambler and
+ *  with a bit-serial LFSR, and compares both with the time it takes to Viterbi decode
+ *  the same payload, which is the dominant cost of decoding a frame.
+ */
+
+#include <iostream>
+#include <cstdlib>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include "scrambler.h"
+#include "viterbi.h"
+
+using namespace fun;
+
+int payload_length = 1500; //!< Bytes per frame
+int iterations = 2000;     //!< Frames per measurement
+
+/*!
+ * \brief Bit-serial reference scrambler, one LFSR step per bit.
+ */
+void lfsr_scramble(unsigned char * data, int num_bytes, int seed)
+{
+    int state = seed;
+    for(int x = 0; x < num_bytes; x++)
+    {
+        for(int b = 7; b >= 0; b--)
+        {
+            int feedback = ((state >> 6) ^ (state >> 3)) & 1;
+            state = ((state << 1) & 0x7E) | feedback;
+            data[x] ^= feedback << b;
+        }
+    }
+}
+
+/*!
+ * \brief Times one function over #iterations frames.
+ * \return Microseconds per frame.
+ */
+template<typename F>
+double measure(F f)
+{
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+    for(int i = 0; i < iterations; i++) f();
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::local_time() - start;
+    return double(elapsed.total_microseconds()) / iterations;
+}
+
+int main(int argc, char * argv[]){
+
+    std::cout << "Benchmarking scrambler..." << std::endl;
+
+    int data_bits = (payload_length + 6) * 8;
+    std::vector<unsigned char> data(data_bits / 8 + 1);
+    for(int x = 0; x < data.size(); x++) data[x] = rand();
+    std::vector<unsigned char> reference = data;
+
+    // Check the table driven scrambler against the bit-serial one
+    scrambler::get().apply(data.data(), data.size());
+    lfsr_scramble(reference.data(), reference.size(), SCRAMBLER_DEFAULT_SEED);
+    bool match = data == reference;
+
+    std::vector<unsigned char> symbols(2 * (data_bits + 6));
+    std::vector<unsigned char> decoded(data.size());
+    viterbi v;
+    v.conv_encode(data.data(), symbols.data(), data_bits);
+    for(int x = 0; x < symbols.size(); x++) symbols[x] = symbols[x] ? 255 : 0;
+
+    double table_us = measure([&]{ scrambler::get().apply(data.data(), data.size()); });
+    double lfsr_us = measure([&]{ lfsr_scramble(data.data(), data.size(), SCRAMBLER_DEFAULT_SEED); });
+    double viterbi_us = measure([&]{ v.conv_decode(symbols.data(), decoded.data(), data_bits); });
+
+    printf("Payload: %d bytes (%s)\n", payload_length, match ? "match" : "MISMATCH");
+    printf("Bit-serial LFSR: %8.3f us/frame  (%5.2f%% of Viterbi)\n", lfsr_us, 100.0 * lfsr_us / viterbi_us);
+    printf("Table scrambler: %8.3f us/frame  (%5.2f%% of Viterbi)\n", table_us, 100.0 * table_us / viterbi_us);
+    printf("Viterbi decode:  %8.3f us/frame\n", viterbi_us);
+
+    return 0;
+}
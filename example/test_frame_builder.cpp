@@ -0,0 +1,65 @@
+/*! \file test_frame_builder.cpp
+ *  \brief Builds the longest frame at every PHY rate and decodes it again.
+ *
+ *  For each rate a MAX_FRAME_SIZE byte payload is built with frame_builder::build_frame(),
+ *  surrounded by a little noise and run through the receiver_chain in rx_ring sized blocks.
+ *  The test passes if every frame comes back with a good CRC and the same payload.
+ *  Run it under AddressSanitizer to check the frame_builder's workspaces as well.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <complex>
+#include "frame_builder.h"
+#include "ppdu.h"
+#include "receiver_chain.h"
+
+#define BLOCK_SAMPLES 4096  //!< Samples per call to the receiver_chain, like the receiver's rx_ring blocks
+
+using namespace fun;
+
+int main(int argc, char * argv[])
+{
+    frame_builder fb;
+    receiver_chain chain;
+    srand(1);
+
+    std::vector<unsigned char> payload(MAX_FRAME_SIZE);
+    for(int x = 0; x < payload.size(); x++) payload[x] = rand() & 0xFF;
+
+    bool ok = true;
+    for(int r = RATE_1_2_BPSK; r <= RATE_3_4_QAM64; r++)
+    {
+        Rate rate = Rate(r);
+        std::vector<std::complex<double> > frame = fb.build_frame(payload, rate);
+
+        // 帧前后各留一段噪声，最后几块让接收链的流水线把帧送到 frame_decoder
+        std::vector<std::complex<double> > samples(BLOCK_SAMPLES + frame.size() + 8 * BLOCK_SAMPLES);
+        for(int x = 0; x < samples.size(); x++)
+        {
+            samples[x] = std::complex<double>((rand() / (double)RAND_MAX - 0.5) * 1e-3,
+                                              (rand() / (double)RAND_MAX - 0.5) * 1e-3);
+        }
+        for(int x = 0; x < frame.size(); x++) samples[BLOCK_SAMPLES + x] += frame[x];
+
+        int good = 0;
+        for(int offset = 0; offset < samples.size(); offset += BLOCK_SAMPLES)
+        {
+            int count = std::min<int>(BLOCK_SAMPLES, samples.size() - offset);
+            if(count <= CARRYOVER_LENGTH) break;
+            std::vector<std::vector<unsigned char> > payloads = chain.process_samples(&samples[offset], count);
+            for(int p = 0; p < payloads.size(); p++)
+            {
+                if(payloads[p] == payload) good++;
+            }
+        }
+
+        bool passed = !frame.empty() && good == 1;
+        printf("%-10s %7zu samples  %s\n", RateParams(rate).name.c_str(), frame.size(), passed ? "ok" : "FAILED");
+        ok &= passed;
+    }
+
+    printf(ok ? "All rates passed\n" : "Some rates failed\n");
+    return ok ? 0 : 1;
+}
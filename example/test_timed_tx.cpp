@@ -0,0 +1,72 @@
+/*! \file test_timed_tx.cpp
+ *  \brief Timed transmission test
+ *
+ *  This file schedules frames into TDMA slots with transmitter::send_frame_at() on a
+ *  loopback_radio and checks, using the receive timestamps, that every frame starts at
+ *  exactly the sample its slot asked for. Slots that follow each other directly must not
+ *  have any idle samples in between, and a frame scheduled in the past must be reported late.
+ */
+
+#include <iostream>
+#include "loopback_radio.h"
+#include "transmitter.h"
+
+using namespace fun;
+
+double sample_rate = 5e6;   //!< Sample rate
+int num_slots = 20;         //!< Number of slots scheduled
+Rate phy_rate = RATE_1_2_QPSK;
+
+int main(int argc, char * argv[]){
+
+    std::cout << "Testing timed transmission on the loopback radio..." << std::endl;
+
+    std::shared_ptr<loopback_radio> radio = std::make_shared<loopback_radio>(sample_rate);
+    transmitter tx(radio);
+    frame_builder fb;
+
+    std::vector<unsigned char> payload(1000, 0x5A);
+    std::vector<std::complex<double> > frame = fb.build_frame(payload, phy_rate);
+    int slot_samples = frame_builder::frame_length(payload.size(), phy_rate);
+
+    // Slots 0..9 back to back starting at 1 ms, slots 10..19 with one slot of idle time in between
+    std::vector<double> slot_times(num_slots);
+    for(int x = 0; x < num_slots; x++)
+    {
+        long long start = radio->time_to_samples(1e-3) + (long long)x * slot_samples + (x >= 10 ? (x - 9) * slot_samples : 0);
+        slot_times[x] = radio->samples_to_time(start);
+        if(!tx.send_frame_at(payload, phy_rate, slot_times[x])) std::cout << "Slot " << x << " unexpectedly late" << std::endl;
+    }
+
+    // This one is in the past
+    bool late_sent = tx.send_frame_at(payload, phy_rate, slot_times[5]);
+    int late = radio->poll_late_bursts();
+
+    // Receive everything that was sent with its timestamp
+    long long total = radio->get_tx_samples();
+    std::vector<std::complex<double> > rx(total);
+    double rx_time;
+    bool has_time = radio->get_samples(total, rx, rx_time);
+
+    int good = 0;
+    long long idle = 0;
+    for(int x = 0; x < num_slots; x++)
+    {
+        long long start = radio->time_to_samples(slot_times[x]) - radio->time_to_samples(rx_time);
+        bool match = start >= 0 && start + slot_samples <= total;
+        for(int s = 0; match && s < slot_samples; s++) match = rx[start + s] == frame[s];
+        good += match;
+    }
+    for(long long s = radio->time_to_samples(slot_times[0]) - radio->time_to_samples(rx_time);
+        s < radio->time_to_samples(slot_times[9]) - radio->time_to_samples(rx_time) + slot_samples; s++)
+        idle += rx[s] == std::complex<double>(0, 0);
+
+    printf("Timestamped: %s, first sample at %.6f s\n", has_time ? "yes" : "no", rx_time);
+    printf("Frames at their slot: %d/%d\n", good, num_slots);
+    printf("Idle samples between back to back slots: %lld\n", idle);
+    printf("Late frame sent: %s, late bursts reported: %d\n", late_sent ? "yes" : "no", late);
+
+    bool pass = has_time && good == num_slots && idle == 0 && !late_sent && late == 1;
+    std::cout << (pass ? "PASS" : "FAIL") << std::endl;
+    return pass ? 0 : 1;
+}
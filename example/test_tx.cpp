@@ -70,13 +70,19 @@ void test_tx(double freq, double sample_rate, double tx_gain, double amp, Rate p
         memcpy(&packets[i][1400], &known_string[0], known_string.length());
     }
 
-    //Transmit all the packets
+    //Transmit all the packets back to back through the asynchronous pipeline
     std::string tx_phy_rate = RateParams(phy_rate).name;
+    tx.start_async();
     for(int i = 0; i < num_packets; i++)
     {
         std::cout << "Sending packet " << i + 1 << " of " << num_packets << " at " << tx_phy_rate << std::endl;
-        tx.send_frame(packets[i], phy_rate);
+        tx.submit_frame(packets[i], phy_rate);
     }
+    tx.flush();
+
+    tx_stats stats = tx.get_stats();
+    printf("Sent %llu frames in %llu bursts, %llu underflows, enqueue-to-air latency mean %.0f us max %.0f us\n",
+           stats.frames_sent, stats.bursts, stats.underflows, stats.mean_air_latency_us, stats.max_air_latency_us);
 
 }
 
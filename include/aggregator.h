@@ -0,0 +1,75 @@
+/*! \file aggregator.h
+ *  \brief Header file for the aggregator class.
+ *
+ *  The aggregator class packs several MPDUs into the payload of one PPDU and unpacks
+ *  them again on the receive side. Each MPDU becomes a subframe with its own delimiter
+ *  and IEEE CRC-32, so intact subframes can be recovered even when another part of the
+ *  PPDU was received in error.
+ */
+
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <vector>
+
+#define AGGREGATE_DELIMITER_SIZE 4       //!< Bytes in a subframe delimiter
+#define AGGREGATE_SIGNATURE 0x4E         //!< Last byte of every delimiter ('N')
+
+namespace fun
+{
+    /*!
+     * \brief The aggregator class
+     *
+     *  Subframe layout (similar to an 802.11n A-MPDU subframe):
+     *  - delimiter: 12 bit MPDU length (little endian, upper 4 bits reserved), CRC-8 of the
+     *    first two bytes, signature #AGGREGATE_SIGNATURE
+     *  - the MPDU
+     *  - IEEE CRC-32 of the MPDU
+     *  - 0 to 3 zero bytes so that the next delimiter starts on a 4 byte boundary
+     *    (the last subframe is not padded)
+     *
+     *  When a delimiter is corrupted the receiver steps forward 4 bytes at a time until it
+     *  finds the next valid delimiter, so one bad subframe does not take the rest with it.
+     *  Aggregated PPDUs are marked with #SERVICE_AGGREGATED in the SERVICE field.
+     */
+    class aggregator
+    {
+    public:
+
+        /*!
+         * \brief Gets the number of bytes a subframe occupies, including its padding.
+         * \param mpdu_length Length of the MPDU in bytes.
+         * \return Delimiter + MPDU + CRC-32 + padding to a multiple of 4 bytes.
+         */
+        static int subframe_length(int mpdu_length);
+
+        /*!
+         * \brief Packs as many MPDUs as fit into one aggregate.
+         * \param mpdus The MPDUs waiting to be sent.
+         * \param first Index of the first MPDU to pack.
+         * \param ampdu Output aggregate. Its capacity is reused.
+         * \param max_length Maximum aggregate length in bytes, at most MAX_FRAME_SIZE.
+         * \return The number of MPDUs packed starting at first. At least one is packed if it fits.
+         */
+        static int pack(const std::vector<std::vector<unsigned char> > & mpdus, int first,
+                        std::vector<unsigned char> & ampdu, int max_length);
+
+        /*!
+         * \brief Unpacks the intact subframes of an aggregate.
+         * \param ampdu The received aggregate (the PPDU payload).
+         * \param bad_subframes [Optional] Incremented for every subframe that failed its CRC-32
+         *  and for every corrupted delimiter that had to be skipped.
+         * \return The MPDUs whose CRC-32 matched, in order.
+         */
+        static std::vector<std::vector<unsigned char> > unpack(const std::vector<unsigned char> & ampdu, int * bad_subframes = nullptr);
+
+    private:
+
+        /*!
+         * \brief CRC-8 (x^8 + x^2 + x + 1) of the first two bytes of a delimiter.
+         */
+        static unsigned char delimiter_crc(const unsigned char * delimiter);
+    };
+}
+
+#endif // AGGREGATOR_H
@@ -48,6 +48,11 @@ namespace fun
         {
         }
 
+        /*!
+         * \brief Virtual destructor, the receiver_chain deletes its blocks.
+         */
+        virtual ~block_base() {}
+
         /*!
          * \brief The main work function.
          *
@@ -14,6 +14,7 @@
 
 #include "tagged_vector.h"
 #include "block.h"
+#include "rx_frame.h"
 
 namespace fun
 {
@@ -34,7 +35,11 @@ namespace fun
     public:
 
 
-        channel_est(); //!< Construct for Channel Estimate block.
+        /*!
+         * \brief Constructor for Channel Estimate block.
+         * \param frame_table optional frame measurements table to write the LTS SNR estimate to.
+         */
+        channel_est(frame_measurements * frame_table = nullptr);
 
         virtual void work(); //!< Signal Processing happens here.
 
@@ -58,6 +63,10 @@ namespace fun
          * or in other words the first symbol after the second LTS symbol.
          */
         bool m_frame_start;
+
+        frame_measurements * m_frame_table;         //!< Frame measurements table, may be null.
+        unsigned m_frame_id;                        //!< Id of the frame the current LTS belongs to.
+        std::complex<double> m_lts1[64];            //!< First LTS symbol, kept for the SNR estimate.
     };
 }
 
@@ -0,0 +1,123 @@
+/*! \file channel_model.h
+ *  \brief Header file for the channel_model class and the channel_params struct.
+ *
+ *  The channel_model class applies the impairments of a radio link to baseband samples:
+ *  multipath, sampling clock offset, carrier frequency offset, phase noise, additive white
+ *  Gaussian noise and IQ imbalance. It is used to measure the receiver without hardware.
+ */
+
+#ifndef CHANNEL_MODEL_H
+#define CHANNEL_MODEL_H
+
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <random>
+
+namespace fun
+{
+    /*!
+     * \brief channel_params struct holds the impairments applied by the channel_model.
+     *  The defaults leave the signal untouched.
+     */
+    struct channel_params
+    {
+        double snr_db;              //!< Signal to noise ratio in dB relative to #signal_power, HUGE_VAL for no noise
+        double signal_power;        //!< Mean power of the signal the SNR refers to
+        double cfo_hz;              //!< Carrier frequency offset in Hz
+        double sampling_offset_ppm; //!< Receiver sample clock error in ppm (positive: receiver clock is fast)
+        double delay_spread;        //!< RMS delay spread in samples of an exponential multipath profile, 0 for a flat channel
+        double phase_noise_hz;      //!< 3 dB linewidth of the oscillator phase noise (Wiener model) in Hz
+        double iq_gain_db;          //!< Receiver IQ amplitude imbalance in dB
+        double iq_phase_deg;        //!< Receiver IQ phase imbalance in degrees
+        unsigned long long seed;    //!< Seed for the noise, the phase noise and the multipath taps
+
+        /*!
+         * \brief channel_params 的构造函数。只需初始化成员字段。
+         */
+        channel_params(double snr_db = HUGE_VAL, double signal_power = 1.0, double cfo_hz = 0, double sampling_offset_ppm = 0,
+                       double delay_spread = 0, double phase_noise_hz = 0, double iq_gain_db = 0, double iq_phase_deg = 0,
+                       unsigned long long seed = 1) :
+            snr_db(snr_db),
+            signal_power(signal_power),
+            cfo_hz(cfo_hz),
+            sampling_offset_ppm(sampling_offset_ppm),
+            delay_spread(delay_spread),
+            phase_noise_hz(phase_noise_hz),
+            iq_gain_db(iq_gain_db),
+            iq_phase_deg(iq_phase_deg),
+            seed(seed)
+        {
+        }
+    };
+
+    /*!
+     * \brief The channel_model class
+     *
+     *  The impairments are applied in the order a real link applies them: multipath, sampling
+     *  clock offset, carrier frequency offset and phase noise, noise, and finally the receiver's
+     *  IQ imbalance. The model keeps its state between calls to #apply(), so a stream can be fed
+     *  in chunks of any size. The output is the same for the same seed and input.
+     */
+    class channel_model
+    {
+    public:
+
+        /*!
+         * \brief Constructor for channel_model.
+         * \param params The impairments.
+         * \param sample_rate Sample rate in Hz, used for the CFO and the phase noise.
+         */
+        channel_model(channel_params params, double sample_rate);
+
+        /*!
+         * \brief Passes samples through the channel.
+         * \param in Input samples.
+         * \param count Number of input samples.
+         * \param out Output samples. With a sampling offset the number of output samples drifts
+         *  away from count, otherwise it is count.
+         */
+        void apply(const std::complex<double> * in, int count, std::vector<std::complex<double> > & out);
+
+        const std::vector<std::complex<double> > & get_taps() const { return m_taps; } //!< Get the multipath taps
+
+        /*!
+         * \brief Mean power of some samples, for channel_params::signal_power.
+         */
+        static double mean_power(const std::complex<double> * samples, int count);
+
+    private:
+
+        /*!
+         * \brief Complex Gaussian sample with unit power (Box-Muller, so it does not depend on the standard library).
+         */
+        std::complex<double> gaussian();
+
+        /*!
+         * \brief Resamples m_pending by the sampling offset into out.
+         */
+        void resample(std::vector<std::complex<double> > & out);
+
+        channel_params m_params;                        //!< The impairments
+        double m_sample_rate;                           //!< Sample rate
+        std::mt19937_64 m_random;                       //!< Random number generator
+
+        std::vector<std::complex<double> > m_taps;      //!< Multipath taps, normalized to unit power
+        std::vector<std::complex<double> > m_history;   //!< Last m_taps.size() - 1 input samples
+
+        std::vector<std::complex<double> > m_pending;   //!< Resampler input not consumed yet
+        std::vector<std::complex<double> > m_filtered;  //!< Output of the multipath stage
+        double m_position;                              //!< Resampler position in m_pending
+        double m_step;                                  //!< Input samples per output sample
+        std::vector<double> m_interpolator;             //!< Windowed sinc table, see resample()
+
+        double m_phase;                                 //!< CFO + phase noise phase in radians
+        double m_phase_step;                            //!< CFO phase step per sample
+        double m_phase_noise_std;                       //!< Phase noise step standard deviation
+        double m_noise_std;                             //!< Noise amplitude (complex, unit power scaled)
+        std::complex<double> m_iq_direct;               //!< IQ imbalance gain on the signal
+        std::complex<double> m_iq_image;                //!< IQ imbalance gain on the image (conjugate)
+    };
+}
+
+#endif // CHANNEL_MODEL_H
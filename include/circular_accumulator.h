@@ -93,6 +93,16 @@ namespace fun
             samples[index++] = sample;
             if(index >= size) index = 0;
         }
+
+        /*!
+         * \brief Empties the accumulator, the same state as after construction.
+         */
+        void clear()
+        {
+            for(int x = 0; x < size; x++) samples[x] = T(0);
+            sum = T(0);
+            index = 0;
+        }
     };
 
 }
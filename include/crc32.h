@@ -0,0 +1,82 @@
+/*! \file crc32.h
+ *  \brief Header file for the crc32 class.
+ *
+ *  The crc32 class computes the IEEE CRC-32 appended to every PPDU payload. It gives
+ *  the same checksum as boost::crc_32_type but processes 16 bytes per step, either
+ *  with carry-less multiplication (PCLMULQDQ) folding or with slicing-by-16 tables.
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <cstddef>
+
+namespace fun
+{
+    /*!
+     * \brief The crc32 class
+     *
+     *  Drop-in replacement for boost::crc_32_type (reflected polynomial 0x04C11DB7,
+     *  initial value and final XOR 0xFFFFFFFF). The checksum can be updated incrementally
+     *  with #process_bytes() so that a decoder can check the CRC while the payload is
+     *  still coming out of the Viterbi traceback.
+     *
+     *  The engine is chosen at runtime: PCLMULQDQ folding is used for runs of 64 bytes or more
+     *  when the CPU supports it, slicing-by-16 handles shorter runs and older CPUs.
+     */
+    class crc32
+    {
+    public:
+
+        /*!
+         * \brief The engines that can compute the CRC.
+         */
+        enum engine
+        {
+            AUTO,           //!< Use the fastest engine the CPU supports
+            SLICING_BY_16,  //!< Portable table driven engine, 16 bytes per step
+            PCLMUL,         //!< Carry-less multiplication folding, 64 bytes per step
+        };
+
+        /*!
+         * \brief Constructor for crc32.
+         * \param e [Optional] The engine to use. Falls back to #SLICING_BY_16 if #PCLMUL
+         *  is requested on a CPU without it. Defaults to #AUTO.
+         */
+        crc32(engine e = AUTO);
+
+        /*!
+         * \brief Restarts the checksum.
+         */
+        void reset();
+
+        /*!
+         * \brief Adds bytes to the checksum.
+         * \param data The bytes to add.
+         * \param length Number of bytes to add.
+         */
+        void process_bytes(const void * data, size_t length);
+
+        /*!
+         * \brief Gets the checksum of all the bytes processed so far.
+         * \return The CRC-32, identical to boost::crc_32_type::checksum().
+         */
+        unsigned int checksum() const { return ~m_register; }
+
+        engine get_engine() const { return m_engine; } //!< Get the engine in use
+
+        /*!
+         * \brief Checks whether the CPU supports the #PCLMUL engine.
+         * \return true if PCLMULQDQ and SSE4.1 are available.
+         */
+        static bool pclmul_supported();
+
+    private:
+
+        unsigned int m_register; //!< CRC register before the final XOR
+
+        engine m_engine;         //!< The engine in use, never #AUTO
+    };
+}
+
+#endif // CRC32_H
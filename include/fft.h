@@ -29,6 +29,15 @@ namespace fun
 
       /*!*/
               fft(int fft_length);
+
+              /*!
+              * \brief 析构函数，销毁 FFTW 方案并释放缓冲区。
+              */
+              ~fft();
+
+              fft(const fft &) = delete;
+              fft & operator=(const fft &) = delete;
+
               /*
               * \brief 就地执行 64 点正向 FFT  
               * \param `data` 包含 64 个时域复样本的数组，将其转换为频域样本。
@@ -41,6 +50,18 @@ namespace fun
               */
         void inverse(std::vector<std::complex<double> > & data);
 
+              /*!
+              * \brief 批量逆 FFT，直接输出带循环前缀的时域符号（不缩放）
+              * \param data 频域符号，每个符号 #m_fft_length 个样本，已按 FFTW 顺序排列（DC 在索引 0）
+              * \param num_symbols 符号数量
+              * \param out 输出缓冲区，每个符号占 #m_fft_length * 5 / 4 个样本（前 1/4 为循环前缀）
+              *
+              *  与 #inverse() 不同，输出不除以 #m_fft_length，需要的话应预先缩放输入。
+              */
+        void inverse_prefixed(const std::complex<double> * data, int num_symbols, std::complex<double> * out);
+
+        static const int INVERSE_BATCH = 8; //!< Number of symbols transformed by one call of the batched plan
+
     private:
 
         /*!
@@ -82,6 +103,16 @@ namespace fun
          * \brief 用于 `fftw3` 库的逆向 FFT 方案。
          */
         fftw_plan m_fftw_plan_inverse;
+
+        /*!
+         * \brief 用于 #inverse_prefixed 的批量逆向 FFT 方案，一次处理 #INVERSE_BATCH 个符号。
+         */
+        fftw_plan m_fftw_plan_inverse_batch;
+
+        /*!
+         * \brief 用于 #inverse_prefixed 剩余符号的单符号逆向 FFT 方案。
+         */
+        fftw_plan m_fftw_plan_inverse_single;
     };
 }
 
@@ -0,0 +1,85 @@
+/*! \file file_radio.h
+ *  \brief Header file for the file_radio class.
+ *
+ *  The file_radio class is a radio that reads received samples from a file and writes
+ *  transmitted samples to a file, so that recordings can be replayed through the receiver
+ *  and frames can be generated without a USRP attached.
+ */
+
+#ifndef FILE_RADIO_H
+#define FILE_RADIO_H
+
+#include <cstdio>
+#include <string>
+
+#include "radio.h"
+
+namespace fun
+{
+    /*!
+     * \brief The file_radio class
+     *
+     *  Both files hold interleaved fc32 samples (the format written by UHD's rx_samples_to_file
+     *  and read by tx_samples_from_file). Samples are read and written as fast as possible, there
+     *  is no pacing to the sample rate. The timestamp of a received sample is its index in the
+     *  source file divided by the sample rate, the device time on the TX side is the number of
+     *  samples written divided by the sample rate.
+     */
+    class file_radio : public radio
+    {
+    public:
+
+        /*!
+         * \brief Constructor for file_radio.
+         * \param source [Optional] File to receive from, "" for none (receiving then always times out).
+         * \param sink [Optional] File to transmit to, truncated on open, "" to discard transmitted samples.
+         * \param rate [Optional] Sample rate, only used for timestamps. Defaults to 5e6.
+         * \param tx_amp [Optional] Transmit amplitude applied to the written samples. Defaults to 1.0.
+         * \param loop [Optional] Start again from the beginning of the source at end of file.
+         */
+        file_radio(std::string source = "", std::string sink = "", double rate = 5e6, double tx_amp = 1.0, bool loop = false);
+
+        /*!
+         * \brief Destructor, stops the RX stream and closes the files.
+         */
+        ~file_radio();
+
+        /*!
+         * \brief Writes the samples, scaled by tx_amp, to the sink.
+         */
+        void send_samples(const std::complex<double> * samples, int num_samples, bool start_of_burst, bool end_of_burst) override;
+
+        bool realtime() const override { return false; }          //!< Never loses samples, see radio::realtime()
+        double get_rate() const override { return m_rate; }       //!< Get the sample rate
+        double get_tx_amp() const override { return m_tx_amp; }   //!< Get the transmit amplitude
+
+        /*!
+         * \brief Gets the device time, the number of samples written so far divided by the sample rate.
+         */
+        double get_time_now() override { return samples_to_time(m_tx_index); }
+
+        bool source_open() const { return m_source != nullptr; }  //!< Whether the source file could be opened
+        bool sink_open() const { return m_sink != nullptr; }      //!< Whether the sink file could be opened
+
+    protected:
+
+        /*!
+         * \brief Reads up to num_samples samples from the source. Counts a timeout at end of file.
+         */
+        int receive(int num_samples, std::complex<double> * buffer, bool & has_time, double & time) override;
+
+    private:
+
+        FILE * m_source;                                //!< Source file, nullptr if none
+        FILE * m_sink;                                  //!< Sink file, nullptr if none
+        double m_rate;                                  //!< Sample rate
+        double m_tx_amp;                                //!< Transmit amplitude
+        bool m_loop;                                    //!< Whether to loop the source
+        unsigned long long m_rx_index;                  //!< Index of the next sample read from the source
+        unsigned long long m_tx_index;                  //!< Number of samples sent so far
+        std::vector<std::complex<float> > m_tx_buffer;  //!< fc32 conversion buffer
+        std::vector<std::complex<float> > m_rx_buffer;  //!< fc32 conversion buffer
+    };
+}
+
+#endif // FILE_RADIO_H
@@ -13,6 +13,7 @@
 
 #include "fft.h"
 #include "rates.h"
+#include "symbol_mapper.h"
 
 namespace fun
 {
@@ -51,15 +52,67 @@ namespace fun
          * \brief Main function for building a PHY frame
          * \param payload (MPDU) the data that needs to be transmitted over the air.
          * \param rate the PHY transmission rate at which to transmit the respective data at.
+         * \param service [Optional] SERVICE field, e.g. #SERVICE_AGGREGATED.
          * \return A vector of complex doubles representing the digital base-band time domain signal
-         *  to be passed to the usrp class for up-conversion and transmission over the air.
+         *  to be passed to the usrp class for up-conversion and transmission over the air, or an
+         *  empty vector if the payload is longer than MAX_FRAME_SIZE.
          */
-        std::vector<std::complex<double> >  build_frame(std::vector<unsigned char> payload, Rate rate);
+        std::vector<std::complex<double> >  build_frame(const std::vector<unsigned char> & payload, Rate rate, unsigned short service = 0);
+
+        /*!
+         * \brief Builds a PHY frame straight into a caller provided buffer without allocating.
+         * \param payload (MPDU) the data that needs to be transmitted over the air.
+         * \param length Length of the payload in bytes, at most MAX_FRAME_SIZE.
+         * \param rate the PHY transmission rate at which to transmit the respective data at.
+         * \param frame Output buffer for the time domain samples.
+         * \param capacity Number of samples that fit in frame.
+         * \param service [Optional] SERVICE field, e.g. #SERVICE_AGGREGATED for a payload built by aggregator::pack().
+         * \return The number of samples written, which is #frame_length(length, rate), or 0 if the
+         *  payload is too long or the frame does not fit in capacity.
+         *
+         *  The preamble, the cyclic prefixed SIGNAL symbol and the data symbols are written in place.
+         *  All intermediate buffers belong to this frame_builder and are reused from frame to frame,
+         *  so one frame_builder must not be used by more than one thread at a time.
+         */
+        int build_frame_into(const unsigned char * payload, int length, Rate rate, std::complex<double> * frame, int capacity,
+                             unsigned short service = 0);
+
+        /*!
+         * \brief Same as #build_frame_into() but the payload is given in two parts.
+         * \param header The first part of the payload (e.g. an RTP header).
+         * \param header_length Length of the first part in bytes.
+         * \param body The rest of the payload, read in place.
+         * \param body_length Length of the rest in bytes. The two lengths add up to at most MAX_FRAME_SIZE.
+         *
+         *  See ppdu::encode_data_bits(). The other parameters and the return value are the same.
+         */
+        int build_frame_into(const unsigned char * header, int header_length, const unsigned char * body, int body_length,
+                             Rate rate, std::complex<double> * frame, int capacity, unsigned short service = 0);
+
+        /*!
+         * \brief Gets the number of samples in a frame.
+         * \param length Length of the payload in bytes.
+         * \param rate The PHY transmission rate.
+         * \return The number of time domain samples, including the preamble.
+         */
+        static int frame_length(int length, Rate rate);
 
     private:
 
         fft m_ifft; //!< The fft instance used to perform the inverse FFT on the OFDM symbols
 
+        symbol_mapper m_mapper; //!< Maps the data and pilots onto the subcarriers
+
+        std::vector<unsigned char> m_data; //!< Workspace for the service, payload, CRC and pad bytes
+
+        std::vector<unsigned char> m_coded; //!< Workspace for the rate 1/2 coded bits
+
+        std::vector<unsigned char> m_bits; //!< Workspace for the interleaved bits, SIGNAL symbol first
+
+        std::vector<std::complex<double> > m_points; //!< Workspace for the scaled constellation points
+
+        std::vector<std::complex<double> > m_symbols; //!< Workspace for the frequency domain symbols in IFFT order
+
     };
 }
 
@@ -18,6 +18,7 @@
 #include "tagged_vector.h"
 #include "rates.h"
 #include "block.h"
+#include "rx_frame.h"
 
 namespace fun
 {
@@ -68,7 +69,7 @@ namespace fun
      * \brief The frame_decoder block.
      *
      * Inputs tagged_vector<48> from phase_tracker block.
-     * Outputs std::vector<unsigned char> back to the receiver chain
+     * Outputs rx_frame back to the receiver chain
      *
      * The Frame Decoder block is in charge of decoding the frame header and then the frame body.
      * This includes demodulating, deinterleaving, de-convolutional-coding, and descrambling.
@@ -76,19 +77,40 @@ namespace fun
      * the payload, then the payload must be decoded as well. If the block is succesful in
      * decoding the frame as determined by an IEEE CRC-32 check the payload is passed into
      * the output_buffer as unsigned char's or bytes.
+     *
+     * Frames that fail the header or CRC check are passed on as well, without a payload,
+     * so that the frame's metadata is not lost.
      */
-    class frame_decoder : public fun::block<tagged_vector<48>, std::vector<unsigned char> >
+    class frame_decoder : public fun::block<tagged_vector<48>, rx_frame>
     {
     public:
 
-        frame_decoder(); //!< Constructor for frame_decoder block.
+        /*!
+         * \brief Constructor for frame_decoder block.
+         * \param frame_table [Optional] Table to read the measurements of the earlier blocks from.
+         */
+        frame_decoder(frame_measurements * frame_table = nullptr);
 
         virtual void work(); //!< Signal processing happens here.
 
     private:
 
+        /*!
+         * \brief Fills in the metadata of the current frame from the frame measurements
+         *  table and the pilot statistics collected over its symbols.
+         * \param frame the rx_frame to fill in
+         */
+        void fill_metadata(rx_frame & frame);
+
         FrameData m_current_frame; //!< Current frame that is being decoded.
 
+        frame_measurements * m_frame_table; //!< Table of frame measurements, may be nullptr
+        unsigned m_frame_id;                //!< Id of the current frame
+        int m_num_symbols;                  //!< Number of DATA symbols in the current frame
+        double m_pilot_phase_acc;           //!< Sum of the squared pilot phase errors of the current frame
+        double m_pilot_error_acc;           //!< Sum of the pilot error powers of the current frame
+        int m_pilot_symbols;                //!< Number of symbols in the above sums
+
     };
 
 }
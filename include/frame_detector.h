@@ -18,6 +18,7 @@
 
 #include "block.h"
 #include "tagged_vector.h"
+#include "rx_frame.h"
 #include "circular_accumulator.h"
 
 namespace fun
@@ -35,10 +36,28 @@ namespace fun
     {
     public:
 
-        frame_detector(); //!< Constructor for frame_detector block.
+        /*!
+         * \brief Constructor for frame_detector block.
+         * \param frame_table [Optional] Table to start the frame_measurements of each detected frame in.
+         */
+        frame_detector(frame_measurements * frame_table = nullptr);
 
         virtual void work(); //!< Signal processing happens here.
 
+        /*!
+         * \brief Makes the next call to #work() read the samples straight from the caller's buffer
+         *  (e.g. an rx_view) instead of #input_buffer. The buffer must stay valid until #work() returns.
+         * \param samples The received samples.
+         * \param count Number of samples, at least #STS_LENGTH.
+         */
+        void set_input(const std::complex<double> * samples, int count);
+
+        /*!
+         * \brief Forgets the samples before a gap in the sample stream: clears the carryover,
+         *  the accumulators and the plateau so that no STS is detected across the gap.
+         */
+        void reset();
+
     private:
 
         /*!
@@ -67,6 +86,12 @@ namespace fun
          * and carrying them over to the next call to #work()
          */
         std::vector<std::complex<double> > m_carryover;
+
+        frame_measurements * m_frame_table; //!< Table of frame measurements, may be nullptr
+        unsigned m_frame_id;                //!< Id of the last detected frame
+
+        const std::complex<double> * m_input;   //!< Caller's buffer for the next #work(), nullptr to use #input_buffer
+        int m_input_count;                      //!< Number of samples in #m_input
     };
 }
 
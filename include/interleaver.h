@@ -20,6 +20,20 @@
 namespace fun
 {
 
+    /*!
+     * \brief The interleave_map struct
+     *
+     * Permutation of one OFDM symbol worth of coded bits for a given PHY Rate.
+     * Bit k of the symbol is sent at position #forward[k] and received position k
+     * belongs at position #inverse[k] after deinterleaving.
+     */
+    struct interleave_map
+    {
+        const unsigned short * forward; //!< Interleaving permutation
+        const unsigned short * inverse; //!< Deinterleaving permutation
+        int cbps;                       //!< Coded bits per symbol, the length of both permutations
+    };
+
     /*!
      * \brief The interleaver class
      *
@@ -27,6 +41,9 @@ namespace fun
      * the 802.11a-1999 standard. The Interleaver class contains two static functions:
      * interleave and deinterleave and thus doesn't need a constructor. However, it does
      * use the BitInterleave struct as a helper for these two functions.
+     *
+     * The permutations depend on the coded bits per symbol and bits per subcarrier of the
+     * PHY Rate and are built at compile time for each of the four modulations.
      */
     class interleaver
     {
@@ -35,16 +52,25 @@ namespace fun
         /*!
          * \brief interleaves the data
          * \param data Vector of data to be interleaved
+         * \param rate [Optional] PHY Rate of the data - defaults to 1/2 BPSK (the SIGNAL symbol)
          * \return Vector of interleaved data
          */
-        static std::vector<unsigned char> interleave(std::vector<unsigned char> data);
+        static std::vector<unsigned char> interleave(const std::vector<unsigned char> & data, Rate rate = RATE_1_2_BPSK);
 
         /*!
          * \brief deinterleaves the data
          * \param data Vector of data to be deinterleaved
+         * \param rate [Optional] PHY Rate of the data - defaults to 1/2 BPSK (the SIGNAL symbol)
          * \return Vector of deinterleaved data
          */
-        static std::vector<unsigned char> deinterleave(std::vector<unsigned char> data);
+        static std::vector<unsigned char> deinterleave(const std::vector<unsigned char> & data, Rate rate = RATE_1_2_BPSK);
+
+        /*!
+         * \brief Gets the precomputed permutations for a PHY Rate.
+         * \param rate PHY Rate whose cbps and bpsc select the permutation.
+         * \return The interleave_map for that rate.
+         */
+        static interleave_map get_map(Rate rate);
 
     };
 
@@ -58,16 +84,16 @@ namespace fun
         unsigned int d_cbps; // coded bits per symbol
         static const int d_num_chunks = 16;
 
-        BitInterleave(int ncarriers, int nbits) :
+        constexpr BitInterleave(int ncarriers, int nbits) :
             d_bpsc(nbits),
             d_cbps(nbits * ncarriers)
         {}
 
-        unsigned int index(unsigned int k)
+        constexpr unsigned int index(unsigned int k) const
         {
             // see 17.3.5.6 in 802.11a-1999, floor is implicit
             assert (k < d_cbps);
-            unsigned int s = std::max(d_bpsc / 2, (unsigned int)1);
+            unsigned int s = d_bpsc / 2 > 1 ? d_bpsc / 2 : 1;
             unsigned int i = (d_cbps / d_num_chunks) * (k % d_num_chunks) + (k / d_num_chunks);
             unsigned int j = s * (i / s) + (i + d_cbps - (d_num_chunks * i / d_cbps)) % s;
             assert (j < d_cbps);
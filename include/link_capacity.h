@@ -0,0 +1,105 @@
+/*! \file link_capacity.h
+ *  \brief Header file for the link_capacity class.
+ *
+ *  link_capacity 根据 PHY 速率估算链路能承载的有效载荷吞吐量：每个数据符号的 dbps、
+ *  符号时长（由采样率决定），以及每个 PPDU 的开销（前导码、SIGNAL 符号、SERVICE/tail/CRC、
+ *  最后一个符号的填充、帧间隔）。视频发送端用它把编码器码率设置到空口实际能送出的水平。
+ */
+
+#ifndef LINK_CAPACITY_H
+#define LINK_CAPACITY_H
+
+#include "rates.h"
+
+namespace fun
+{
+    /*!
+     * \brief The link_capacity class
+     *
+     *  所有时长都按采样点计算后除以采样率：每个 OFDM 符号 80 个采样点（64 点 FFT + 16 点循环前缀），
+     *  20 MHz 时为 4 us，默认的 5 MHz 时为 16 us。
+     *  MPDU 可以一个 PPDU 发送一个，也可以按 #aggregator 的格式聚合到 MAX_FRAME_SIZE 字节。
+     */
+    class link_capacity
+    {
+    public:
+
+        /*!
+         * \brief Constructor for link_capacity.
+         * \param samp_rate [Optional] Sample rate in Hz, same as the transmitter's.
+         * \param gap_samples [Optional] Idle samples after each PPDU, same as transmitter::start_async().
+         */
+        link_capacity(double samp_rate = 5e6, int gap_samples = 80);
+
+        /*!
+         * \brief Gets the duration of one OFDM symbol including its cyclic prefix.
+         * \return Symbol duration in seconds.
+         */
+        double symbol_duration() const;
+
+        /*!
+         * \brief Gets the air time of one PPDU.
+         * \param length PPDU payload length in bytes.
+         * \param rate PHY rate of the payload.
+         * \return Preamble, SIGNAL symbol, data symbols and the gap after the PPDU, in seconds.
+         */
+        double ppdu_airtime(int length, Rate rate) const;
+
+        /*!
+         * \brief Gets the pad bits added to fill the last data symbol of a PPDU.
+         * \param length PPDU payload length in bytes.
+         * \param rate PHY rate of the payload.
+         * \return Bits between the tail and the end of the last symbol, 0 to dbps - 1.
+         */
+        static int padding_bits(int length, Rate rate);
+
+        /*!
+         * \brief Gets the largest packet that fills a whole number of data symbols.
+         * \param max_length Upper bound for the packet in bytes, e.g. the RTP MTU.
+         * \param rate PHY rate of the payload.
+         * \param extra_length [Optional] Bytes the PPDU payload carries besides the packet.
+         * \return The packet length in bytes, at most max_length, leaving less than one byte of padding.
+         *
+         *  SERVICE, tail and CRC add 54 bits, which is never a multiple of 8 away from a symbol
+         *  boundary, so at least 2 pad bits remain at every rate.
+         */
+        static int aligned_length(int max_length, Rate rate, int extra_length = 0);
+
+        /*!
+         * \brief Gets the number of MPDUs of one length that fit in an aggregate.
+         * \param mpdu_length Length of each MPDU in bytes.
+         * \return At least 1 as long as one subframe fits in MAX_FRAME_SIZE, otherwise 0.
+         */
+        static int mpdus_per_ppdu(int mpdu_length);
+
+        /*!
+         * \brief Gets the MPDU throughput for back to back PPDUs.
+         * \param rate PHY rate.
+         * \param mpdu_length Length of each MPDU in bytes, e.g. one RTP packet.
+         * \param aggregate [Optional] Whether MPDUs are aggregated (as transmitter::submit_aggregate()).
+         *  Defaults to one MPDU per PPDU, which is how the TransmitSink path sends.
+         * \return Bits of MPDU per second. Delimiters, subframe CRCs and padding are not counted.
+         */
+        double payload_throughput(Rate rate, int mpdu_length, bool aggregate = false) const;
+
+        /*!
+         * \brief Gets the encoder bitrate the link can carry.
+         * \param rate PHY rate.
+         * \param mpdu_length Length of each MPDU in bytes.
+         * \param header_length [Optional] Bytes of each MPDU that are not video, e.g. 12 for the RTP header.
+         * \param headroom [Optional] Fraction of the throughput given to the encoder. The rest absorbs
+         *  the encoder's short term overshoot and retransmissions.
+         * \param aggregate [Optional] Whether MPDUs are aggregated, see #payload_throughput().
+         * \return Encoder bitrate in bit/s.
+         */
+        double video_bitrate(Rate rate, int mpdu_length, int header_length = 12, double headroom = 0.8,
+                             bool aggregate = false) const;
+
+    private:
+
+        double m_samp_rate;  //!< Sample rate in Hz
+        int m_gap_samples;   //!< Idle samples after each PPDU
+    };
+}
+
+#endif // LINK_CAPACITY_H
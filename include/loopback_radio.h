@@ -0,0 +1,91 @@
+/*! \file loopback_radio.h
+ *  \brief Header file for the loopback_radio class.
+ *
+ *  The loopback_radio class is an in-process radio whose receiver gets exactly the samples its
+ *  transmitter sent. Sharing one loopback_radio between a transmitter and a receiver runs the
+ *  whole TX to RX path in one process as fast as the CPU allows.
+ */
+
+#ifndef LOOPBACK_RADIO_H
+#define LOOPBACK_RADIO_H
+
+#include <mutex>
+#include <condition_variable>
+
+#include "radio.h"
+
+namespace fun
+{
+    /*!
+     * \brief The loopback_radio class
+     *
+     *  Transmitted samples, scaled by tx_amp, go into a sample FIFO and are received from it in
+     *  the same order. The device clock is the number of samples that have passed through the
+     *  loopback, so the timestamp of a received sample is its index in the stream divided by the
+     *  sample rate and matches the position at which it was sent.
+     *
+     *  Sending blocks while the FIFO is full, the way a real radio only takes samples as fast as
+     *  it can transmit them, so a slow receiver slows the transmitter down rather than losing
+     *  samples. Receiving waits up to 100 ms for the requested number of samples and counts a
+     *  timeout otherwise.
+     */
+    class loopback_radio : public radio
+    {
+    public:
+
+        /*!
+         * \brief Constructor for loopback_radio.
+         * \param rate [Optional] Sample rate, only used for timestamps. Defaults to 5e6.
+         * \param tx_amp [Optional] Transmit amplitude. Defaults to 1.0.
+         * \param capacity [Optional] Size of the sample FIFO. Defaults to 2^20 samples.
+         */
+        loopback_radio(double rate = 5e6, double tx_amp = 1.0, int capacity = 1 << 20);
+
+        /*!
+         * \brief Destructor, stops the RX stream.
+         */
+        ~loopback_radio();
+
+        /*!
+         * \brief Queues the samples, scaled by tx_amp, for the receiver. Blocks while the FIFO is full.
+         */
+        void send_samples(const std::complex<double> * samples, int num_samples, bool start_of_burst, bool end_of_burst) override;
+
+        bool realtime() const override { return false; }          //!< Never loses samples, see radio::realtime()
+        double get_rate() const override { return m_rate; }       //!< Get the sample rate
+        double get_tx_amp() const override { return m_tx_amp; }   //!< Get the transmit amplitude
+
+        /*!
+         * \brief Gets the number of samples sent so far, i.e. the TX device clock in samples.
+         */
+        unsigned long long get_tx_samples();
+
+        /*!
+         * \brief Gets the device time, the number of samples sent so far divided by the sample rate.
+         *
+         *  Time only moves when samples are sent, so radio::send_burst_at() fills the gap up to
+         *  the requested time with zeros and a burst is late if more samples than that were sent.
+         */
+        double get_time_now() override { return samples_to_time(get_tx_samples()); }
+
+    protected:
+
+        /*!
+         * \brief Takes num_samples samples from the FIFO, or none if they do not arrive within 100 ms.
+         */
+        int receive(int num_samples, std::complex<double> * buffer, bool & has_time, double & time) override;
+
+    private:
+
+        double m_rate;                                  //!< Sample rate
+        double m_tx_amp;                                //!< Transmit amplitude
+        std::vector<std::complex<double> > m_fifo;      //!< Sample FIFO, used as a ring
+        unsigned long long m_write;                     //!< Samples sent so far
+        unsigned long long m_read;                      //!< Samples received so far
+        std::mutex m_mutex;                             //!< Protects the FIFO positions
+        std::condition_variable m_not_empty;            //!< Signalled when samples are sent
+        std::condition_variable m_not_full;             //!< Signalled when samples are received
+    };
+}
+
+#endif // LOOPBACK_RADIO_H
@@ -31,6 +31,11 @@ namespace fun
      *  -QPSK
      *  -16 QAM
      *  -64 QAM
+     *
+     *  Mapping goes through a precomputed constellation table indexed by the
+     *  bpsc bits of each subcarrier. Demapping is vectorized with AVX2 when the
+     *  CPU supports it (4 subcarriers per iteration) and falls back to the QAM
+     *  template otherwise. Both produce exactly the same values as the QAM template.
      */
     class modulator
     {
@@ -42,7 +47,18 @@ namespace fun
          * \param rate PHY transmission rate from which the type of modulation is extracted.
          * \return Vector of modulated data as complex doubles.
          */
-        static std::vector<std::complex<double> > modulate(std::vector<unsigned char> data, Rate rate);
+        static std::vector<std::complex<double> > modulate(const std::vector<unsigned char> & data, Rate rate);
+
+        /*!
+         * \brief Modulates the data into a caller provided buffer.
+         * \param bits Coded bits to be modulated, one bit (0 or 1) per byte.
+         * \param bit_count Number of coded bits. Must be a multiple of the rate's bpsc.
+         * \param rate PHY transmission rate from which the type of modulation is extracted.
+         * \param symbols Output buffer with room for bit_count / bpsc complex doubles.
+         * \param scale [Optional] Factor applied to the constellation before mapping, e.g. 1/64 so that
+         *  the IFFT output needs no separate normalization pass. Defaults to 1.
+         */
+        static void modulate(const unsigned char * bits, int bit_count, Rate rate, std::complex<double> * symbols, double scale = 1.0);
 
         /*!
          * \brief Demodulates the data.
@@ -50,7 +66,25 @@ namespace fun
          * \param rate PHY transmission frate from which the type of modulation is extracted.
          * \return Vector of demodulated data in bytes.
          */
-        static std::vector<unsigned char> demodulate(std::vector<std::complex<double> > data, Rate rate);
+        static std::vector<unsigned char> demodulate(const std::vector<std::complex<double> > & data, Rate rate);
+
+        /*!
+         * \brief Demodulates the data into a caller provided buffer.
+         * \param symbols Received subcarrier values.
+         * \param symbol_count Number of subcarrier values.
+         * \param rate PHY transmission rate from which the type of modulation is extracted.
+         * \param bits Output buffer with room for symbol_count * bpsc soft bits (0 - 255).
+         */
+        static void demodulate(const std::complex<double> * symbols, int symbol_count, Rate rate, unsigned char * bits);
+
+        /*!
+         * \brief Demodulates and deinterleaves the data in one pass.
+         * \param symbols Received subcarrier values, a whole number of OFDM symbols (48 per symbol).
+         * \param symbol_count Number of subcarrier values.
+         * \param rate PHY transmission rate from which the modulation and interleaver are extracted.
+         * \param bits Output buffer with room for symbol_count * bpsc soft bits, in deinterleaved order.
+         */
+        static void demodulate_deinterleave(const std::complex<double> * symbols, int symbol_count, Rate rate, unsigned char * bits);
     };
 }
 
@@ -13,7 +13,8 @@
 #include <vector>
 #include "rates.h"
 
-#define MAX_FRAME_SIZE 2000
+#define MAX_FRAME_SIZE 4095       //!< Largest payload the 12 bit LENGTH field can describe
+#define SERVICE_AGGREGATED 0x0100 //!< Reserved SERVICE bit marking a payload of aggregated subframes
 
 namespace fun
 {
@@ -134,20 +135,76 @@ namespace fun
 * \return 布尔值，指示解码负载是否成功，
 *  通过计算并比较附加在负载末尾的 IEEE CRC-32 来判断。
 *  如果成功，则对象的 #payload 字段将填充解码后的负载/MPDU。
+*  对于聚合帧（SERVICE 字段带 #SERVICE_AGGREGATED），即使 CRC 失败也会返回 true 并填充负载，
+*  以便从中恢复完好的子帧；此时 #crc_ok() 返回 false。
 
          */
         bool decode_data(std::vector<std::complex<double> > samples);
 
 
+        /*!
+         * \brief Gets the number of data OFDM symbols (not counting the header symbol) for a payload.
+         * \param length Length of the payload in bytes.
+         * \param rate The PHY rate for the frame.
+         * \return The number of data symbols.
+         */
+        static int data_symbol_count(int length, Rate rate);
+
+        /*!
+         * \brief Encodes a header into the 48 interleaved coded bits of the SIGNAL symbol.
+         * \param rate The PHY rate to signal.
+         * \param length Length of the payload in bytes.
+         * \param bits Output coded bits, one bit per byte, 48 bytes.
+         */
+        static void encode_header_bits(Rate rate, int length, unsigned char * bits);
+
+        /*!
+         * \brief Encodes a payload into interleaved coded bits using caller provided buffers.
+         * \param payload The payload/MPDU.
+         * \param length Length of the payload in bytes.
+         * \param rate The PHY rate for the frame.
+         * \param data Scratch for the service, payload, CRC and pad bytes, at least
+         *  #data_symbol_count() * dbps / 8 + 1 bytes.
+         * \param coded Scratch for the rate 1/2 coded bits, at least #data_symbol_count() * dbps * 2 bytes.
+         * \param bits Output coded bits, one bit per byte, #data_symbol_count() * cbps bytes.
+         * \param service [Optional] SERVICE field. The 7 scrambler initialization bits must be 0.
+         *
+         *  Scrambles, convolutionally encodes, punctures and interleaves in the same way as
+         *  #encode() but without allocating, so a frame builder can reuse its buffers.
+         *  Puncturing and interleaving are done in a single pass.
+         */
+        static void encode_data_bits(const unsigned char * payload, int length, Rate rate,
+                                     unsigned char * data, unsigned char * coded, unsigned char * bits,
+                                     unsigned short service = 0);
+
+        /*!
+         * \brief Same as #encode_data_bits() but the payload is given in two parts.
+         * \param header The first part of the payload, e.g. an RTP header kept apart from its data.
+         * \param header_length Length of the first part in bytes.
+         * \param body The rest of the payload.
+         * \param body_length Length of the rest in bytes.
+         *
+         *  Both parts are gathered straight into the data scratch buffer, which is where the payload
+         *  is copied anyway, so a packet never has to be assembled in a buffer of its own first.
+         */
+        static void encode_data_bits(const unsigned char * header, int header_length,
+                                     const unsigned char * body, int body_length, Rate rate,
+                                     unsigned char * data, unsigned char * coded, unsigned char * bits,
+                                     unsigned short service = 0);
+
         Rate get_rate(){return header.rate;}     //!< Get this PPDU's PHY tx rate
         int get_length(){return header.length;}  //!< Get this PPDU's payload length
         int get_num_symbols(){return header.num_symbols;} //!< Get the number of OFDM symbols in this PPDU
         std::vector<unsigned char> get_payload(){return payload;} //!< Get the payload of this PPDU.
+        unsigned short get_service(){return header.service;} //!< Get the decoded SERVICE field
+        bool is_aggregated(){return header.service & SERVICE_AGGREGATED;} //!< Whether the payload holds aggregated subframes
+        bool crc_ok(){return m_crc_ok;} //!< Whether the PPDU CRC-32 matched in the last decode_data()
 
     private:
 
         plcp_header header; //!< This PPDU's header parameters
         std::vector<unsigned char> payload; //!< This PPDU's payload
+        bool m_crc_ok = false; //!< Result of the PPDU CRC-32 check
 
         /*!
          * \brief Encodes this PPDU's header. The header is always encoded with
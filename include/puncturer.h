@@ -15,6 +15,19 @@
 
 namespace fun
 {
+    /*!
+     * \brief The puncture_pattern struct
+     *
+     *  Describes which rate 1/2 coded bits survive puncturing. The pattern repeats
+     *  every #period coded bits; a 1 in #keep means the bit is transmitted and a 0
+     *  means it is a "puncture hole".
+     */
+    struct puncture_pattern
+    {
+        const unsigned char * keep; //!< Keep map for one period, nullptr if nothing is punctured
+        int period;                 //!< Number of rate 1/2 coded bits in one period
+    };
+
     /*!
      * \brief The puncturer class
      *
@@ -42,6 +55,16 @@ namespace fun
         * \return Vector of the depunctured data.
         */
         static std::vector<unsigned char> depuncture(std::vector<unsigned char> data, RateParams rate_params);
+
+        /*!
+         * \brief Gets the puncture pattern for the coding rate in rate_params.
+         * \param rate_params The parameters for the PHY Rate from which the coding rate is extracted.
+         * \return The puncture pattern. For rate 1/2 #puncture_pattern::keep is nullptr.
+         *
+         *  This lets the viterbi decoder consume the punctured stream directly without
+         *  building a depunctured copy first.
+         */
+        static puncture_pattern pattern(RateParams rate_params);
     };
 }
 
@@ -95,6 +95,18 @@ namespace fun
             *sym = pt * d_scale_e;
         }
 
+        /*!
+         * \brief Scale applied to a received component before decoding
+         * \return The decode scale factor
+         */
+        double decode_scale() const { return d_scale_d; }
+
+        /*!
+         * \brief Distance to the first decision boundary after scaling
+         * \return The initial decoding amplitude
+         */
+        int decode_amp() const { return (1 << (NumBits-1)) << d_gain; }
+
         /*!
          * \brief Decode recursively
          *
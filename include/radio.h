@@ -0,0 +1,202 @@
+/*! \file radio.h
+ *  \brief Header file for the radio interface and the rx_stats struct.
+ *
+ *  The radio class is the interface the transmitter and receiver use to move baseband samples.
+ *  The usrp class implements it for real hardware, file_radio and loopback_radio implement it
+ *  without any hardware so that the whole TX to RX path can be run and benchmarked anywhere.
+ */
+
+#ifndef RADIO_H
+#define RADIO_H
+
+#include <complex>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cmath>
+
+#include "rx_ring.h"
+
+#define RADIO_RX_BLOCK 8192 //!< Default number of samples per rx_ring block
+
+namespace fun
+{
+    /*!
+     * \brief RX 流的统计计数，由 #radio::get_rx_stats() 返回。
+     */
+    struct rx_stats
+    {
+        unsigned long long overflows;       //!< 溢出（主机没有及时读取样本）
+        unsigned long long timeouts;        //!< 接收超时次数
+        unsigned long long late_packets;    //!< 迟到的定时命令
+        unsigned long long other_errors;    //!< 其他接收错误
+        unsigned long long ring_full;       //!< 因为 rx_ring 已满而丢弃的块数
+        unsigned long long samples;         //!< 收到的样本总数
+        unsigned long long short_blocks;    //!< 因为太短（不超过 CARRYOVER_LENGTH）而没有解码的块数，只由 receiver 计数
+        unsigned long long discontinuities; //!< 样本流不连续、接收链因此重置的次数，只由 receiver 计数
+    };
+
+    /*!
+     * \brief The radio interface.
+     *
+     *  Implementations provide #send_samples() and #receive(), everything else (bursts,
+     *  #get_samples() and the background RX stream into an rx_ring) is built on top of those two.
+     *  Implementations that override #receive() must call #stop_rx_stream() in their destructor,
+     *  because the RX thread calls into them.
+     */
+    class radio
+    {
+    public:
+
+        radio();
+
+        virtual ~radio();
+
+        radio(const radio &) = delete;
+        radio & operator=(const radio &) = delete;
+
+        /*!
+         * \brief 发送采样脉冲串，并阻塞直到脉冲串结束。默认实现与 #send_burst() 相同。
+         * \param samples 基带时域样本。
+         */
+        virtual void send_burst_sync(const std::vector<std::complex<double> > & samples);
+
+        /*!
+         * \brief 发送采样脉冲串，但在脉冲串结束前不阻塞。
+         * \param samples 基带时域样本。
+         */
+        virtual void send_burst(const std::vector<std::complex<double> > & samples);
+
+        /*!
+         * \brief 将样本作为连续流的一部分发送。
+         * \param samples 基带时域样本，发送时按 tx_amp 缩放。
+         * \param num_samples 样本数量，可以为 0（例如只发送 end_of_burst）。
+         * \param start_of_burst 是否是一个脉冲串的第一段。
+         * \param end_of_burst 是否是一个脉冲串的最后一段。
+         */
+        virtual void send_samples(const std::complex<double> * samples, int num_samples, bool start_of_burst, bool end_of_burst) = 0;
+
+        /*!
+         * \brief 在设备时间 time 发送一个完整的脉冲串。
+         * \param samples 基带时域样本。
+         * \param time 第一个样本的设备时间（秒），见 #get_time_now()。
+         * \return 如果已知太迟而被丢弃则返回 false（同时计入 #poll_late_bursts()）。
+         *
+         *  函数在样本交给设备后返回，不等待发送时间，因此可以提前排好多个时隙。相邻时隙的
+         *  脉冲串首尾相接时中间没有空闲样本。默认实现用于以样本计时的设备（#get_time_now()
+         *  是已发送的样本数）：先发送零样本直到 time，再发送脉冲串。
+         */
+        virtual bool send_burst_at(const std::vector<std::complex<double> > & samples, double time);
+
+        /*!
+         * \brief 非阻塞地读取 TX 下溢次数。
+         * \return 自上次调用以来的下溢次数，默认实现不会下溢。
+         */
+        virtual int poll_underflows() { return 0; }
+
+        /*!
+         * \brief 非阻塞地读取因太迟而被丢弃的定时脉冲串数量。
+         * \return 自上次调用以来的数量。
+         */
+        virtual int poll_late_bursts();
+
+        /*!
+         * \brief 获取当前的设备时间（秒），TX 和 RX 的时间戳都以它为准。
+         */
+        virtual double get_time_now() = 0;
+
+        /*!
+         * \brief 设备时间转换为样本序号（四舍五入到最近的样本）。
+         */
+        long long time_to_samples(double time) const { return std::llround(time * get_rate()); }
+
+        /*!
+         * \brief 样本序号转换为设备时间。
+         */
+        double samples_to_time(long long samples) const { return samples / get_rate(); }
+
+        /*!
+         * \brief Whether samples are lost when they are not received in time.
+         *
+         *  The RX thread of a real time radio drops blocks when the rx_ring is full so that the
+         *  device does not overflow. For the others it waits for the consumer instead, so nothing
+         *  is lost and the whole system simply runs at the speed of the slowest stage.
+         */
+        virtual bool realtime() const { return true; }
+
+        virtual double get_rate() const = 0;    //!< Get the sample rate
+        virtual double get_tx_amp() const = 0;  //!< Get the transmit amplitude
+
+        /*!
+         * \brief 获取 num_samples 个样本，并将其放入缓冲区的前 num_samples 的位置。
+         * \param num_samples 样本数量。
+         * \param buffer 放置样本的缓冲区，至少有 num_samples 个元素。
+         */
+        void get_samples(int num_samples, std::vector<std::complex<double> > & buffer);
+
+        /*!
+         * \brief 与上面相同，同时返回第一个样本的设备时间。
+         * \param num_samples 样本数量。
+         * \param buffer 放置样本的缓冲区，至少有 num_samples 个元素。
+         * \param time 第一个样本的设备时间（秒）。
+         * \return time 是否有效（设备提供了时间戳）。
+         */
+        bool get_samples(int num_samples, std::vector<std::complex<double> > & buffer, double & time);
+
+        /*!
+         * \brief 启动后台 RX 线程，把接收到的样本持续写入 rx_ring。
+         * \param block_samples 每块的样本数量（每次 #receive() 的样本数）。
+         * \param num_blocks 环形缓冲区的块数。
+         *
+         *  启动之后应通过 #get_rx_ring() 读取样本，不要再调用 #get_samples()。
+         */
+        void start_rx_stream(int block_samples = RADIO_RX_BLOCK, int num_blocks = 256);
+
+        /*!
+         * \brief 停止并等待后台 RX 线程结束。环形缓冲区保留到下一次 #start_rx_stream()。
+         */
+        void stop_rx_stream();
+
+        rx_ring * get_rx_ring() { return m_rx_ring.get(); } //!< Get the RX ring, nullptr before #start_rx_stream()
+
+        /*!
+         * \brief 获取 RX 计数（包括 #get_samples() 和 RX 线程）。
+         */
+        rx_stats get_rx_stats() const;
+
+    protected:
+
+        /*!
+         * \brief 接收最多 num_samples 个样本。实现负责更新下面的计数器（#m_rx_samples 除外）。
+         * \param num_samples 最多接收的样本数量。
+         * \param buffer 接收到的样本。
+         * \param has_time 第一个样本是否带有时间戳。
+         * \param time 第一个样本的设备时间（秒）。
+         * \return 实际接收的样本数量，超时或溢出时可能少于 num_samples。
+         */
+        virtual int receive(int num_samples, std::complex<double> * buffer, bool & has_time, double & time) = 0;
+
+        std::atomic<unsigned long long> m_overflows;     //!< See rx_stats
+        std::atomic<unsigned long long> m_timeouts;      //!< See rx_stats
+        std::atomic<unsigned long long> m_late_packets;  //!< See rx_stats
+        std::atomic<unsigned long long> m_other_errors;  //!< See rx_stats
+        std::atomic<int> m_late_bursts;                  //!< Late bursts not reported by #poll_late_bursts() yet
+
+    private:
+
+        /*!
+         * \brief RX 线程的主循环。
+         */
+        void run_rx_stream();
+
+        std::unique_ptr<rx_ring> m_rx_ring;              //!< Ring filled by the RX thread
+        std::thread m_rx_thread;                         //!< Background RX thread
+        std::atomic<bool> m_rx_running;                  //!< Tells the RX thread to keep going
+
+        std::atomic<unsigned long long> m_ring_full;     //!< See rx_stats
+        std::atomic<unsigned long long> m_rx_samples;    //!< See rx_stats
+    };
+}
+
+#endif // RADIO_H
@@ -0,0 +1,125 @@
+/*! \file receiver.h
+ *  \brief Header file for receiver class.
+ *
+ *  The receiver class is the public interface for the fun_ofdm receive chain.
+ *  This is the easiest way to start receiving 802.11a OFDM frames out of the box.
+ */
+
+#ifndef RECEIVER_H
+#define RECEIVER_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include "usrp.h"
+#include "receiver_chain.h"
+
+namespace fun {
+
+    /*!
+     * \brief The receiver class is the public interface for the fun_ofdm receive chain.
+     *  This is the easiest way to start receiving 802.11a OFDM frames out of the box.
+     *
+     *  Usage: Create a receiver object with the desired USRP parameters and a callback function.
+     *  The radio's RX thread streams samples into its rx_ring and the receiver's own thread runs
+     *  the receiver_chain on each block in place, calling the callback with whatever payloads
+     *  were correctly received from that block.
+     */
+    class receiver
+    {
+    public:
+
+        /*!
+         * \brief Constructor for the receiver with raw parameters
+         * \param callback Function pointer to the callback function where received packets are passed
+         * \param freq [Optional] Center frequency
+         * \param samp_rate [Optional] Sample rate
+         * \param rx_gain [Optional] Receive Gain
+         * \param device_addr [Optional] IP address of USRP device
+         *
+         *  Defaults to:
+         *  - center_freq -> 5.72e9 (5.72 GHz)
+         *  - sample_rate -> 5e6 (5 MHz)
+         *  - rx_gain -> 20
+         *  - device_addr -> "" (empty string will default to letting the UHD api
+         *    automatically find an available USRP)
+         */
+        receiver(void(*callback)(std::vector<std::vector<unsigned char> > packets),
+                 double freq = 5.72e9, double samp_rate = 5e6, double rx_gain = 20, std::string device_addr = "");
+
+        /*!
+         * \brief Constructor for the receiver that uses the usrp_params struct
+         * \param callback Function pointer to the callback function where received packets are passed
+         * \param params The usrp parameters you want to use for this receiver.
+         */
+        receiver(void(*callback)(std::vector<std::vector<unsigned char> > packets), usrp_params params);
+
+        /*!
+         * \brief Constructor for the receiver that receives from any radio
+         * \param callback Function pointer to the callback function where received packets are passed
+         * \param radio The radio to receive from, e.g. a loopback_radio shared with a transmitter
+         */
+        receiver(void(*callback)(std::vector<std::vector<unsigned char> > packets), std::shared_ptr<radio> radio);
+
+        /*!
+         * \brief Stops the receive thread and the radio's RX thread.
+         */
+        ~receiver();
+
+        /*!
+         * \brief Pauses the receiver. Samples keep streaming but are dropped instead of decoded.
+         */
+        void pause();
+
+        /*!
+         * \brief Resumes the receiver after #pause().
+         */
+        void resume();
+
+        /*!
+         * \brief Gets the overflow, timeout and late packet counters of the RX stream,
+         *  and the blocks the receiver could not decode.
+         */
+        rx_stats get_rx_stats() const;
+
+        /*!
+         * \brief Sets a second callback that gets every frame the receiver_chain tried to decode
+         *  with its PHY metadata (see rx_frame), including the ones that failed the CRC check.
+         *  It is called from the receive thread right before the payload callback.
+         * \param callback The frame callback, or an empty function to remove it.
+         */
+        void set_frame_callback(std::function<void(const std::vector<rx_frame> & frames)> callback);
+
+    private:
+
+        /*!
+         * \brief Takes blocks from the rx_ring, runs them through the receiver_chain and calls the callback.
+         */
+        void receiver_chain_loop();
+
+        void (*m_callback)(std::vector<std::vector<unsigned char> > packets); //!< Callback for received packets
+
+        std::function<void(const std::vector<rx_frame> & frames)> m_frame_callback; //!< Callback for frame metadata
+
+        std::mutex m_frame_callback_mutex;  //!< Guards #m_frame_callback
+
+        std::shared_ptr<radio> m_radio;     //!< The radio used to receive frames (a usrp unless one was passed in)
+
+        receiver_chain m_rec_chain;         //!< The receiver chain object used to detect & decode incoming frames
+
+        std::atomic<bool> m_running;        //!< Keeps #receiver_chain_loop() going
+        std::atomic<bool> m_paused;         //!< Whether the receiver is paused
+
+        unsigned long long m_next_sample;                   //!< Stream position the next decoded block should start at
+        std::atomic<unsigned long long> m_short_blocks;     //!< See rx_stats
+        std::atomic<unsigned long long> m_discontinuities;  //!< See rx_stats
+
+        std::thread m_rec_thread;           //!< The thread that runs #receiver_chain_loop()
+    };
+
+}
+
+#endif // RECEIVER_H
@@ -11,6 +11,7 @@
 #define RECEIVER_CHAIN_H
 
 #include <thread>
+#include <atomic>
 #include <semaphore.h>
 
 #include "fft_symbols.h"
@@ -46,6 +47,11 @@ namespace fun
          */
         receiver_chain();
 
+        /*!
+         * \brief Destructor for receiver_chain, stops the block threads.
+         */
+        ~receiver_chain();
+
         /*!
          * \brief Processes the raw time domain samples.
          * \param samples A vector of received time-domain samples from the usrp block to pass to
@@ -55,6 +61,39 @@ namespace fun
          */
         std::vector<std::vector<unsigned char> > process_samples(std::vector<std::complex<double> > samples);
 
+        /*!
+         * \brief Processes raw time domain samples held in someone else's buffer.
+         * \param samples Pointer to the received time-domain samples, e.g. an rx_view from the rx_ring.
+         * \param count Number of samples.
+         * \return A vector of correctly received payloads where each payload is its own vector
+         *  of unsigned chars.
+         */
+        std::vector<std::vector<unsigned char> > process_samples(const std::complex<double> * samples, int count);
+
+        /*!
+         * \brief Processes the raw time domain samples like process_samples() but returns every
+         *  frame the chain tried to decode together with its PHY metadata.
+         * \param samples A vector of received time-domain samples.
+         * \return A vector of rx_frame's, including the ones that failed the header or CRC check.
+         */
+        std::vector<rx_frame> process_frames(std::vector<std::complex<double> > samples);
+
+        /*!
+         * \brief Same as above for samples held in someone else's buffer.
+         * \param samples Pointer to the received time-domain samples.
+         * \param count Number of samples.
+         * \return A vector of rx_frame's, including the ones that failed the header or CRC check.
+         */
+        std::vector<rx_frame> process_frames(const std::complex<double> * samples, int count);
+
+        /*!
+         * \brief Tells the chain that samples are missing before the next call to process_samples()
+         *  or process_frames(), so that no frame is detected across the gap. A frame that was already
+         *  being decoded when the gap happened fails its CRC check.
+         * \param skipped Number of missing samples.
+         */
+        void reset(unsigned long long skipped);
+
     private:
 
         /**********
@@ -85,6 +124,22 @@ namespace fun
          */
         void run_block(int index, fun::block_base * block);
 
+        /*!
+         * \brief Runs every block once on the frame_detector's input buffer and shifts the buffers.
+         * \return The frame_decoder's output buffer.
+         */
+        std::vector<rx_frame> run_chain();
+
+        /*!
+         * \brief Picks the payloads that passed the CRC check out of the frames.
+         * \param frames the frame_decoder's output.
+         * \return the payloads.
+         */
+        static std::vector<std::vector<unsigned char> > payloads(std::vector<rx_frame> & frames);
+
+
+        std::vector<frame_measurements> m_frame_table; //!< Measurements of the frames in flight, indexed by frame id
+
 
         std::vector<std::thread> m_threads; //!< Vector of threads - one for each block
 
@@ -93,6 +148,13 @@ namespace fun
 
 
         std::vector<sem_t> m_done_sems; //!< Vector of semaphores used to determine when the blocks are done
+
+
+        std::atomic<bool> m_stop; //!< Tells the block threads to exit
+
+
+        bool m_reset_timing;                    //!< Reset the timing_sync before it gets the samples after the gap
+        unsigned long long m_reset_skipped;     //!< Samples missing in that gap
     };
 
 }
@@ -0,0 +1,61 @@
+/*! \file rx_frame.h
+ *  \brief Header file for the rx_frame and frame_measurements structs.
+ *
+ *  rx_frame is what the receiver_chain returns for every frame it tried to decode: the
+ *  payload together with the PHY measurements taken along the chain. frame_measurements is
+ *  the table the blocks use to hand those measurements down the chain.
+ */
+
+#ifndef RX_FRAME_H
+#define RX_FRAME_H
+
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "rates.h"
+
+#define FRAME_TABLE_SIZE 256 //!< Frames that can be in flight in the receiver_chain at once
+
+namespace fun
+{
+    /*!
+     * \brief A received frame and its PHY metadata.
+     *
+     *  An aggregated frame gives one rx_frame per intact subframe, all with the same metadata.
+     */
+    struct rx_frame
+    {
+        std::vector<unsigned char> payload; //!< The payload (MPDU), empty if #crc_ok is false
+        bool header_ok;                     //!< Whether the SIGNAL field passed its parity and rate checks
+        bool crc_ok;                        //!< Whether the payload passed its CRC
+        bool aggregated;                    //!< Whether the payload is a subframe of an aggregated frame
+        Rate rate;                          //!< PHY Rate from the SIGNAL field (valid if #header_ok)
+        int length;                         //!< PSDU length in bytes from the SIGNAL field (valid if #header_ok)
+        int num_symbols;                    //!< Number of DATA symbols (valid if #header_ok)
+        unsigned long long start_sample;    //!< Index of the first preamble sample in the samples given to the receiver_chain
+        double rssi_dbfs;                   //!< Power of the short training sequence in dB relative to full scale (1.0)
+        double snr_db;                      //!< SNR estimated from the difference between the two LTS symbols
+        double evm_db;                      //!< Pilot EVM over the SIGNAL and DATA symbols after phase correction
+        double cfo;                         //!< Carrier frequency offset in cycles per sample (multiply by the sample rate for Hz)
+        double pilot_phase_rms;             //!< RMS of the per symbol pilot phase error before correction, in radians
+        double decode_latency_us;           //!< Time from the process_samples() call that detected the frame until it was decoded
+    };
+
+    /*!
+     * \brief The measurements the blocks take for one frame, indexed by frame id.
+     *
+     *  frame_detector gives each detected frame an id (carried in the tags of the samples and
+     *  symbols) and starts the entry, the later blocks fill in their fields for the same id and
+     *  frame_decoder turns the entry into rx_frame's. Only the block that owns a field writes it.
+     */
+    struct frame_measurements
+    {
+        boost::posix_time::ptime detected;  //!< Time the frame was detected (frame_detector)
+        double rssi_dbfs;                   //!< See rx_frame::rssi_dbfs (frame_detector)
+        double cfo;                         //!< See rx_frame::cfo (timing_sync)
+        unsigned long long start_sample;    //!< See rx_frame::start_sample (timing_sync)
+        double snr_db;                      //!< See rx_frame::snr_db (channel_est)
+    };
+}
+
+#endif // RX_FRAME_H
@@ -0,0 +1,128 @@
+/*! \file rx_ring.h
+ *  \brief Header file for the rx_ring class and the rx_view struct.
+ *
+ *  The rx_ring class is a single producer, single consumer ring of received sample blocks.
+ *  The usrp RX thread writes received samples straight into the ring and the consumer reads
+ *  them in place through rx_view's, so samples are never copied between the two threads.
+ */
+
+#ifndef RX_RING_H
+#define RX_RING_H
+
+#include <complex>
+#include <vector>
+#include <atomic>
+#include <semaphore.h>
+
+namespace fun
+{
+    /*!
+     * \brief A read only view of one block of received samples.
+     *
+     *  The view stays valid until rx_ring::release() is called.
+     */
+    struct rx_view
+    {
+        const std::complex<double> * samples;   //!< The received samples
+        int count;                              //!< Number of samples in the block
+        unsigned long long first_sample;        //!< Index of samples[0] counted from the start of the stream
+        bool has_time;                          //!< Whether #time is valid
+        double time;                            //!< Device time of samples[0] in seconds
+    };
+
+    /*!
+     * \brief The rx_ring class
+     *
+     *  The ring is made up of num_blocks blocks of block_samples samples each. A block is always
+     *  contiguous, so a view never wraps around. The storage is allocated once with mmap, backed
+     *  by huge pages when the system has them, and pre-faulted so that the RX thread never takes
+     *  a page fault while streaming.
+     *
+     *  Producer side: #write_block(), fill it, #commit(). Consumer side: #acquire(), read the
+     *  view, #release(). The positions are atomics, only the consumer can block (on a semaphore).
+     */
+    class rx_ring
+    {
+    public:
+
+        /*!
+         * \brief Constructor for rx_ring.
+         * \param block_samples Maximum number of samples per block.
+         * \param num_blocks Number of blocks in the ring.
+         */
+        rx_ring(int block_samples, int num_blocks);
+
+        /*!
+         * \brief Destructor, unmaps the storage.
+         */
+        ~rx_ring();
+
+        rx_ring(const rx_ring &) = delete;
+        rx_ring & operator=(const rx_ring &) = delete;
+
+        /*!
+         * \brief Gets the next block to write (producer).
+         * \return Room for #block_samples() samples, or nullptr if the consumer has fallen behind
+         *  and every block is in use.
+         */
+        std::complex<double> * write_block();
+
+        /*!
+         * \brief Publishes the block returned by #write_block() (producer).
+         * \param count Number of samples written.
+         * \param has_time Whether time is valid.
+         * \param time Device time of the first sample in seconds.
+         */
+        void commit(int count, bool has_time, double time);
+
+        /*!
+         * \brief Gets the oldest unread block (consumer).
+         * \param view Filled with the block.
+         * \param timeout_ms How long to wait for a block, in milliseconds.
+         * \return false if no block arrived within timeout_ms.
+         */
+        bool acquire(rx_view & view, int timeout_ms);
+
+        /*!
+         * \brief Hands the block from the last #acquire() back to the producer (consumer).
+         */
+        void release();
+
+        /*!
+         * \brief Counts samples that were lost without going through the ring (e.g. dropped
+         *  because the ring was full), so that rx_view::first_sample stays the stream position.
+         */
+        void skip_samples(unsigned long long count) { m_total_samples += count; }
+
+        int block_samples() const { return m_block_samples; } //!< Get the maximum number of samples per block
+        int num_blocks() const { return m_num_blocks; }       //!< Get the number of blocks
+        bool huge_pages() const { return m_huge_pages; }      //!< Whether the storage is backed by huge pages
+
+    private:
+
+        /*!
+         * \brief Metadata of one block.
+         */
+        struct block_info
+        {
+            int count;
+            unsigned long long first_sample;
+            bool has_time;
+            double time;
+        };
+
+        int m_block_samples;                            //!< Maximum number of samples per block
+        int m_num_blocks;                               //!< Number of blocks
+        std::complex<double> * m_samples;               //!< The mmap'ed storage
+        size_t m_bytes;                                 //!< Size of the mapping
+        bool m_huge_pages;                              //!< Whether the mapping uses huge pages
+        std::vector<block_info> m_info;                 //!< Metadata for each block
+        unsigned long long m_total_samples;             //!< Samples produced so far (producer only)
+        sem_t m_available;                              //!< Counts committed blocks
+
+        alignas(64) std::atomic<unsigned long long> m_write;   //!< Blocks committed by the producer
+        alignas(64) std::atomic<unsigned long long> m_read;    //!< Blocks released by the consumer
+    };
+}
+
+#endif // RX_RING_H
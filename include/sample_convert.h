@@ -0,0 +1,92 @@
+/*! \file sample_convert.h
+ *  \brief Header file for the sample_convert class.
+ *
+ *  The sample_convert class converts between the complex doubles used by the PHY and
+ *  the compact host sample formats handed to UHD (fc32 and sc16). Scaling is fused into
+ *  the conversion so that every sample is touched once.
+ */
+
+#ifndef SAMPLE_CONVERT_H
+#define SAMPLE_CONVERT_H
+
+#include <complex>
+
+#define SC16_SCALE 32767.0 //!< Full scale of the sc16 format, the same value UHD uses
+
+namespace fun
+{
+    /*!
+     * \brief The host sample formats the usrp class can hand to UHD.
+     */
+    enum sample_format
+    {
+        FORMAT_FC64,    //!< std::complex<double>, 16 bytes per sample, converted by UHD
+        FORMAT_FC32,    //!< std::complex<float>, 8 bytes per sample
+        FORMAT_SC16,    //!< std::complex<short>, 4 bytes per sample, full scale is +-1.0
+    };
+
+    /*!
+     * \brief The sample_convert class
+     *
+     *  AVX2 is used when the CPU supports it, with a scalar fallback. All functions work
+     *  on caller provided buffers and do not allocate.
+     */
+    class sample_convert
+    {
+    public:
+
+        /*!
+         * \brief Scales and converts to fc32.
+         * \param in Input samples.
+         * \param count Number of samples.
+         * \param scale Factor applied before conversion (e.g. the transmit amplitude).
+         * \param out Output samples.
+         */
+        static void to_fc32(const std::complex<double> * in, int count, double scale, std::complex<float> * out);
+
+        /*!
+         * \brief Scales and converts to sc16, rounding to nearest and saturating.
+         * \param in Input samples, +-1.0 is full scale.
+         * \param count Number of samples.
+         * \param scale Factor applied before conversion (e.g. the transmit amplitude).
+         * \param out Output samples.
+         */
+        static void to_sc16(const std::complex<double> * in, int count, double scale, std::complex<short> * out);
+
+        /*!
+         * \brief Scales the samples into out without changing the format (used for fc64).
+         * \param in Input samples.
+         * \param count Number of samples.
+         * \param scale Factor applied to every sample.
+         * \param out Output samples, may be the same buffer as in.
+         */
+        static void scale_fc64(const std::complex<double> * in, int count, double scale, std::complex<double> * out);
+
+        /*!
+         * \brief Converts fc32 samples to complex doubles.
+         */
+        static void from_fc32(const std::complex<float> * in, int count, std::complex<double> * out);
+
+        /*!
+         * \brief Converts sc16 samples to complex doubles, full scale becomes +-1.0.
+         */
+        static void from_sc16(const std::complex<short> * in, int count, std::complex<double> * out);
+
+        /*!
+         * \brief Gets the size of one sample in a format.
+         */
+        static int sample_size(sample_format format);
+
+        /*!
+         * \brief Gets the UHD name ("fc64", "fc32" or "sc16") of a format.
+         */
+        static const char * uhd_name(sample_format format);
+
+        /*!
+         * \brief Checks whether the AVX2 conversions are used on this CPU.
+         */
+        static bool simd_supported();
+    };
+}
+
+#endif // SAMPLE_CONVERT_H
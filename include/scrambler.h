@@ -0,0 +1,75 @@
+/*! \file scrambler.h
+ *  \brief Header file for the scrambler class.
+ *
+ *  The scrambler class implements the 802.11a data scrambler (section 17.3.5.4 of the
+ *  802.11a-1999 standard) with the generator polynomial x^7 + x^4 + 1. The same class is
+ *  used to scramble on the transmit side and to descramble on the receive side.
+ */
+
+#ifndef SCRAMBLER_H
+#define SCRAMBLER_H
+
+#define SCRAMBLER_PERIOD 127     //!< Length of the scrambling sequence in bits
+#define SCRAMBLER_DEFAULT_SEED 93 //!< Initial state used by the transmitter (1011101b)
+
+namespace fun
+{
+    /*!
+     * \brief The scrambler class
+     *
+     *  The scrambling sequence has a period of 127 bits, so the byte stream of the sequence
+     *  repeats every 127 bytes. For a given seed that byte stream is computed once and then
+     *  XORed into the data 64 bits at a time. Bits are taken MSB first from each byte, which
+     *  is the order the convolutional encoder consumes them.
+     *
+     *  Since the first 7 bits of the SERVICE field are zero before scrambling, the receiver
+     *  can recover the seed from the first 7 scrambled bits with #recover_seed().
+     */
+    class scrambler
+    {
+    public:
+
+        /*!
+         * \brief Gets the scrambler for a seed. Scramblers for every seed are built once
+         *  and shared, so this is cheap to call for every frame.
+         * \param seed The initial 7 bit state of the LFSR. Must not be 0.
+         * \return The scrambler for that seed.
+         */
+        static const scrambler & get(int seed = SCRAMBLER_DEFAULT_SEED);
+
+        /*!
+         * \brief Recovers the transmitter's seed from the first byte of a scrambled frame.
+         * \param first_byte The first scrambled byte of the SERVICE field.
+         * \return The seed that was used to scramble the frame, or 0 if the first 7 bits
+         *  are all zero (which no valid seed produces).
+         */
+        static int recover_seed(unsigned char first_byte);
+
+        /*!
+         * \brief Scrambles (or descrambles) data in place.
+         * \param data The bytes to be scrambled, starting at the first bit of the SERVICE field.
+         * \param num_bytes Number of bytes to scramble.
+         */
+        void apply(unsigned char * data, int num_bytes) const;
+
+        int get_seed() const { return m_seed; } //!< Get the seed of this scrambler
+
+        /*!
+         * \brief Builds the scrambling sequence for a seed. Prefer #get() which reuses them.
+         * \param seed The initial 7 bit state of the LFSR.
+         */
+        scrambler(int seed = SCRAMBLER_DEFAULT_SEED);
+
+    private:
+
+        int m_seed; //!< Initial state of the LFSR
+
+        /*!
+         * \brief One period of the sequence as bytes, followed by its first 8 bytes again
+         *  so that a 64 bit load starting anywhere in the period does not need to wrap.
+         */
+        unsigned char m_pattern[SCRAMBLER_PERIOD + 8];
+    };
+}
+
+#endif // SCRAMBLER_H
@@ -38,6 +38,17 @@ namespace fun
          */
         std::vector<std::complex<double> > map(std::vector<std::complex<double> > data_samples);
 
+        /*!
+         * \brief Maps the data, pilots, and nulls straight into the subcarrier order used by fft::inverse_prefixed()
+         * \param data_samples Modulated data, 48 samples per symbol
+         * \param num_symbols Number of symbols to map
+         * \param pilot_scale Factor applied to the pilots so that they match data that was modulated pre-scaled
+         * \param samples Output symbols, 64 samples per symbol with the DC subcarrier first
+         *
+         *  The first symbol uses the pilot polarity of the SIGNAL symbol, the same as #map().
+         */
+        void map_fft_order(const std::complex<double> * data_samples, int num_symbols, double pilot_scale, std::complex<double> * samples);
+
         /*!
          * \brief Extracts the data from the symbols throwing out the nulls and pilots
          * \param samples Vector of symbols to extract data from
@@ -47,6 +47,9 @@ namespace fun
 
         std::complex<double> samples[N]; //!< The array of N complex doubles
         vector_tag tag;                  //!< The array's tag
+        unsigned frame_id;               //!< Frame the array belongs to (see frame_measurements), valid where #tag is not NONE
+        float pilot_phase;               //!< Pilot phase error of the symbol in radians, set by phase_tracker
+        float pilot_error;               //!< Pilot error power after phase correction, set by phase_tracker
 
         /*!
          * \brief Non-initializing constructor for tagged_vector.
@@ -86,6 +89,7 @@ namespace fun
     {
         std::complex<double> sample; //!< The complex sample
         vector_tag tag;              //!< The sample's tag
+        unsigned frame_id;           //!< Frame the sample belongs to (see frame_measurements), valid where #tag is not NONE
 
         /*!
          * \brief Constructor for tagged_sample
@@ -17,6 +17,7 @@
 
 #include "block.h"
 #include "tagged_vector.h"
+#include "rx_frame.h"
 
 namespace fun
 {
@@ -34,10 +35,22 @@ namespace fun
     {
     public:
 
-        timing_sync(); //!< Constructor for timing_sync block.
+        /*!
+         * \brief Constructor for timing_sync block.
+         * \param frame_table [Optional] Table to record the CFO and start sample of each frame in.
+         */
+        timing_sync(frame_measurements * frame_table = nullptr);
 
         virtual void work(); //!< Signal processing happens here.
 
+        /*!
+         * \brief Forgets the samples before a gap in the sample stream so that no LTS is searched
+         *  for across it, and stops applying the last frame's frequency correction.
+         * \param skipped Number of samples missing in the gap, keeps frame_measurements::start_sample
+         *  counted from the start of the stream.
+         */
+        void reset(unsigned long long skipped);
+
     private:
 
         double m_phase_offset; //!< The phase rotation from symbol to symbol
@@ -49,6 +62,9 @@ namespace fun
          * and carrying them over to the next call to #work()
          */
         std::vector<tagged_sample> m_carryover;
+
+        frame_measurements * m_frame_table; //!< Table of frame measurements, may be nullptr
+        unsigned long long m_sample_count;  //!< Number of input samples before the current call to #work()
     };
 }
 
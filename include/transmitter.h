@@ -10,12 +10,51 @@
 #define TRANSMITTER_H
 
 #include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <semaphore.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include "usrp.h"
 #include "rates.h"
 #include "frame_builder.h"
+#include "tx_queue.h"
 
 namespace fun {
 
+    /*!
+     * \brief Per frame report from the asynchronous transmit pipeline.
+     */
+    struct tx_frame_report
+    {
+        unsigned long long sequence;    //!< Submission order of the frame, starting at 0
+        Rate rate;                      //!< PHY Rate of the frame
+        int num_samples;                //!< Number of samples in the frame, 0 if it could not be built
+        double build_latency_us;        //!< Time from submit_frame() until the frame was built
+        double air_latency_us;          //!< Time from submit_frame() until the last sample was handed to the radio
+        double source_latency_us;       //!< Time from tx_packet::origin_us until the last sample was handed to the radio,
+                                        //!< 0 for frames that did not come from a tx_queue
+    };
+
+    /*!
+     * \brief Running totals of the asynchronous transmit pipeline.
+     */
+    struct tx_stats
+    {
+        unsigned long long frames_submitted = 0;    //!< Frames accepted by submit_frame()
+        unsigned long long frames_rejected = 0;     //!< Frames refused because the queue was full
+        unsigned long long frames_sent = 0;         //!< Frames handed to the radio
+        unsigned long long bursts = 0;              //!< Bursts started, a burst ends whenever the queue runs dry
+        unsigned long long underflows = 0;          //!< Underflows reported by the radio
+        double mean_air_latency_us = 0;             //!< Mean of tx_frame_report::air_latency_us
+        double max_air_latency_us = 0;              //!< Maximum of tx_frame_report::air_latency_us
+        unsigned long long queue_frames = 0;        //!< Frames sent from the attached tx_queue
+        double mean_source_latency_us = 0;          //!< Mean of tx_frame_report::source_latency_us over those frames
+        double max_source_latency_us = 0;           //!< Maximum of tx_frame_report::source_latency_us
+    };
+
     /*!
      * \brief The transmitter class is the public interface for the fun_ofdm transmit chain.
      *  This is the easiest way to start transmitting 802.11a OFDM frames out of the box.
@@ -62,22 +101,180 @@ namespace fun {
          */
         transmitter(usrp_params params = usrp_params());
 
+        /*!
+         * \brief Constructor for the transmitter that sends through any radio
+         * \param radio The radio to send the frames with, e.g. a loopback_radio shared with a receiver
+         */
+        transmitter(std::shared_ptr<radio> radio);
+
         /*!
          * \brief Send a single PHY frame at the given PHY Rate
          * \param payload The data to be transmitted (i.e. the MPDU)
          * \param phy_rate [Optional] The PHY data rate to transmit at - defaults to 1/2 BPSK
          *
-         *  This function uses the usrp::send_burst_sync() function which means that this function
-         *  blocks until the packet is done transmitting.
+         *  This function uses the radio::send_burst_sync() function which means that this function
+         *  blocks until the packet is done transmitting. A payload longer than MAX_FRAME_SIZE is not sent.
          */
         void send_frame(std::vector<unsigned char> payload, Rate phy_rate = RATE_1_2_BPSK);
 
+        /*!
+         * \brief Send a single PHY frame at a given device time
+         * \param payload The data to be transmitted (i.e. the MPDU)
+         * \param phy_rate The PHY data rate to transmit at
+         * \param time Device time of the first sample in seconds (see radio::get_time_now())
+         * \return false if the payload is longer than MAX_FRAME_SIZE or the radio already knows the
+         *  frame is late, in which case it is not sent
+         *
+         *  Returns as soon as the frame is handed to the radio, so frames for later slots can be
+         *  queued ahead of time. Frames whose slots follow each other directly are sent without
+         *  any idle samples in between. Use frame_builder::frame_length() and
+         *  radio::samples_to_time() to compute the slot times.
+         */
+        bool send_frame_at(const std::vector<unsigned char> & payload, Rate phy_rate, double time);
+
+        /*!
+         * \brief Destructor, stops the asynchronous pipeline if it is running.
+         */
+        ~transmitter();
+
+        /*!
+         * \brief Starts the asynchronous transmit pipeline.
+         * \param num_builders [Optional] Number of frame builder threads. Defaults to 2.
+         * \param queue_depth [Optional] Maximum number of frames queued or in flight. Defaults to 16.
+         * \param gap_samples [Optional] Zero samples sent after each frame so that the receiver
+         *  sees frames back to back but still separated. Defaults to 80 (16 us at 5 MHz).
+         *
+         *  Frames passed to #submit_frame() are built by a pool of builder threads, each with its own
+         *  frame_builder, while a streaming thread sends the built frames in submission order. The
+         *  frames are sent back to back in one burst for as long as the queue has a frame ready, so
+         *  building and transmission overlap. All buffers are allocated here.
+         *  Do not mix #send_frame() with the asynchronous pipeline.
+         */
+        void start_async(int num_builders = 2, int queue_depth = 16, int gap_samples = 80);
+
+        /*!
+         * \brief Stops the asynchronous pipeline. Frames that were already built are still sent.
+         *
+         *  Safe to call while other threads are submitting: blocked submitters return false.
+         */
+        void stop_async();
+
+        /*!
+         * \brief Queues a frame for the asynchronous pipeline.
+         * \param payload The data to be transmitted (i.e. the MPDU), at most MAX_FRAME_SIZE bytes
+         * \param phy_rate [Optional] The PHY data rate to transmit at - defaults to 1/2 BPSK
+         * \param wait [Optional] Block while the queue is full. If false a full queue rejects the frame.
+         * \return Whether the frame was queued. False if the pipeline is stopped while waiting.
+         */
+        bool submit_frame(const std::vector<unsigned char> & payload, Rate phy_rate = RATE_1_2_BPSK, bool wait = true);
+
+        /*!
+         * \brief Queues one aggregated frame holding as many MPDUs as fit (see aggregator).
+         * \param mpdus The MPDUs waiting to be sent.
+         * \param first Index of the first MPDU to send.
+         * \param phy_rate [Optional] The PHY data rate to transmit at - defaults to 1/2 BPSK
+         * \param wait [Optional] Block while the queue is full. If false a full queue rejects the frame.
+         * \return The number of MPDUs starting at first that were queued, 0 if none.
+         *
+         *  One preamble, SIGNAL symbol and tail/pad is shared by all the MPDUs in the frame.
+         */
+        int submit_aggregate(const std::vector<std::vector<unsigned char> > & mpdus, int first,
+                             Rate phy_rate = RATE_1_2_BPSK, bool wait = true);
+
+        /*!
+         * \brief Sends every packet committed to a tx_queue, in order, without copying it.
+         * \param queue The queue, which must outlive the pipeline. Call after #start_async().
+         *
+         *  A feeder thread moves packets from the queue into the frame queue. The builders read the
+         *  header and body of each packet in place and the packet is released (from the streaming
+         *  thread) once its frame has been handed to the radio, so the producer's buffers stay in
+         *  use for as long as the frame is in flight. Frames from #submit_frame() are still accepted
+         *  and are interleaved in submission order. Only one queue can be attached.
+         */
+        void attach_queue(tx_queue * queue);
+
+        /*!
+         * \brief Blocks until every queued frame has been handed to the radio.
+         */
+        void flush();
+
+        /*!
+         * \brief Sets a function that is called from the streaming thread after each frame is sent.
+         * \param callback The callback, or an empty function to remove it. Set it before #start_async().
+         */
+        void set_report_callback(std::function<void(const tx_frame_report &)> callback) { m_report_callback = callback; }
+
+        /*!
+         * \brief Gets the running totals of the asynchronous pipeline.
+         */
+        tx_stats get_stats();
+
     private:
 
-        usrp m_usrp; //!< The usrp object used to send the generated frames over the air
+        /*!
+         * \brief One entry of the frame queue. The buffers are allocated once and reused.
+         */
+        struct tx_slot
+        {
+            std::vector<unsigned char> payload;                 //!< Copy of the submitted payload
+            tx_packet * packet;                                 //!< Packet from the attached tx_queue instead of #payload, or nullptr
+            Rate rate;                                          //!< PHY Rate of the frame
+            unsigned short service;                             //!< SERVICE field of the frame
+            std::vector<std::complex<double> > samples;         //!< Built frame, sized for the longest frame
+            int num_samples;                                    //!< Number of valid samples
+            boost::posix_time::ptime enqueued;                  //!< Time of submit_frame()
+            boost::posix_time::ptime built;                     //!< Time the frame was built
+            sem_t ready;                                        //!< Posted when the frame is built
+        };
+
+        /*!
+         * \brief Builder thread: takes the next queued frame and builds it into its slot.
+         * \param builder The frame builder owned by this thread.
+         */
+        void run_builder(frame_builder * builder);
+
+        /*!
+         * \brief Streaming thread: sends built frames in submission order.
+         */
+        void run_streamer();
+
+        /*!
+         * \brief Feeder thread: moves packets from the attached tx_queue into the frame queue.
+         */
+        void run_feeder();
+
+        /*!
+         * \brief Waits for a free slot while the pipeline is running.
+         * \return false if the pipeline stopped.
+         */
+        bool wait_free_slot();
+
+        std::shared_ptr<radio> m_radio; //!< The radio used to send the generated frames (a usrp unless one was passed in)
 
         frame_builder m_frame_builder; //!< The frame builder object used to generate the frames
 
+        std::vector<tx_slot> m_slots;                               //!< Frame queue, used as a ring
+        std::vector<std::unique_ptr<frame_builder> > m_builders;    //!< One frame builder per builder thread
+        std::vector<std::thread> m_builder_threads;                 //!< The builder threads
+        std::thread m_streamer_thread;                              //!< The streaming thread
+        std::thread m_feeder_thread;                                //!< Moves packets from #m_queue, if one is attached
+        tx_queue * m_queue;                                         //!< The attached tx_queue, or nullptr
+        std::vector<std::complex<double> > m_gap;                   //!< Zero samples sent between frames
+
+        sem_t m_free_sem;                           //!< Counts free slots
+        sem_t m_build_sem;                          //!< Counts queued frames that are not built yet
+        std::mutex m_submit_mutex;                  //!< Serializes submitters
+        std::mutex m_build_mutex;                   //!< Protects #m_build_next
+        std::mutex m_stats_mutex;                   //!< Protects #m_stats
+        std::atomic<unsigned long long> m_head;     //!< Sequence number of the next submitted frame
+        unsigned long long m_build_next;            //!< Sequence number of the next frame to build
+        std::atomic<unsigned long long> m_tx_next;  //!< Sequence number of the next frame to send
+        std::atomic<bool> m_running;                //!< Whether the asynchronous pipeline is running
+        std::atomic<int> m_submitters;              //!< submit_frame() / submit_aggregate() calls in progress
+
+        tx_stats m_stats;                                           //!< Running totals
+        std::function<void(const tx_frame_report &)> m_report_callback; //!< Per frame callback
+
     };
 
 }
@@ -0,0 +1,115 @@
+/*! \file tx_queue.h
+ *  \brief Header file for the tx_queue class and the tx_packet struct.
+ *
+ *  The tx_queue class is a single producer, single consumer queue of packets to transmit.
+ *  A packet is a small header copied into the queue plus a body that stays in the producer's
+ *  buffer (e.g. the data of an encoded AVPacket), so an in-process source such as the video
+ *  encoder can hand packets to the transmitter without sockets and without copying them.
+ */
+
+#ifndef TX_QUEUE_H
+#define TX_QUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <semaphore.h>
+#include "rates.h"
+
+#define TX_PACKET_HEADER_SIZE 16 //!< Largest header that is copied into a tx_packet
+
+namespace fun
+{
+    /*!
+     * \brief One packet in a tx_queue. The slots are allocated once and reused.
+     *
+     *  The PPDU payload is header followed by body. The body is read in place until the packet
+     *  is released, at which point #release is called so that the producer can reuse the buffer.
+     */
+    struct tx_packet
+    {
+        unsigned char header[TX_PACKET_HEADER_SIZE];    //!< Copied header, e.g. an RTP header and the FU-A bytes
+        int header_length;                              //!< Valid bytes in #header
+        const unsigned char * body;                     //!< Rest of the payload, owned by the producer
+        int body_length;                                //!< Length of #body in bytes
+        Rate rate;                                      //!< PHY Rate to send the packet at
+        long long origin_us;                            //!< tx_queue::now_us() time the latency is measured from
+        void (*release)(void * context);                //!< Called once the packet has been sent, may be nullptr
+        void * context;                                 //!< Passed to #release
+    };
+
+    /*!
+     * \brief The tx_queue class
+     *
+     *  Producer side: #write_slot(), fill it, #commit(). Consumer side: #acquire(), use the packet,
+     *  #release(). Unlike rx_ring the consumer may hold several packets at once (the transmitter
+     *  keeps one per frame in flight); #release() always releases the oldest one. Acquiring and
+     *  releasing may happen on different consumer threads. The positions are atomics, only the
+     *  consumer can block (on a semaphore).
+     */
+    class tx_queue
+    {
+    public:
+
+        /*!
+         * \brief Constructor for tx_queue.
+         * \param capacity Number of packet slots. Packets stay in their slot until they are sent,
+         *  so this should cover the transmitter queue depth plus one video frame worth of packets.
+         */
+        tx_queue(int capacity);
+
+        /*!
+         * \brief Destructor, releases every packet that was committed but not released.
+         */
+        ~tx_queue();
+
+        tx_queue(const tx_queue &) = delete;
+        tx_queue & operator=(const tx_queue &) = delete;
+
+        /*!
+         * \brief Gets the number of slots the producer can write without waiting (producer).
+         */
+        int free_slots() const;
+
+        /*!
+         * \brief Gets the next slot to write (producer).
+         * \return The slot, or nullptr if every slot is in use.
+         */
+        tx_packet * write_slot();
+
+        /*!
+         * \brief Publishes the slot returned by #write_slot() (producer).
+         */
+        void commit();
+
+        /*!
+         * \brief Gets the oldest committed packet that has not been acquired yet (consumer).
+         * \param timeout_ms How long to wait for a packet, in milliseconds.
+         * \return The packet, valid until it is released, or nullptr if none arrived within timeout_ms.
+         */
+        tx_packet * acquire(int timeout_ms);
+
+        /*!
+         * \brief Releases the oldest acquired packet and calls its release function (consumer).
+         */
+        void release();
+
+        int capacity() const { return m_packets.size(); } //!< Get the number of slots
+
+        /*!
+         * \brief Gets the time used for tx_packet::origin_us.
+         * \return CLOCK_MONOTONIC in microseconds, the same clock as std::chrono::steady_clock.
+         */
+        static long long now_us();
+
+    private:
+
+        std::vector<tx_packet> m_packets;                       //!< The slots
+        sem_t m_available;                                      //!< Counts committed packets not acquired yet
+        unsigned long long m_acquired;                          //!< Packets acquired by the consumer (acquiring thread only)
+
+        alignas(64) std::atomic<unsigned long long> m_write;   //!< Packets committed by the producer
+        alignas(64) std::atomic<unsigned long long> m_read;    //!< Packets released by the consumer
+    };
+}
+
+#endif // TX_QUEUE_H
@@ -17,6 +17,11 @@
 #include <semaphore.h>
 #include <memory>
 
+#include "sample_convert.h"
+#include "radio.h"
+
+#define USRP_CONVERT_CHUNK 8192 //!< Samples converted per UHD call, small enough to stay in cache
+
 namespace fun
 {
     /*!
@@ -31,6 +36,7 @@ namespace fun
         double rx_gain;             //!< Receive Gain  
         double tx_amp;              //!< Transmit Amplitude  在发送到 USRP 之前对所有发送采样进行缩放
         std::string device_addr;    //!< IP Address of USRP as a string - i.e. "192.168.10.2" or "" to find automatically
+        sample_format format;       //!< Host sample format handed to UHD, converted from/to complex doubles by us
 
         /*!
          * \brief usrp_params 的构造函数。只需初始化成员字段，以便稍后查找。
@@ -40,14 +46,17 @@ namespace fun
          * \param rx_gain -> #rx_gain
          * \param tx_amp -> #tx_amp
          * \param device_addr -> #device_addr
+         * \param format -> #format
          */
-        usrp_params(double freq = 5.72e9, double rate = 5e6, double tx_gain=20, double rx_gain=20, double tx_amp=1.0, std::string device_addr="") :
+        usrp_params(double freq = 5.72e9, double rate = 5e6, double tx_gain=20, double rx_gain=20, double tx_amp=1.0, std::string device_addr="",
+                    sample_format format = FORMAT_FC32) :
             freq(freq),
             rate(rate),
             tx_gain(tx_gain),
             rx_gain(rx_gain),
             tx_amp(tx_amp),
-            device_addr(device_addr)
+            device_addr(device_addr),
+            format(format)
         {
         }
     };
@@ -57,7 +66,7 @@ namespace fun
      *
      *  usrp 类是 UHD 应用程序接口的封装类。它提供了一个向 USRP 发送和接收采样的简单接口。
      */
-    class usrp
+    class usrp : public radio
     {
     public:
 
@@ -73,22 +82,74 @@ namespace fun
          * \brief 发送采样脉冲串，并阻塞直到脉冲串结束
          * \param samples A vector of complex doubles，代表 USRP 上变频和传输的基带时域信号。
          */
-        void send_burst_sync(std::vector<std::complex<double> > samples);
+        void send_burst_sync(const std::vector<std::complex<double> > & samples) override;
 
         /*!
          * \brief 发送采样脉冲串，但在脉冲串结束前不阻塞。
          * \param samples A vector of complex doubles，代表 USRP 上变频和传输的基带时域信号。
          */
-        void send_burst(std::vector<std::complex<double> > samples);
+        void send_burst(const std::vector<std::complex<double> > & samples) override;
+
+        /*!
+         * \brief 将样本作为连续流的一部分发送，不阻塞等待 ACK。
+         * \param samples 基带时域样本，发送时按 tx_amp 缩放。
+         * \param num_samples 样本数量，可以为 0（例如只发送 end_of_burst）。
+         * \param start_of_burst 是否是一个脉冲串的第一段。
+         * \param end_of_burst 是否是一个脉冲串的最后一段。
+         *
+         *  连续调用时各帧首尾相接地发送，中间没有空闲时间。
+         */
+        void send_samples(const std::complex<double> * samples, int num_samples, bool start_of_burst, bool end_of_burst) override;
+
+        /*!
+         * \brief 在设备时间 time 发送一个完整的脉冲串，不等待发送时间。
+         * \param samples 基带时域样本。
+         * \param time 第一个样本的设备时间，见 #get_time_now()。
+         * \return 总是 true，迟到的脉冲串由 USRP 异步报告，见 #poll_late_bursts()。
+         */
+        bool send_burst_at(const std::vector<std::complex<double> > & samples, uhd::time_spec_t time);
+
+        /*!
+         * \brief 同上，时间以秒表示。
+         */
+        bool send_burst_at(const std::vector<std::complex<double> > & samples, double time) override;
+
+        /*!
+         * \brief 非阻塞地读取所有待处理的 TX 异步消息。
+         * \return 自上次调用以来报告的下溢（underflow）次数。
+         */
+        int poll_underflows() override;
+
+        /*!
+         * \brief 非阻塞地读取所有待处理的 TX 异步消息。
+         * \return 自上次调用以来 USRP 报告的迟到（EVENT_CODE_TIME_ERROR）脉冲串数量。
+         */
+        int poll_late_bursts() override;
+
+        /*!
+         * \brief 获取 USRP 的设备时间，构造时被设为 0。
+         */
+        double get_time_now() override { return m_usrp->get_time_now().get_real_secs(); }
+
+        double get_rate() const override { return m_params.rate; }      //!< Get the sample rate
+        double get_tx_amp() const override { return m_params.tx_amp; }  //!< Get the transmit amplitude
 
-        //  从 USRP 获取一些 sample
         /*!
-         * \brief 获取 num_samples个样本，并将其放入缓冲区的前num_samples的位置。
-         * \param num_samples 从 USRP 提取的样本数量。
-         * \param buffer 放置检索到的样本的缓冲区。
+         * \brief 析构函数，停止 RX 线程。
          */
-        void get_samples(int num_samples, std::vector<std::complex<double> > & buffer);
+        ~usrp();
+
+    protected:
 
+        /*!
+         * \brief 接收最多 num_samples 个样本并转换成 complex doubles，同时记录 recv 的错误码。
+         * \param num_samples 最多接收的样本数量。
+         * \param buffer 转换后的样本。
+         * \param has_time 第一个样本是否带有时间戳。
+         * \param time 第一个样本的设备时间（秒）。
+         * \return 实际接收的样本数量，超时或溢出时可能少于 num_samples。
+         */
+        int receive(int num_samples, std::complex<double> * buffer, bool & has_time, double & time) override;
 
     private:
 
@@ -101,6 +162,28 @@ namespace fun
         uhd::tx_streamer::sptr m_tx_streamer;            //!<  RX (input) streamer
 
         sem_t m_tx_sem;                                  //!< Sempahore used to block for #send_burst_sync
+
+        std::vector<std::complex<double> > m_tx_buffer;  //!< Reused conversion buffer for the host format, #USRP_CONVERT_CHUNK samples
+        std::vector<std::complex<double> > m_rx_buffer;  //!< Reused conversion buffer for the host format, #USRP_CONVERT_CHUNK samples
+
+        /*!
+         * \brief 按 tx_amp 缩放并转换成主机格式后分块发送。
+         * \param samples 基带时域样本。
+         * \param num_samples 样本数量，可以为 0。
+         * \param start_of_burst 第一块是否标记为脉冲串开始。
+         * \param end_of_burst 最后一块是否标记为脉冲串结束。
+         * \param time 如果不为 nullptr，第一块在这个设备时间发送。
+         */
+        void send_converted(const std::complex<double> * samples, int num_samples, bool start_of_burst, bool end_of_burst,
+                            const uhd::time_spec_t * time = nullptr);
+
+        /*!
+         * \brief 读取所有待处理的 TX 异步消息并累加到计数器中。
+         */
+        void poll_async();
+
+        std::atomic<int> m_underflows;   //!< Underflows read by #poll_async() but not returned yet
+        std::atomic<int> m_late;         //!< Late bursts read by #poll_async() but not returned yet
     };
 
 }
@@ -19,6 +19,8 @@
 #include <xmmintrin.h>
 #include <mmintrin.h>
 
+#include "puncturer.h"
+
 #define K 7
 #define RATE 2
 #define POLYS { 121, 91 }
@@ -71,7 +73,7 @@ namespace fun
               unsigned int nbits, /* Number of data bits */
               unsigned int endstate) ;
 
-        void FULL_SPIRAL(int nbits, unsigned char *Y, unsigned char *X, const unsigned char *syms, unsigned char *dec, unsigned char *Branchtab);
+        void FULL_SPIRAL(int nbits, unsigned char *Y, unsigned char *X, const unsigned char *syms, unsigned char *dec, unsigned char *Branchtab, puncture_pattern punc);
 
         /*!
          * \brief Create a new instance of a Viterbi decoder
@@ -97,14 +99,15 @@ namespace fun
          * \param vp Pointer to v struct used to store parameters and help with decoding
          * \param symbols Input symbol to be decoded
          * \param data Output data that has been decoded
+         * \param punc Puncture pattern of the input symbols, holes are treated as erasures
          *
          * NOTE: nbits has to match what was passed to viterbi_alloc(...)
          * FIXME: store nbits in struct v?
          */
-        void viterbi_decode(struct v *vp, const COMPUTETYPE *symbols, unsigned char *data, int nbits);
+        void viterbi_decode(struct v *vp, const COMPUTETYPE *symbols, unsigned char *data, int nbits, puncture_pattern punc);
 
         /*! \brief set the viterbi decoder to use a specific implementation */
-        void viterbi_update_blk_SPIRAL(struct v *vp, const COMPUTETYPE *syms, int nbits);
+        void viterbi_update_blk_SPIRAL(struct v *vp, const COMPUTETYPE *syms, int nbits, puncture_pattern punc);
         //void viterbi_spiral(struct v *vp);
 
     public:
@@ -117,6 +120,19 @@ namespace fun
          */
         void conv_decode(unsigned char * symbols, unsigned char * data, int data_bits);
 
+        /*!
+         * \brief Decodes punctured convolutionally encoded data without depuncturing it first.
+         * \param symbols Punctured coded symbols straight from the deinterleaver.
+         * \param data Output data that has been decoded.
+         * \param data_bits Number of data bits that that should be left after decoding
+         * \param rate PHY Rate from which the puncture pattern is extracted.
+         *
+         *  The puncture holes are filled with the neutral soft value 127 inside the branch
+         *  metric step, so the output is identical to puncturer::depuncture() followed by
+         *  conv_decode() but without the intermediate buffer.
+         */
+        void conv_decode(const unsigned char * symbols, unsigned char * data, int data_bits, Rate rate);
+
         /*!
          * \brief Convolutionally encodeds data.
          * \param data The data to be coded.
@@ -0,0 +1,349 @@
+#include "rtpDepacketizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <time.h>
+
+// 回收的访问单元缓冲区最多保留几个，输出队列最多几帧（解码器跟不上时丢掉最旧的）
+static const size_t MAX_FREE_BUFFERS = 8;
+static const size_t MAX_READY_FRAMES = 16;
+
+static inline uint16_t read16(const uint8_t* p) { return (p[0] << 8) | p[1]; }
+static inline uint32_t read32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+RtpDepacketizer::RtpDepacketizer(int latencyMs, size_t capacity, int payloadType)
+: latencyUs_(std::max(latencyMs, 0) * 1000), payloadType_(payloadType) {
+    size_t n = 16;
+    while (n < capacity && n < 32768) n <<= 1;   // 窗口必须小于序列号空间的一半
+    slots_.resize(n);
+    mask_ = n - 1;
+}
+
+int64_t RtpDepacketizer::nowUs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void RtpDepacketizer::push(const uint8_t* data, size_t size) {
+    std::vector<unsigned char> packet(data, data + size);
+    int64_t now = nowUs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    insert(packet, now);
+    advance(now, false);
+    // 起始缓冲或新出现的缺口有了截止时间，让等待中的 pop() 按新的截止时间醒来
+    if (deadlineUs() >= 0) ready_cv_.notify_one();
+}
+
+void RtpDepacketizer::push(std::vector<std::vector<unsigned char>>& packets) {
+    int64_t now = nowUs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& packet : packets) insert(packet, now);
+    advance(now, false);
+    packets.clear();
+    if (deadlineUs() >= 0) ready_cv_.notify_one();
+}
+
+bool RtpDepacketizer::parse(const std::vector<unsigned char>& packet, uint16_t& seq) const {
+    if (packet.size() < RTP_HEADER_SIZE || (packet[0] >> 6) != 2) return false;
+    if (payloadType_ >= 0 && (packet[1] & 0x7F) != payloadType_) return false;
+    seq = read16(&packet[2]);
+    return true;
+}
+
+void RtpDepacketizer::insert(std::vector<unsigned char>& packet, int64_t now) {
+    uint16_t seq;
+    if (!parse(packet, seq)) {
+        stats_.invalid++;
+        return;
+    }
+
+    uint32_t ssrc = read32(&packet[8]);
+    if (started_ && ssrc != ssrc_) {
+        // 发送端重启或换了一个流，之前的包都作废
+        abortFrame();
+        clearBuffer();
+        stats_.resyncs++;
+        started_ = false;
+    }
+    if (!started_) {
+        started_ = true;
+        priming_ = true;
+        primeUntil_ = now + latencyUs_;
+        ssrc_ = ssrc;
+        nextSeq_ = seq;
+        highestSeq_ = seq;
+        gapSince_ = -1;
+    }
+
+    int ahead = static_cast<int16_t>(seq - nextSeq_);
+    if (priming_ && ahead < 0 && static_cast<size_t>(static_cast<int16_t>(highestSeq_ - seq)) <= mask_) {
+        // 还在起始缓冲期，乱序先到的不是第一个包，起点往前移
+        nextSeq_ = seq;
+        ahead = 0;
+    }
+    if (ahead < 0 && static_cast<size_t>(-ahead) <= mask_) {
+        // 这个序列号已经输出或者跳过了
+        stats_.late++;
+        return;
+    }
+    if (static_cast<size_t>(std::abs(ahead)) > mask_) {
+        // 离缓冲区太远：中间丢了一大段或者发送端的序列号重新开始，从这个包重新同步，当前帧肯定不完整
+        abortFrame();
+        clearBuffer();
+        stats_.resyncs++;
+        nextSeq_ = seq;
+        highestSeq_ = seq;
+        gapSince_ = -1;
+        corrupt_ = true;
+    }
+
+    Slot& slot = slots_[seq & mask_];
+    if (slot.present) {
+        stats_.duplicates++;
+        return;
+    }
+    if (static_cast<int16_t>(seq - highestSeq_) > 0) highestSeq_ = seq;
+    else if (seq != highestSeq_) stats_.reordered++;
+
+    stats_.packets++;
+    stats_.bytes += packet.size();
+    slot.packet.swap(packet);
+    slot.present = true;
+    slot.arrivalUs = now;
+    count_++;
+}
+
+int64_t RtpDepacketizer::deadlineUs() const {
+    if (priming_) return primeUntil_;
+    return gapSince_ < 0 ? -1 : gapSince_ + latencyUs_;
+}
+
+void RtpDepacketizer::advance(int64_t now, bool force) {
+    now_ = now;
+    if (priming_) {
+        if (!force && now < primeUntil_) return;
+        priming_ = false;
+    }
+
+    while (count_ > 0) {
+        Slot& slot = slots_[nextSeq_ & mask_];
+        if (slot.present) {
+            consume(slot);
+            slot.present = false;
+            count_--;
+            nextSeq_++;
+            gapSince_ = -1;
+            continue;
+        }
+
+        // nextSeq_ 缺失而后面已经有包：从缺口后第一个包到达时开始计时
+        if (gapSince_ < 0) {
+            for (uint16_t seq = nextSeq_ + 1; ; seq++) {
+                const Slot& next = slots_[seq & mask_];
+                if (next.present) {
+                    gapSince_ = next.arrivalUs;
+                    break;
+                }
+            }
+        }
+        if (!force && now < gapSince_ + latencyUs_) break;
+
+        // 等不到了，跳过这个序列号，它所在的帧不能输出
+        stats_.lost++;
+        corrupt_ = true;
+        nextSeq_++;
+    }
+    if (count_ == 0) gapSince_ = -1;
+}
+
+void RtpDepacketizer::consume(Slot& slot) {
+    const std::vector<unsigned char>& p = slot.packet;
+    size_t offset = RTP_HEADER_SIZE + 4 * (p[0] & 0x0F);   // CSRC
+    size_t end = p.size();
+    if ((p[0] & 0x10) && offset + 4 <= end) offset += 4 + 4 * read16(&p[offset + 2]);   // 扩展头
+    if ((p[0] & 0x20) && end > 0) end -= std::min<size_t>(p[end - 1], end);              // 填充
+    if (offset >= end) {
+        stats_.invalid++;
+        return;
+    }
+
+    bool marker = p[1] & 0x80;
+    uint32_t timestamp = read32(&p[4]);
+
+    if (assembling_ && timestamp != current_.timestamp) {
+        // 时间戳变了却没有见到 marker：marker 包丢了。缺的包可能属于上一帧也可能属于这一帧，两帧都不输出
+        bool lost = corrupt_;
+        finishFrame();
+        corrupt_ = lost;
+    }
+    if (!assembling_) {
+        assembling_ = true;
+        inFragment_ = false;
+        current_.timestamp = timestamp;
+        current_.keyframe = false;
+        current_.arrivalUs = slot.arrivalUs;
+        if (current_.data.capacity() == 0 && !freeBuffers_.empty()) {
+            current_.data.swap(freeBuffers_.back());
+            freeBuffers_.pop_back();
+        }
+        current_.data.clear();
+    }
+
+    depacketize(p.data() + offset, end - offset);
+    if (marker) finishFrame();
+}
+
+void RtpDepacketizer::depacketize(const uint8_t* payload, size_t size) {
+    uint8_t type = payload[0] & 0x1F;
+
+    if (type >= 1 && type <= 23) {
+        if (inFragment_) {
+            // 上一个 FU-A 没有结束分片
+            corrupt_ = true;
+            inFragment_ = false;
+        }
+        appendNal(payload, size);
+    } else if (type == 24) {
+        // STAP-A：每个 NAL 前有 2 字节长度
+        size_t pos = 1;
+        while (pos + 2 <= size) {
+            size_t n = read16(payload + pos);
+            pos += 2;
+            if (n == 0 || pos + n > size) {
+                stats_.invalid++;
+                corrupt_ = true;
+                break;
+            }
+            appendNal(payload + pos, n);
+            pos += n;
+        }
+    } else if (type == 28 && size >= 2) {
+        uint8_t fu = payload[1];
+        if (fu & 0x80) {
+            if (inFragment_) corrupt_ = true;
+            // 还原 NAL 头：F/NRI 来自 FU indicator，类型来自 FU header
+            uint8_t header = (payload[0] & 0xE0) | (fu & 0x1F);
+            static const uint8_t start_code[4] = {0, 0, 0, 1};
+            current_.data.insert(current_.data.end(), start_code, start_code + 4);
+            current_.data.push_back(header);
+            if ((fu & 0x1F) == 5 || (fu & 0x1F) == 7) current_.keyframe = true;
+            inFragment_ = true;
+        } else if (!inFragment_) {
+            // 前面的分片丢了（或者从分片中间开始接收）
+            corrupt_ = true;
+            return;
+        }
+        current_.data.insert(current_.data.end(), payload + 2, payload + size);
+        if (fu & 0x40) inFragment_ = false;
+    } else {
+        stats_.invalid++;
+    }
+}
+
+void RtpDepacketizer::appendNal(const uint8_t* nal, size_t size) {
+    static const uint8_t start_code[4] = {0, 0, 0, 1};
+    current_.data.insert(current_.data.end(), start_code, start_code + 4);
+    current_.data.insert(current_.data.end(), nal, nal + size);
+    uint8_t type = nal[0] & 0x1F;
+    if (type == 5 || type == 7) current_.keyframe = true;
+}
+
+void RtpDepacketizer::finishFrame() {
+    if (!assembling_) return;
+    if (inFragment_) corrupt_ = true;   // 最后一个 FU-A 没有结束分片
+
+    if (corrupt_ || current_.data.empty()) {
+        if (corrupt_) stats_.framesDropped++;
+        current_.data.clear();
+    } else {
+        int64_t delay = now_ - current_.arrivalUs;
+        stats_.accessUnits++;
+        totalDelayUs_ += delay;
+        stats_.maxDelayUs = std::max(stats_.maxDelayUs, delay);
+
+        if (ready_.size() >= MAX_READY_FRAMES) {
+            // 解码器跟不上，丢掉最旧的帧
+            if (freeBuffers_.size() < MAX_FREE_BUFFERS) freeBuffers_.push_back(std::move(ready_.front().data));
+            ready_.pop_front();
+            stats_.framesDropped++;
+        }
+        ready_.push_back(std::move(current_));
+        current_ = AccessUnit();
+        ready_cv_.notify_one();
+    }
+
+    assembling_ = false;
+    corrupt_ = false;
+    inFragment_ = false;
+}
+
+void RtpDepacketizer::abortFrame() {
+    if (assembling_) stats_.framesDropped++;
+    current_.data.clear();
+    assembling_ = false;
+    corrupt_ = false;
+    inFragment_ = false;
+}
+
+void RtpDepacketizer::clearBuffer() {
+    for (auto& slot : slots_) slot.present = false;
+    count_ = 0;
+    gapSince_ = -1;
+}
+
+bool RtpDepacketizer::pop(AccessUnit& au, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeoutMs, 0));
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // 没有新包到达时缺口的截止时间也要在这里检查
+        advance(nowUs(), false);
+        if (!ready_.empty()) {
+            if (au.data.capacity() > 0 && freeBuffers_.size() < MAX_FREE_BUFFERS) freeBuffers_.push_back(std::move(au.data));
+            au = std::move(ready_.front());
+            ready_.pop_front();
+            return true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) return false;
+        auto wake = deadline;
+        int64_t gap = deadlineUs();
+        if (gap >= 0) wake = std::min(wake, now + std::chrono::microseconds(std::max<int64_t>(gap - nowUs(), 0) + 100));
+        ready_cv_.wait_until(lock, wake);
+    }
+}
+
+void RtpDepacketizer::drain() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    advance(nowUs(), true);
+    finishFrame();
+}
+
+void RtpDepacketizer::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    abortFrame();
+    clearBuffer();
+    ready_.clear();
+    started_ = false;
+    priming_ = false;
+}
+
+void RtpDepacketizer::setLatency(int latencyMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latencyUs_ = std::max(latencyMs, 0) * 1000;
+}
+
+size_t RtpDepacketizer::buffered() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+DepacketizerStats RtpDepacketizer::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DepacketizerStats stats = stats_;
+    stats.meanDelayUs = stats.accessUnits ? static_cast<double>(totalDelayUs_) / stats.accessUnits : 0.0;
+    return stats;
+}
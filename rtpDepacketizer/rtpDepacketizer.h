@@ -0,0 +1,125 @@
+#ifndef RTP_DEPACKETIZER_H
+#define RTP_DEPACKETIZER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+struct DepacketizerStats {
+    uint64_t packets;          // 收到的有效 RTP 包数
+    uint64_t bytes;            // 收到的字节数，包括 RTP 头
+    uint64_t accessUnits;      // 输出的完整访问单元数
+    uint64_t framesDropped;    // 因为缺包（超过延迟窗口仍未补齐）丢掉的不完整帧数
+    uint64_t lost;             // 超过延迟窗口仍未到达、被跳过的序列号数
+    uint64_t late;             // 对应的序列号已经被跳过或输出后才到达的包数
+    uint64_t reordered;        // 比已收到的最大序列号小、但还来得及放进缓冲区的包数
+    uint64_t duplicates;       // 重复的包数
+    uint64_t invalid;          // 不是 RTP、负载类型/SSRC 不对或无法解析的包数
+    uint64_t resyncs;          // 序列号跳得太远、清空缓冲区重新同步的次数
+    int64_t maxDelayUs;        // 访问单元从第一个包到达到输出的最大延迟
+    double meanDelayUs;
+};
+
+// 输出给解码器的访问单元：Annex B 字节流（每个 NAL 前加 00 00 00 01），FU-A 已经重组
+struct AccessUnit {
+    std::vector<uint8_t> data;
+    uint32_t timestamp = 0;     // RTP 时间戳，90 kHz
+    bool keyframe = false;      // 是否包含 IDR 或 SPS
+    int64_t arrivalUs = 0;      // 第一个包到达的时间（CLOCK_MONOTONIC）
+};
+
+// H.264 的 RTP 解包和抖动缓冲（RFC 6184：单 NAL 包、STAP-A 和 FU-A），是 RtpPacketizer 的接收端。
+// 包按序列号放进一个固定大小的环形缓冲区，按顺序取出、重组成访问单元（marker 或时间戳变化时结束）。
+// 序列号出现缺口时最多等待 latencyMs：缺的包在此期间到达就正常输出，否则跳过缺口，
+// 缺口所在的帧整帧丢掉，从下一帧开始继续输出，解码器不会收到残缺的帧。
+// 流开始时先缓冲一个延迟窗口，以窗口内最小的序列号作为起点。
+// push() 在接收线程调用（receiver 的回调），pop() 在解码线程调用，两者线程安全。
+class RtpDepacketizer {
+    public:
+        // latencyMs 是等待乱序或缺失包的最长时间；capacity 是缓冲区的包数，向上取 2 的幂，
+        // 要能放下延迟窗口内到达的所有包。payloadType 为负时不检查负载类型
+        RtpDepacketizer(int latencyMs = 50, size_t capacity = 1024, int payloadType = 96);
+
+        RtpDepacketizer(const RtpDepacketizer&) = delete;
+        RtpDepacketizer& operator=(const RtpDepacketizer&) = delete;
+
+        // 加入一个 RTP 包（会拷贝）
+        void push(const uint8_t* data, size_t size);
+
+        // 加入 receiver 回调收到的一批负载，包的内容被移进缓冲区（不拷贝），packets 之后为空
+        void push(std::vector<std::vector<unsigned char>>& packets);
+
+        // 取出下一个完整的访问单元，最多等待 timeoutMs 毫秒（0 表示不等待）。
+        // au.data 原来的缓冲区会被回收复用，所以反复用同一个 AccessUnit 调用时不分配内存
+        bool pop(AccessUnit& au, int timeoutMs);
+
+        // 不再等待缺失的包，把缓冲区里剩下的包全部处理掉（例如流结束时）
+        void drain();
+
+        // 清空缓冲区，下一个包作为新流的开始
+        void reset();
+
+        // 运行中修改延迟窗口
+        void setLatency(int latencyMs);
+
+        size_t buffered() const;   // 缓冲区里等待的包数
+        DepacketizerStats getStats() const;
+
+        static int64_t nowUs();
+
+    private:
+        static const size_t RTP_HEADER_SIZE = 12;
+
+        struct Slot {
+            std::vector<unsigned char> packet;   // 整个 RTP 包，只增长不收缩
+            bool present = false;
+            int64_t arrivalUs = 0;
+        };
+
+        void insert(std::vector<unsigned char>& packet, int64_t now);
+        void advance(int64_t now, bool force);
+        void consume(Slot& slot);
+        void depacketize(const uint8_t* payload, size_t size);
+        void appendNal(const uint8_t* nal, size_t size);
+        void finishFrame();
+        void abortFrame();
+        void clearBuffer();
+        bool parse(const std::vector<unsigned char>& packet, uint16_t& seq) const;
+        int64_t deadlineUs() const;   // 当前缺口的截止时间，没有缺口时返回 -1
+
+        int latencyUs_;
+        int payloadType_;
+        uint32_t ssrc_ = 0;
+
+        mutable std::mutex mutex_;
+        std::condition_variable ready_cv_;
+
+        // 环形缓冲区，按序列号的低位索引
+        std::vector<Slot> slots_;
+        size_t mask_;
+        bool started_ = false;
+        bool priming_ = false;          // 收到第一个包后先缓冲一个延迟窗口，让更早的序列号有机会到达
+        int64_t primeUntil_ = 0;
+        uint16_t nextSeq_ = 0;          // 下一个要处理的序列号
+        uint16_t highestSeq_ = 0;       // 收到的最大序列号
+        size_t count_ = 0;              // 缓冲区里的包数
+        int64_t gapSince_ = -1;         // nextSeq_ 缺失、后面已有包在等待的起始时间
+        int64_t now_ = 0;               // 最近一次 advance() 的时间，用于计算输出延迟
+
+        // 正在重组的访问单元
+        AccessUnit current_;
+        bool assembling_ = false;
+        bool corrupt_ = false;          // 这一帧缺了包，结束时丢掉
+        bool inFragment_ = false;       // 正在重组 FU-A
+
+        std::deque<AccessUnit> ready_;
+        std::vector<std::vector<uint8_t>> freeBuffers_;   // 回收的访问单元缓冲区
+
+        DepacketizerStats stats_ = {};
+        int64_t totalDelayUs_ = 0;
+};
+
+#endif //RTP_DEPACKETIZER_H
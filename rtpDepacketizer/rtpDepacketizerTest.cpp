@@ -0,0 +1,204 @@
+// RtpDepacketizer 的测试：用 RtpPacketizer 打包一串访问单元，经过乱序、丢包、重复和迟到后
+// 交给 RtpDepacketizer，检查输出的访问单元和计数。不需要摄像头和 USRP。
+// 用法：rtpDepacketizerTest [帧数]
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include "rtpPacketizer.h"
+#include "rtpDepacketizer.h"
+
+using namespace std;
+
+typedef vector<vector<unsigned char>> PacketList;
+
+static const int LATENCY_MS = 20;
+static const size_t PRIME_PACKETS = 16;   // 推入这么多包后等起始缓冲结束，再继续全速推入
+
+// 构造一个 Annex B 访问单元：IDR 帧带 SPS/PPS，然后 slices 个 slice NAL。负载不含 0x00
+static vector<uint8_t> make_access_unit(size_t size, bool idr, int slices) {
+    vector<uint8_t> au;
+    auto add_nal = [&au](uint8_t header, size_t n) {
+        const uint8_t start_code[4] = {0, 0, 0, 1};
+        au.insert(au.end(), start_code, start_code + 4);
+        au.push_back(header);
+        for (size_t i = 1; i < n; i++) au.push_back(static_cast<uint8_t>(1 + rand() % 255));
+    };
+    if (idr) {
+        add_nal(0x67, 12);   // SPS
+        add_nal(0x68, 4);    // PPS
+    }
+    for (int s = 0; s < slices; s++) add_nal(idr ? 0x65 : 0x41, size / slices);
+    return au;
+}
+
+// 打包所有访问单元，frame_of 记录每个包属于第几帧
+static PacketList packetize_all(const vector<vector<uint8_t>>& frames, vector<int>& frame_of) {
+    PacketList packets;
+    int current = 0;
+    RtpPacketizer packetizer;
+    packetizer.setSink([&](const RtpPacketView* views, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            vector<unsigned char> packet(views[i].header, views[i].header + views[i].headerSize);
+            packet.insert(packet.end(), views[i].payload, views[i].payload + views[i].payloadSize);
+            packets.push_back(move(packet));
+            frame_of.push_back(current);
+        }
+        return count;
+    });
+    for (size_t f = 0; f < frames.size(); f++) {
+        current = static_cast<int>(f);
+        packetizer.packetize(frames[f].data(), frames[f].size(), static_cast<uint32_t>(f * 3000), true);
+    }
+    return packets;
+}
+
+// 取出已经能输出的访问单元，timeoutMs 大于延迟窗口时缺口会超时。
+// out 记录每个输出对应的帧号，-1 表示内容不匹配
+static void collect(RtpDepacketizer& depacketizer, const vector<vector<uint8_t>>& frames, vector<int>& out, int timeoutMs) {
+    AccessUnit au;
+    while (depacketizer.pop(au, timeoutMs)) {
+        int index = static_cast<int>(au.timestamp / 3000);
+        bool match = index < static_cast<int>(frames.size()) && au.data == frames[index];
+        out.push_back(match ? index : -1);
+    }
+}
+
+static bool check(const char* name, bool ok) {
+    cout << (ok ? "通过  " : "失败  ") << name << endl;
+    return ok;
+}
+
+static void print_stats(const DepacketizerStats& s) {
+    cout << "      包 " << s.packets << "，帧 " << s.accessUnits << "，丢帧 " << s.framesDropped
+         << "，丢包 " << s.lost << "，迟到 " << s.late << "，乱序 " << s.reordered
+         << "，重复 " << s.duplicates << "，延迟 平均 " << s.meanDelayUs << " us 最大 " << s.maxDelayUs << " us" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    int count = argc > 1 ? atoi(argv[1]) : 30;
+    srand(1);
+
+    vector<vector<uint8_t>> frames;
+    for (int f = 0; f < count; f++) {
+        bool idr = f % 10 == 0;
+        frames.push_back(make_access_unit(idr ? 12000 : 1500 + rand() % 3000, idr, 4));
+    }
+    vector<int> frame_of;
+    const PacketList packets = packetize_all(frames, frame_of);
+    cout << count << " 帧，" << packets.size() << " 个 RTP 包" << endl;
+
+    bool ok = true;
+    vector<int> all(count);
+    for (int f = 0; f < count; f++) all[f] = f;
+
+    // 1. 按顺序到达：所有帧逐字节相同
+    {
+        // 按帧成批推入，和 receiver 回调一样
+        RtpDepacketizer d(LATENCY_MS);
+        vector<int> out;
+        PacketList batch;
+        for (size_t i = 0; i < packets.size(); i++) {
+            batch.push_back(packets[i]);
+            if (i + 1 == packets.size() || frame_of[i + 1] != frame_of[i]) {
+                d.push(batch);
+                collect(d, frames, out, i + 1 >= PRIME_PACKETS && out.empty() ? 2 * LATENCY_MS : 0);
+            }
+        }
+        collect(d, frames, out, 2 * LATENCY_MS);
+        ok &= check("按序到达", out == all && d.getStats().framesDropped == 0);
+        print_stats(d.getStats());
+    }
+
+    // 2. 每 8 个包倒序到达（在延迟窗口内）：重新排序，结果不变
+    {
+        RtpDepacketizer d(LATENCY_MS);
+        PacketList batch = packets;
+        for (size_t i = 0; i + 8 <= batch.size(); i += 8) reverse(batch.begin() + i, batch.begin() + i + 8);
+        vector<int> out;
+        for (size_t i = 0; i < batch.size(); i++) {
+            d.push(batch[i].data(), batch[i].size());
+            collect(d, frames, out, i + 1 == PRIME_PACKETS ? 2 * LATENCY_MS : 0);
+        }
+        collect(d, frames, out, 2 * LATENCY_MS);
+        DepacketizerStats s = d.getStats();
+        ok &= check("乱序到达", out == all && s.reordered > 0 && s.lost == 0);
+        print_stats(s);
+    }
+
+    // 3. 丢掉一个 FU-A 中间分片和一个帧内最后的包，再加一个重复包：缺包的帧整帧丢掉，其余不变
+    {
+        RtpDepacketizer d(LATENCY_MS);
+        size_t fragment = 1, last = 0;                        // 第 0 帧（IDR，FU-A）的一个分片
+        while (frame_of[last] <= 5) last++;                   // 第 6 帧的第一个包，它前一个是第 5 帧的 marker 包
+        vector<int> expected;
+        for (int f = 0; f < count; f++)
+            if (f != 0 && f != 5 && f != 6) expected.push_back(f);   // marker 丢了无法判断下一帧是否完整，也丢掉
+
+        vector<int> out;
+        for (size_t i = 0; i < packets.size(); i++) {
+            if (i == fragment || i == last - 1) continue;
+            d.push(packets[i].data(), packets[i].size());
+            if (i == 3) d.push(packets[i].data(), packets[i].size());
+            // 缺口之后等它超时，否则后面的帧都堆在缓冲区里，超时后一起输出会超过输出队列的长度
+            collect(d, frames, out, i + 1 == PRIME_PACKETS || i == last ? 2 * LATENCY_MS : 0);
+        }
+        collect(d, frames, out, 2 * LATENCY_MS);
+        DepacketizerStats s = d.getStats();
+        ok &= check("丢包", out == expected && s.lost == 2 && s.framesDropped == 3 && s.duplicates == 1);
+        print_stats(s);
+    }
+
+    // 4. 一个包晚于延迟窗口到达：它所在的帧已经丢掉，包计为迟到，之后的帧不受影响
+    {
+        RtpDepacketizer d(LATENCY_MS);
+        size_t held = 0;
+        while (frame_of[held] != 2) held++;
+        vector<int> expected;
+        for (int f = 0; f < count; f++)
+            if (f != 2) expected.push_back(f);
+
+        vector<int> out;
+        for (size_t i = 0; i < packets.size(); i++) {
+            if (i == held) continue;
+            d.push(packets[i].data(), packets[i].size());
+            if (frame_of[i] == 4 && frame_of[i + 1] == 5) {
+                // 等缺口超时，然后迟到的包才到达
+                collect(d, frames, out, 2 * LATENCY_MS);
+                d.push(packets[held].data(), packets[held].size());
+            }
+            collect(d, frames, out, i + 1 == PRIME_PACKETS ? 2 * LATENCY_MS : 0);
+        }
+        collect(d, frames, out, 2 * LATENCY_MS);
+        DepacketizerStats s = d.getStats();
+        ok &= check("迟到", out == expected && s.late == 1 && s.lost == 1);
+        print_stats(s);
+    }
+
+    // 5. 解码线程阻塞在 pop()，接收线程按 30 fps 推入：测量抖动缓冲带来的延迟
+    {
+        RtpDepacketizer d(LATENCY_MS);
+        thread receiver([&]() {
+            int frame = 0;
+            for (size_t i = 0; i < packets.size(); i++) {
+                if (frame_of[i] != frame) {
+                    frame = frame_of[i];
+                    this_thread::sleep_for(chrono::milliseconds(33));
+                }
+                d.push(packets[i].data(), packets[i].size());
+            }
+        });
+        int received = 0;
+        AccessUnit au;
+        while (received < count && d.pop(au, 500)) received++;
+        receiver.join();
+        DepacketizerStats s = d.getStats();
+        ok &= check("实时", received == count);
+        print_stats(s);
+    }
+
+    cout << (ok ? "全部通过" : "有测试失败") << endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+#include "rtpPacketizer.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+// 返回从 pos 开始的下一个 Annex B 起始码（00 00 01 或 00 00 00 01）的位置，没有则返回 size。
+// code_size 返回起始码的长度。用 memchr 找 0x01，比逐字节比较快得多。
+static size_t next_start_code(const uint8_t* data, size_t pos, size_t size, size_t* code_size) {
+    while (pos + 3 <= size) {
+        const uint8_t* one = static_cast<const uint8_t*>(memchr(data + pos + 2, 1, size - pos - 2));
+        if (!one) break;
+        size_t i = one - data;
+        if (data[i - 1] == 0 && data[i - 2] == 0) {
+            if (i >= pos + 3 && data[i - 3] == 0) {
+                *code_size = 4;
+                return i - 3;
+            }
+            *code_size = 3;
+            return i - 2;
+        }
+        pos = i - 1;
+    }
+    return size;
+}
+
+RtpPacketizer::RtpPacketizer(uint32_t ssrc, uint8_t payloadType, size_t mtu)
+: ssrc_(ssrc), payloadType_(payloadType & 0x7F),
+mtu_(std::max<size_t>(mtu, RTP_HEADER_SIZE + FU_HEADER_SIZE + 1)), fragmentSize_(mtu_) {
+    memset(&dest_, 0, sizeof(dest_));
+    // 预留一帧常见的包数，稳定后不再分配
+    packets_.reserve(64);
+    headers_.reserve(64);
+}
+
+RtpPacketizer::~RtpPacketizer() {
+    close();
+}
+
+void RtpPacketizer::setFragmentSize(size_t size) {
+    fragmentSize_ = mtu_;
+    if (size >= RTP_HEADER_SIZE + FU_HEADER_SIZE + 1 && size < mtu_) fragmentSize_ = size;
+}
+
+bool RtpPacketizer::open(const std::string& ip, uint16_t port) {
+    close();
+
+    memset(&dest_, 0, sizeof(dest_));
+    dest_.sin_family = AF_INET;
+    dest_.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &dest_.sin_addr) != 1) {
+        std::cerr << "无效的地址 " << ip << std::endl;
+        return false;
+    }
+
+    sock_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock_ < 0) {
+        perror("创建 UDP 套接字失败");
+        return false;
+    }
+
+    // 一个 I 帧的几十个包一次发出，发送缓冲区要能放下整帧
+    int sndbuf = 1 << 20;
+    setsockopt(sock_, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+    return true;
+}
+
+void RtpPacketizer::close() {
+    if (sock_ >= 0) {
+        ::close(sock_);
+        sock_ = -1;
+    }
+}
+
+void RtpPacketizer::setParameterSets(const uint8_t* data, size_t size) {
+    parameterSets_.assign(data, data + size);
+}
+
+int RtpPacketizer::packetize(const uint8_t* data, size_t size, uint32_t timestamp, bool frameEnd) {
+    size_t before = packets_.size();
+    addAnnexB(data, size, timestamp);
+    int added = static_cast<int>(packets_.size() - before);
+
+    if (frameEnd) {
+        if (!packets_.empty()) headers_[packets_.size() - 1][1] |= 0x80;   // marker
+        stats_.accessUnits++;
+        sawSps_ = false;
+        flush();
+    }
+    return added;
+}
+
+void RtpPacketizer::addAnnexB(const uint8_t* data, size_t size, uint32_t timestamp) {
+    size_t code_size = 0;
+    size_t start = next_start_code(data, 0, size, &code_size);
+    if (start == size) {
+        // 没有起始码，整段当作一个 NAL
+        if (size > 0) addNal(data, size, timestamp);
+        return;
+    }
+
+    while (start < size) {
+        size_t nal = start + code_size;
+        size_t next = next_start_code(data, nal, size, &code_size);
+        size_t end = next;
+        while (end > nal && data[end - 1] == 0) end--;   // 去掉 trailing_zero_8bits
+        if (end > nal) addNal(data + nal, end - nal, timestamp);
+        start = next;
+    }
+}
+
+void RtpPacketizer::addNal(const uint8_t* nal, size_t size, uint32_t timestamp) {
+    uint8_t type = nal[0] & 0x1F;
+    if (type == 7) {
+        sawSps_ = true;
+    } else if (type == 5 && !sawSps_ && !parameterSets_.empty()) {
+        // 接收端可能中途加入，IDR 前补发 SPS/PPS
+        sawSps_ = true;
+        addAnnexB(parameterSets_.data(), parameterSets_.size(), timestamp);
+    }
+    stats_.nals++;
+
+    if (size <= mtu_ - RTP_HEADER_SIZE) {
+        addPacket(nal, size, RTP_HEADER_SIZE, timestamp);
+        return;
+    }
+
+    // FU-A：NAL 头不发送，它的 F/NRI 放进 FU indicator，类型放进 FU header。
+    // 除最后一片外每片都是 fragmentSize_，正好填满整数个 OFDM 符号
+    uint8_t indicator = (nal[0] & 0xE0) | 28;
+    size_t max_payload = fragmentSize_ - RTP_HEADER_SIZE - FU_HEADER_SIZE;
+    size_t offset = 1;
+    while (offset < size) {
+        size_t n = std::min(max_payload, size - offset);
+        uint8_t* header = addPacket(nal + offset, n, RTP_HEADER_SIZE + FU_HEADER_SIZE, timestamp);
+        header[12] = indicator;
+        header[13] = (offset == 1 ? 0x80 : 0) | (offset + n == size ? 0x40 : 0) | type;
+        offset += n;
+    }
+}
+
+uint8_t* RtpPacketizer::addPacket(const uint8_t* payload, size_t payloadSize, size_t headerSize, uint32_t timestamp) {
+    size_t index = packets_.size();
+    packets_.push_back({headerSize, payload, payloadSize});
+    if (headers_.size() <= index) headers_.resize(index + 1);
+
+    uint8_t* header = headers_[index].data();
+    header[0] = 0x80;                   // V=2, P=0, X=0, CC=0
+    header[1] = payloadType_;           // M=0，帧结束时再设置
+    header[2] = sequence_ >> 8;
+    header[3] = sequence_ & 0xFF;
+    header[4] = timestamp >> 24;
+    header[5] = (timestamp >> 16) & 0xFF;
+    header[6] = (timestamp >> 8) & 0xFF;
+    header[7] = timestamp & 0xFF;
+    header[8] = ssrc_ >> 24;
+    header[9] = (ssrc_ >> 16) & 0xFF;
+    header[10] = (ssrc_ >> 8) & 0xFF;
+    header[11] = ssrc_ & 0xFF;
+    sequence_++;
+    return header;
+}
+
+int RtpPacketizer::flush() {
+    size_t n = packets_.size();
+    if (n == 0) return 0;
+
+    if (sink_) {
+        if (views_.size() < n) views_.resize(n);
+        for (size_t i = 0; i < n; i++)
+            views_[i] = {headers_[i].data(), packets_[i].headerSize, packets_[i].payload, packets_[i].payloadSize};
+        size_t accepted = std::min(sink_(views_.data(), n), n);
+        for (size_t i = 0; i < accepted; i++) stats_.bytes += views_[i].headerSize + views_[i].payloadSize;
+        stats_.packets += accepted;
+        stats_.sendErrors += n - accepted;
+        packets_.clear();
+        return static_cast<int>(accepted);
+    }
+
+    if (sock_ < 0) {
+        stats_.sendErrors += n;
+        packets_.clear();
+        return -1;
+    }
+
+    // 每个包两个 iovec：头池里的 RTP 头，和指向输入数据的负载
+    if (iov_.size() < 2 * n) iov_.resize(2 * n);
+    if (msgs_.size() < n) msgs_.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        iov_[2 * i].iov_base = headers_[i].data();
+        iov_[2 * i].iov_len = packets_[i].headerSize;
+        iov_[2 * i + 1].iov_base = const_cast<uint8_t*>(packets_[i].payload);
+        iov_[2 * i + 1].iov_len = packets_[i].payloadSize;
+
+        msghdr& msg = msgs_[i].msg_hdr;
+        msg.msg_name = &dest_;
+        msg.msg_namelen = sizeof(dest_);
+        msg.msg_iov = &iov_[2 * i];
+        msg.msg_iovlen = 2;
+        msg.msg_control = nullptr;
+        msg.msg_controllen = 0;
+        msg.msg_flags = 0;
+    }
+
+    size_t done = 0, sent = 0;
+    while (done < n) {
+        unsigned batch = static_cast<unsigned>(std::min<size_t>(n - done, UIO_MAXIOV));
+        int ret = sendmmsg(sock_, &msgs_[done], batch, 0);
+        stats_.syscalls++;
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            // 跳过出错的包，继续发送后面的
+            stats_.sendErrors++;
+            done++;
+            continue;
+        }
+        for (int k = 0; k < ret; k++) stats_.bytes += msgs_[done + k].msg_len;
+        done += ret;
+        sent += ret;
+    }
+
+    stats_.packets += sent;
+    packets_.clear();
+    return static_cast<int>(sent);
+}
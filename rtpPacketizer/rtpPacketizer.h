@@ -0,0 +1,115 @@
+#ifndef RTP_PACKETIZER_H
+#define RTP_PACKETIZER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <array>
+#include <functional>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+struct RtpStats {
+    uint64_t accessUnits;   // 发送的访问单元（帧）数
+    uint64_t nals;          // 打包的 NAL 单元数
+    uint64_t packets;       // 成功发送的 RTP 包数
+    uint64_t bytes;         // 成功发送的字节数，包括 RTP 头
+    uint64_t syscalls;      // sendmmsg 调用次数
+    uint64_t sendErrors;    // 发送失败（或 sink 没有接受）的包数
+};
+
+// 交给 PacketSink 的一个包：头在打包器的头池里，负载指向输入数据，只在回调期间有效
+struct RtpPacketView {
+    const uint8_t* header;
+    size_t headerSize;
+    const uint8_t* payload;
+    size_t payloadSize;
+};
+
+// H.264 的 RTP 打包（RFC 6184，packetization-mode=1：单 NAL 包和 FU-A 分片）。
+// 输入是 Annex B 字节流：编码器输出的整帧 AVPacket，或低延迟模式下的单个 NAL。
+// RTP 头在一个复用的头池里构造，负载用 iovec 直接指向输入数据，不拷贝；
+// 一个访问单元的所有包在 flush() 时用一次 sendmmsg 发出。
+// 加入的数据在 flush() 返回之前必须保持有效。不是线程安全的，应在一个线程里使用。
+class RtpPacketizer {
+    public:
+        // 进程内的包接收者，返回接受的包数（只能是前面连续的若干个）
+        using PacketSink = std::function<size_t(const RtpPacketView* packets, size_t count)>;
+
+        // mtu 是 RTP 包（RTP 头 + 负载）的最大字节数，超过的 NAL 用 FU-A 分片
+        RtpPacketizer(uint32_t ssrc = 0x12345678, uint8_t payloadType = 96, size_t mtu = 1400);
+        ~RtpPacketizer();
+
+        RtpPacketizer(const RtpPacketizer&) = delete;
+        RtpPacketizer& operator=(const RtpPacketizer&) = delete;
+
+        // FU-A 分片的包长（含 RTP 头），超过 mtu 或为 0 时使用 mtu。TransmitSink 用
+        // fun::link_capacity::aligned_length() 按当前 PHY 速率的 OFDM 符号网格计算，速率改变时重新设置
+        void setFragmentSize(size_t size);
+
+        // 创建 UDP 套接字，发往 ip:port
+        bool open(const std::string& ip, uint16_t port);
+
+        // 设置后 flush() 把排队的包交给 sink，而不是用套接字发送，不需要 open()
+        void setSink(PacketSink sink) { sink_ = std::move(sink); }
+        void close();
+
+        // SPS/PPS（Annex B，例如 AV_CODEC_FLAG_GLOBAL_HEADER 时的 extradata），会拷贝一份。
+        // 访问单元里出现 IDR 而前面没有 SPS 时，先发送这里的 SPS/PPS。
+        void setParameterSets(const uint8_t* data, size_t size);
+
+        // 把 data 按起始码拆成 NAL 加入当前访问单元，timestamp 是 90 kHz 时间戳。
+        // frameEnd 时最后一个包设置 marker 并立即 flush()。返回加入的包数。
+        int packetize(const uint8_t* data, size_t size, uint32_t timestamp, bool frameEnd = true);
+
+        // 用 sendmmsg（或 sink）发出排队的包，返回成功发送的包数，两者都没有时返回 -1。
+        // 不设置 marker，低延迟模式下可以在帧中间调用，让已编码的 slice 先发出去。
+        int flush();
+
+        size_t pending() const { return packets_.size(); }
+        size_t mtu() const { return mtu_; }
+        size_t fragmentSize() const { return fragmentSize_; }   // FU-A 分片的包长（含 RTP 头）
+        uint16_t sequence() const { return sequence_; }   // 下一个包的序列号
+        int socket() const { return sock_; }
+        RtpStats getStats() const { return stats_; }
+
+    private:
+        static const size_t RTP_HEADER_SIZE = 12;
+        static const size_t FU_HEADER_SIZE = 2;
+
+        struct PendingPacket {
+            size_t headerSize;          // 头池里对应槽位的有效字节数（RTP 头，FU-A 时加 2 字节）
+            const uint8_t* payload;     // 指向输入数据，不拷贝
+            size_t payloadSize;
+        };
+
+        void addAnnexB(const uint8_t* data, size_t size, uint32_t timestamp);
+        void addNal(const uint8_t* nal, size_t size, uint32_t timestamp);
+        uint8_t* addPacket(const uint8_t* payload, size_t payloadSize, size_t headerSize, uint32_t timestamp);
+
+        uint32_t ssrc_;
+        uint8_t payloadType_;
+        size_t mtu_;
+        size_t fragmentSize_;           // 对齐后的分片包长，不对齐时等于 mtu_
+        uint16_t sequence_ = 0;
+
+        int sock_ = -1;
+        sockaddr_in dest_;
+        PacketSink sink_;
+
+        std::vector<uint8_t> parameterSets_;
+        bool sawSps_ = false;           // 当前访问单元是否已经有 SPS
+
+        // 当前访问单元。只增长不收缩，稳定后不再分配内存
+        std::vector<PendingPacket> packets_;
+        std::vector<std::array<uint8_t, 16>> headers_;
+        std::vector<iovec> iov_;
+        std::vector<mmsghdr> msgs_;
+        std::vector<RtpPacketView> views_;
+
+        RtpStats stats_ = {};
+};
+
+#endif //RTP_PACKETIZER_H
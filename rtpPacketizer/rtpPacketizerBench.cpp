@@ -0,0 +1,155 @@
+// RTP 打包的基准：逐包拷贝 + sendto（AVpackettoRTP.cpp 原来的做法）与 RtpPacketizer（iovec + sendmmsg）对比。
+// 发往本机的一个 UDP 套接字，接收线程只计数，用于确认包都到达。
+// 用法：rtpPacketizerBench [帧数] [I 帧字节数] [P 帧字节数]
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "rtpPacketizer.h"
+
+using namespace std;
+
+static const size_t MTU = 1400;
+
+// 构造一个 Annex B 访问单元：可选 SPS/PPS，然后 slices 个 slice NAL。负载不含 0x00，不会出现伪起始码
+static vector<uint8_t> make_access_unit(size_t size, bool idr, int slices) {
+    vector<uint8_t> au;
+    auto add_nal = [&au](uint8_t header, size_t n) {
+        const uint8_t start_code[4] = {0, 0, 0, 1};
+        au.insert(au.end(), start_code, start_code + 4);
+        au.push_back(header);
+        for (size_t i = 1; i < n; i++) au.push_back(static_cast<uint8_t>(1 + rand() % 255));
+    };
+    if (idr) {
+        add_nal(0x67, 12);   // SPS
+        add_nal(0x68, 4);    // PPS
+    }
+    for (int s = 0; s < slices; s++) add_nal(idr ? 0x65 : 0x41, size / slices);
+    return au;
+}
+
+// 原来的做法：每个包拷贝到栈上的缓冲区，然后一次 sendto
+static int legacy_send(int sock, const sockaddr_in& dest, const vector<uint8_t>& au, uint16_t& seq, uint32_t ts) {
+    int packets = 0;
+    uint8_t packet[MTU];
+    auto send_packet = [&](size_t size, bool marker) {
+        packet[0] = 0x80;
+        packet[1] = (marker ? 0x80 : 0) | 96;
+        uint16_t s = htons(seq++);
+        uint32_t t = htonl(ts), ssrc = htonl(0x12345678);
+        memcpy(packet + 2, &s, 2);
+        memcpy(packet + 4, &t, 4);
+        memcpy(packet + 8, &ssrc, 4);
+        sendto(sock, packet, size, 0, reinterpret_cast<const sockaddr*>(&dest), sizeof(dest));
+        packets++;
+    };
+
+    // 按 4 字节起始码拆分（make_access_unit 只生成这种）
+    vector<size_t> starts;
+    for (size_t i = 0; i + 4 <= au.size(); i++)
+        if (au[i] == 0 && au[i + 1] == 0 && au[i + 2] == 0 && au[i + 3] == 1) starts.push_back(i + 4);
+    for (size_t k = 0; k < starts.size(); k++) {
+        const uint8_t* nal = au.data() + starts[k];
+        size_t size = (k + 1 < starts.size() ? starts[k + 1] - 4 : au.size()) - starts[k];
+        bool last = k + 1 == starts.size();
+        if (size <= MTU - 12) {
+            memcpy(packet + 12, nal, size);
+            send_packet(12 + size, last);
+            continue;
+        }
+        for (size_t offset = 1; offset < size;) {
+            size_t n = min(MTU - 14, size - offset);
+            packet[12] = (nal[0] & 0xE0) | 28;
+            packet[13] = (offset == 1 ? 0x80 : 0) | (offset + n == size ? 0x40 : 0) | (nal[0] & 0x1F);
+            memcpy(packet + 14, nal + offset, n);
+            send_packet(14 + n, last && offset + n == size);
+            offset += n;
+        }
+    }
+    return packets;
+}
+
+int main(int argc, char* argv[]) {
+    int frames = argc > 1 ? atoi(argv[1]) : 3000;
+    size_t idr_size = argc > 2 ? atoi(argv[2]) : 60000;
+    size_t p_size = argc > 3 ? atoi(argv[3]) : 12000;
+    const int gop = 30, slices = 4;
+
+    // 接收端：本机随机端口，只计数
+    int rx = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int rcvbuf = 8 << 20;
+    setsockopt(rx, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    if (rx < 0 || bind(rx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("创建接收套接字失败");
+        return 1;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(rx, reinterpret_cast<sockaddr*>(&addr), &len);
+    uint16_t port = ntohs(addr.sin_port);
+
+    atomic<bool> running(true);
+    atomic<uint64_t> received(0);
+    timeval timeout = {0, 100000};
+    setsockopt(rx, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    thread receiver([&] {
+        uint8_t buf[2048];
+        while (running) {
+            if (recv(rx, buf, sizeof(buf), 0) > 0) received++;
+        }
+    });
+
+    vector<vector<uint8_t>> aus;
+    for (int i = 0; i < gop; i++) aus.push_back(make_access_unit(i == 0 ? idr_size : p_size, i == 0, slices));
+
+    cout << frames << " 帧，I 帧 " << idr_size << " 字节，P 帧 " << p_size << " 字节，MTU " << MTU << endl;
+
+    auto report = [&](const char* name, uint64_t packets, uint64_t syscalls, double seconds) {
+        this_thread::sleep_for(chrono::milliseconds(200));   // 等接收线程收完
+        cout << name << ": " << packets << " 包，" << syscalls << " 次系统调用，"
+             << static_cast<uint64_t>(packets / seconds) << " 包/秒，"
+             << static_cast<uint64_t>(frames / seconds) << " 帧/秒，收到 " << received.exchange(0) << endl;
+    };
+
+    // 原来的做法
+    {
+        int sock = socket(AF_INET, SOCK_DGRAM, 0);
+        int sndbuf = 1 << 20;
+        setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        uint16_t seq = 0;
+        uint64_t packets = 0;
+        auto t0 = chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++) packets += legacy_send(sock, addr, aus[i % gop], seq, i * 3000);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        report("拷贝 + sendto      ", packets, packets, seconds);
+        close(sock);
+    }
+
+    // RtpPacketizer，整帧
+    {
+        RtpPacketizer packetizer(0x12345678, 96, MTU);
+        if (!packetizer.open("127.0.0.1", port)) return 1;
+        auto t0 = chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++) {
+            const vector<uint8_t>& au = aus[i % gop];
+            packetizer.packetize(au.data(), au.size(), i * 3000);
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        RtpStats stats = packetizer.getStats();
+        report("iovec + sendmmsg   ", stats.packets, stats.syscalls, seconds);
+    }
+
+    running = false;
+    receiver.join();
+    close(rx);
+    return 0;
+}
@@ -1,45 +1,121 @@
 #include <gst/gst.h>
 #include <iostream>
 #include <thread>
-#include <queue>
+#include <atomic>
 #include <mutex>
-#include <condition_variable>
 #include <vector>
+#include <map>
+#include <chrono>
+#include <iterator>
+#include <algorithm>
+#include <cerrno>
+#include <semaphore.h>
+#include <time.h>
+
+// 编码管道和解码管道之间的一帧。真实链路上编码数据从接收机以 vector 的形式到达，这里模拟同样的接口
+struct EncodedFrame {
+    std::vector<unsigned char> data;
+    GstClockTime pts;            // 编码管道的 PTS（采集时的 running time）
+    GstClockTime captureTime;    // 采集时的时钟时间 = 编码管道 base_time + pts
+    GstClockTime pushTime;       // 放进队列时的时钟时间
+    GstClockTime popTime;        // 从队列取出时的时钟时间
+};
+
+// 有界的单生产者单消费者环形队列，满时丢掉最旧的帧，让解码端总是拿到最新的数据。
+// 读位置由生产者（丢帧）和消费者（取帧）共同推进，都用 CAS；只有推进成功的一方拥有该槽位的帧。
+// 消费者用信号量等待，丢帧不减信号量，所以醒来时队列可能是空的，重新等待即可。
+class FrameRing {
+    public:
+        explicit FrameRing(size_t capacity) : slots_(capacity), write_(0), read_(0), dropped_(0) {
+            for (auto& slot : slots_) slot.store(nullptr);
+            sem_init(&available_, 0, 0);
+        }
 
-// 线程安全队列
-std::queue<std::vector<unsigned char>> bufferQueue;
-std::mutex bufferMutex;
-std::condition_variable bufferCond;
+        ~FrameRing() {
+            EncodedFrame* frame;
+            while ((frame = try_pop()) != nullptr) delete frame;
+            sem_destroy(&available_);
+        }
 
+        // 生产者：放入一帧，队列满时丢掉最旧的一帧
+        void push(EncodedFrame* frame) {
+            unsigned long long w = write_.load(std::memory_order_relaxed);
+            unsigned long long r = read_.load(std::memory_order_acquire);
+            while (w - r >= slots_.size()) {
+                if (read_.compare_exchange_weak(r, r + 1, std::memory_order_acq_rel)) {
+                    delete slots_[r % slots_.size()].exchange(nullptr, std::memory_order_acq_rel);
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            slots_[w % slots_.size()].store(frame, std::memory_order_release);
+            write_.store(w + 1, std::memory_order_release);
+            sem_post(&available_);
+        }
 
-// 向队列中添加数据
-void push_data(const std::vector<unsigned char>& data) {
-    std::lock_guard<std::mutex> lock(bufferMutex);
-    // if (bufferQueue.size() >= 100) {
-    //     bufferCond.wait(lock, [] { return bufferQueue.size() < 100; });
-    // }
-    bufferQueue.push(data);
-    std::cout << "Queue size: " << bufferQueue.size() << std::endl;
-    bufferCond.notify_one();
-    // std::this_thread::sleep_for(std::chrono::milliseconds(33)); // 模拟 30FPS
+        // 消费者：取出最旧的一帧，队列为空返回 nullptr
+        EncodedFrame* try_pop() {
+            unsigned long long r = read_.load(std::memory_order_acquire);
+            while (r != write_.load(std::memory_order_acquire)) {
+                // 先取指针再推进读位置：推进失败说明这一帧刚被生产者丢掉，指针作废
+                EncodedFrame* frame = slots_[r % slots_.size()].load(std::memory_order_acquire);
+                if (read_.compare_exchange_weak(r, r + 1, std::memory_order_acq_rel)) return frame;
+            }
+            return nullptr;
+        }
 
-}
+        // 消费者：最多等待 timeout_ms 毫秒
+        EncodedFrame* pop(int timeout_ms) {
+            timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += timeout_ms / 1000;
+            deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            while (true) {
+                EncodedFrame* frame = try_pop();
+                if (frame) return frame;
+                if (sem_timedwait(&available_, &deadline) != 0 && errno != EINTR) return nullptr;
+            }
+        }
 
-// 从队列中取数据
-std::vector<unsigned char> pop_data() {
-    std::unique_lock<std::mutex> lock(bufferMutex);
-    bufferCond.wait(lock, [] { return !bufferQueue.empty(); });
-    auto data = bufferQueue.front();
-    bufferQueue.pop();
-    // bufferCond.notify_one(); 
-    return data;
+        size_t size() const { return write_.load() - read_.load(); }
+        unsigned long long dropped() const { return dropped_.load(); }
+
+    private:
+        std::vector<std::atomic<EncodedFrame*>> slots_;
+        alignas(64) std::atomic<unsigned long long> write_;
+        alignas(64) std::atomic<unsigned long long> read_;
+        std::atomic<unsigned long long> dropped_;
+        sem_t available_;
+};
+
+static FrameRing frameRing(8);
+static std::atomic<bool> running(true);
+
+static GstElement *encode_pipeline = nullptr;
+static GstElement *decode_pipeline = nullptr;
+
+// 延迟统计，每秒打印一次。编码：采集到 appsink；队列：appsink 到解码线程取出；解码：取出到显示 sink
+struct LatencyStats {
+    std::mutex mutex;
+    std::map<GstClockTime, EncodedFrame> inFlight;   // 已推给 appsrc、还没到达显示 sink 的帧，按解码管道的 PTS
+    uint64_t frames = 0;
+    GstClockTime encode = 0, queue = 0, decode = 0, total = 0, maxTotal = 0;
+} latency;
+
+static GstClockTime clock_now(GstElement *pipeline) {
+    GstClock *clock = gst_element_get_clock(pipeline);
+    if (!clock) return GST_CLOCK_TIME_NONE;
+    GstClockTime now = gst_clock_get_time(clock);
+    gst_object_unref(clock);
+    return now;
 }
 
-// 编码回调函数：从 appsink 获取编码后的数据
+// 编码回调函数：从 appsink 获取编码后的数据，放进队列后立即返回，不阻塞编码管道
 static GstFlowReturn new_sample_callback(GstElement *sink, gpointer user_data) {
-    auto now = std::chrono::high_resolution_clock::now();
-    static auto last_time = now;
-    
     GstSample *sample;
     GstBuffer *buffer;
     GstMapInfo map;
@@ -52,40 +128,68 @@ static GstFlowReturn new_sample_callback(GstElement *sink, gpointer user_data) {
 
     buffer = gst_sample_get_buffer(sample);
     if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
-        // 将编码数据放入队列
-        std::vector<unsigned char> encoded_data(map.data, map.data + map.size);
-        push_data(encoded_data);
+        // 模拟无线链路：数据以 vector 的形式交给解码端，这是整条路径上唯一的一次拷贝
+        EncodedFrame *frame = new EncodedFrame;
+        frame->data.assign(map.data, map.data + map.size);
+        frame->pts = GST_BUFFER_PTS(buffer);
+        frame->captureTime = gst_element_get_base_time(encode_pipeline) + frame->pts;
+        frame->pushTime = clock_now(encode_pipeline);
+        frameRing.push(frame);
 
         gst_buffer_unmap(buffer, &map);
     }
 
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_time).count();
-    std::cout << "Time since last sample: " << duration << " ms" << std::endl;
-    last_time = now;
-
-    std::cout << "PTS: " << GST_BUFFER_PTS(buffer) << std::endl;
-    std::this_thread::sleep_for(std::chrono::milliseconds(33)); // 模拟30FPS
-
-
     gst_sample_unref(sample);
     return GST_FLOW_OK;
 }
 
-// 解码线程：从队列中取数据并推送到 appsrc
+// 包装进 GstBuffer 的帧在 GstBuffer 释放时才删除
+static void free_frame(gpointer data) {
+    delete static_cast<EncodedFrame*>(data);
+}
+
+// 解码线程：从队列中取数据，不拷贝地包装成 GstBuffer 推送到 appsrc。
+// PTS 换算到解码管道的 running time，由显示 sink 按 PTS 同步播放，不再用固定的 sleep 控制节奏
 void decode_thread(GstElement *appsrc) {
-    while (true) {
-        // 从队列获取编码数据块
-        std::vector<unsigned char> data = pop_data();
+    GstClockTime offset = GST_CLOCK_TIME_NONE;   // 编码 PTS -> 解码管道 running time
 
-        // 创建 GStreamer Buffer 并填充数据
-        GstBuffer *buffer = gst_buffer_new_allocate(NULL, data.size(), NULL);
-        gst_buffer_fill(buffer, 0, data.data(), data.size());
+    while (running) {
+        EncodedFrame *frame = frameRing.pop(100);
+        if (!frame) continue;
 
-        // 推送数据到 appsrc
+        GstClockTime now = clock_now(decode_pipeline);
+        if (!GST_CLOCK_TIME_IS_VALID(frame->pts) || !GST_CLOCK_TIME_IS_VALID(now)) {
+            delete frame;
+            continue;
+        }
+        GstClockTime running_time = now - gst_element_get_base_time(decode_pipeline);
+        if (!GST_CLOCK_TIME_IS_VALID(offset) || frame->pts + offset < running_time) {
+            // 第一帧，或者帧已经晚于它的播放时间（链路抖动、丢帧）：重新对齐，让这一帧马上播放
+            offset = running_time - std::min(running_time, frame->pts);
+        }
+        GstClockTime pts = frame->pts + offset;
+
+        {
+            std::lock_guard<std::mutex> lock(latency.mutex);
+            EncodedFrame &info = latency.inFlight[pts];
+            info.pts = frame->pts;
+            info.captureTime = frame->captureTime;
+            info.pushTime = frame->pushTime;
+            info.popTime = now;
+            // 解码器不输出的帧（例如解码出错）不会被 display_probe 删掉，这里限制记录的数量
+            if (latency.inFlight.size() > 64) latency.inFlight.erase(latency.inFlight.begin());
+        }
+
+        // 创建 GStreamer Buffer，直接引用 vector 的数据
+        GstBuffer *buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, frame->data.data(),
+                                                        frame->data.size(), 0, frame->data.size(),
+                                                        frame, free_frame);
+        GST_BUFFER_PTS(buffer) = pts;
+        GST_BUFFER_DTS(buffer) = GST_CLOCK_TIME_NONE;
+
+        // 推送数据到 appsrc，push-buffer 不接管引用，之后要 unref
         GstFlowReturn ret;
         g_signal_emit_by_name(appsrc, "push-buffer", buffer, &ret);
-
-        std::cout << "PTS: " << GST_BUFFER_PTS(buffer) << std::endl;
         gst_buffer_unref(buffer);
 
         if (ret != GST_FLOW_OK) {
@@ -95,11 +199,51 @@ void decode_thread(GstElement *appsrc) {
     }
 }
 
+// 解码后的帧到达显示 sink 时记录延迟
+static GstPadProbeReturn display_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data) {
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstClockTime now = clock_now(decode_pipeline);
+    if (!buffer || !GST_CLOCK_TIME_IS_VALID(now)) return GST_PAD_PROBE_OK;
+
+    std::lock_guard<std::mutex> lock(latency.mutex);
+    auto it = latency.inFlight.find(GST_BUFFER_PTS(buffer));
+    if (it == latency.inFlight.end()) return GST_PAD_PROBE_OK;
+
+    const EncodedFrame &frame = it->second;
+    GstClockTime total = now - frame.captureTime;
+    latency.frames++;
+    latency.encode += frame.pushTime - frame.captureTime;
+    latency.queue += frame.popTime - frame.pushTime;
+    latency.decode += now - frame.popTime;
+    latency.total += total;
+    latency.maxTotal = std::max(latency.maxTotal, total);
+    // 解码器可能丢掉个别帧，比这一帧早的记录不会再用到
+    latency.inFlight.erase(latency.inFlight.begin(), std::next(it));
+    return GST_PAD_PROBE_OK;
+}
+
+// 每秒打印一次延迟和队列状态
+void report_thread() {
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        std::lock_guard<std::mutex> lock(latency.mutex);
+        if (latency.frames == 0) continue;
+        double n = static_cast<double>(latency.frames);
+        std::cout << latency.frames << " frames, latency (ms): capture->appsink " << latency.encode / n / 1e6
+                  << ", queue " << latency.queue / n / 1e6
+                  << ", appsrc->display " << latency.decode / n / 1e6
+                  << ", total " << latency.total / n / 1e6 << " (max " << latency.maxTotal / 1e6 << ")"
+                  << ", queued " << frameRing.size() << ", dropped " << frameRing.dropped() << std::endl;
+        latency.frames = 0;
+        latency.encode = latency.queue = latency.decode = latency.total = latency.maxTotal = 0;
+    }
+}
+
 int main(int argc, char *argv[]) {
     gst_init(&argc, &argv);
 
     // 编码管道：摄像头 -> H.264 编码 -> appsink
-    GstElement *encode_pipeline = gst_parse_launch(
+    encode_pipeline = gst_parse_launch(
         "v4l2src ! video/x-raw,format=YUY2,width=640,height=480,framerate=30/1 ! "
         "videoconvert ! x264enc tune=zerolatency bitrate=500 ! "
         "video/x-h264,stream-format=byte-stream ! appsink name=enc_sink",
@@ -115,9 +259,9 @@ int main(int argc, char *argv[]) {
     g_signal_connect(appsink, "new-sample", G_CALLBACK(new_sample_callback), NULL);
 
     // 解码管道：appsrc -> H.264 解码 -> 显示
-    GstElement *decode_pipeline = gst_parse_launch(
+    decode_pipeline = gst_parse_launch(
         "appsrc name=src format=time is-live=true block=true ! "
-        "h264parse ! avdec_h264 ! videoconvert ! autovideosink",
+        "h264parse ! avdec_h264 ! videoconvert ! autovideosink name=display",
         nullptr);
 
     if (!decode_pipeline) {
@@ -131,6 +275,18 @@ int main(int argc, char *argv[]) {
                  gst_caps_from_string("video/x-h264,stream-format=byte-stream"),
                  NULL);
 
+    // 两条管道使用同一个时钟，编码端记录的时钟时间在解码端可以直接比较
+    GstClock *clock = gst_system_clock_obtain();
+    gst_pipeline_use_clock(GST_PIPELINE(encode_pipeline), clock);
+    gst_pipeline_use_clock(GST_PIPELINE(decode_pipeline), clock);
+    gst_object_unref(clock);
+
+    GstElement *display = gst_bin_get_by_name(GST_BIN(decode_pipeline), "display");
+    GstPad *display_pad = gst_element_get_static_pad(display, "sink");
+    gst_pad_add_probe(display_pad, GST_PAD_PROBE_TYPE_BUFFER, display_probe, NULL, NULL);
+    gst_object_unref(display_pad);
+    gst_object_unref(display);
+
     // 启动编码管道
     if (gst_element_set_state(encode_pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
         std::cerr << "Failed to set encoding pipeline to PLAYING state!" << std::endl;
@@ -147,20 +303,24 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
-    // 启动解码线程
+    // 启动解码线程和统计线程
     std::thread decoder(decode_thread, appsrc);
+    std::thread reporter(report_thread);
 
     // 主线程阻塞，等待用户终止程序
     std::cout << "Press Enter to exit..." << std::endl;
     std::cin.get();
 
-    // 停止管道并释放资源
+    // 先停止编码管道，解码线程从队列等待中退出后再停止解码管道
     gst_element_set_state(encode_pipeline, GST_STATE_NULL);
+    running = false;
+    decoder.join();
+    reporter.join();
     gst_element_set_state(decode_pipeline, GST_STATE_NULL);
 
+    gst_object_unref(appsink);
+    gst_object_unref(appsrc);
     gst_object_unref(encode_pipeline);
     gst_object_unref(decode_pipeline);
-
-    decoder.join();
     return 0;
 }
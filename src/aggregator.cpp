@@ -0,0 +1,122 @@
+/*! \file aggregator.cpp
+ *  \brief C++ file for the aggregator class.
+ *
+ *  The aggregator class packs several MPDUs into the payload of one PPDU and unpacks
+ *  them again on the receive side.
+ */
+
+#include <cstring>
+
+#include "aggregator.h"
+#include "crc32.h"
+#include "ppdu.h"
+
+namespace fun
+{
+    int aggregator::subframe_length(int mpdu_length)
+    {
+        return (AGGREGATE_DELIMITER_SIZE + mpdu_length + 4 /* CRC */ + 3) & ~3;
+    }
+
+    /*!
+     *  The last subframe is not padded, so an MPDU fits if its unpadded subframe fits
+     *  after the padded subframes before it.
+     */
+    int aggregator::pack(const std::vector<std::vector<unsigned char> > & mpdus, int first,
+                         std::vector<unsigned char> & ampdu, int max_length)
+    {
+        if(max_length > MAX_FRAME_SIZE) max_length = MAX_FRAME_SIZE;
+        ampdu.resize(0);
+
+        int count = 0;
+        for(size_t x = first; x < mpdus.size(); x++)
+        {
+            int length = mpdus[x].size();
+            if(length > 0xFFF) break;
+
+            int start = (ampdu.size() + 3) & ~3;
+            if(start + AGGREGATE_DELIMITER_SIZE + length + 4 > max_length) break;
+
+            // Pad the previous subframe
+            ampdu.resize(start + AGGREGATE_DELIMITER_SIZE + length + 4, 0);
+            unsigned char * subframe = &ampdu[start];
+
+            // Delimiter
+            subframe[0] = length & 0xFF;
+            subframe[1] = (length >> 8) & 0x0F;
+            subframe[2] = delimiter_crc(subframe);
+            subframe[3] = AGGREGATE_SIGNATURE;
+
+            // MPDU and its CRC
+            memcpy(&subframe[AGGREGATE_DELIMITER_SIZE], mpdus[x].data(), length);
+            crc32 crc;
+            crc.process_bytes(mpdus[x].data(), length);
+            unsigned int calculated_crc = crc.checksum();
+            memcpy(&subframe[AGGREGATE_DELIMITER_SIZE + length], &calculated_crc, 4);
+
+            count++;
+        }
+
+        return count;
+    }
+
+    /*!
+     *  Walks the delimiters. A delimiter is only trusted if its signature and CRC-8 match and
+     *  the subframe it describes fits in the aggregate; otherwise the search resumes at the
+     *  next 4 byte boundary.
+     */
+    std::vector<std::vector<unsigned char> > aggregator::unpack(const std::vector<unsigned char> & ampdu, int * bad_subframes)
+    {
+        std::vector<std::vector<unsigned char> > mpdus;
+        bool in_sync = true;
+
+        size_t pos = 0;
+        while(pos + AGGREGATE_DELIMITER_SIZE <= ampdu.size())
+        {
+            const unsigned char * delimiter = &ampdu[pos];
+            int length = delimiter[0] | ((delimiter[1] & 0x0F) << 8);
+            bool valid = delimiter[3] == AGGREGATE_SIGNATURE &&
+                         delimiter[2] == delimiter_crc(delimiter) &&
+                         pos + AGGREGATE_DELIMITER_SIZE + length + 4 <= ampdu.size();
+            if(!valid)
+            {
+                // Count a lost delimiter once, not once per skipped word
+                if(in_sync && bad_subframes != nullptr) (*bad_subframes)++;
+                in_sync = false;
+                pos += 4;
+                continue;
+            }
+            in_sync = true;
+
+            const unsigned char * mpdu = delimiter + AGGREGATE_DELIMITER_SIZE;
+            crc32 crc;
+            crc.process_bytes(mpdu, length);
+            unsigned int given_crc = 0;
+            memcpy(&given_crc, mpdu + length, 4);
+
+            if(crc.checksum() == given_crc)
+            {
+                if(length > 0) mpdus.push_back(std::vector<unsigned char>(mpdu, mpdu + length));
+            }
+            else if(bad_subframes != nullptr)
+            {
+                (*bad_subframes)++;
+            }
+
+            pos += subframe_length(length);
+        }
+
+        return mpdus;
+    }
+
+    unsigned char aggregator::delimiter_crc(const unsigned char * delimiter)
+    {
+        unsigned char crc = 0xFF;
+        for(int x = 0; x < 2; x++)
+        {
+            crc ^= delimiter[x];
+            for(int b = 0; b < 8; b++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+        }
+        return ~crc;
+    }
+}
@@ -7,6 +7,8 @@
  */
 
 #include <cstring>
+#include <algorithm>
+#include <cmath>
 
 #include "channel_est.h"
 #include "preamble.h"
@@ -18,12 +20,15 @@ namespace fun
      *   + #m_chan_est -> 64 complex doubles each initialized to (1+0j)
      *   + #m_lts_flag -> 0 or in other words not in the LTS
      *   + #m_frame_start -> false
+     *   + #m_frame_table -> frame_table
      */
-    channel_est::channel_est() :
+    channel_est::channel_est(frame_measurements * frame_table) :
         block("channel_est"),        
         m_chan_est(64, std::complex<double>(1, 0)),
         m_lts_flag(0),
-        m_frame_start(false)
+        m_frame_start(false),
+        m_frame_table(frame_table),
+        m_frame_id(0)
     {
     }
 
@@ -32,6 +37,10 @@ namespace fun
      * Once this symbol is found it then compares each sample in the two LTS symbols with the known
      * transmitted sample and calculates the inverse channel effect. It then applies this
      * channel correction to the rest of the symbol.
+     *
+     * The two LTS symbols carry the same data so their difference is noise only, which gives
+     * the SNR estimate: the noise power per subcarrier is E|Y1-Y2|^2 / 2 and the signal power
+     * is E|Y1+Y2|^2 / 4 less half the noise power.
      */
     void channel_est::work(){
 
@@ -44,6 +53,7 @@ namespace fun
             if(input_buffer[i].tag == LTS_START)
             {
                 m_lts_flag = 1;
+                m_frame_id = input_buffer[i].frame_id;
                 for(int j = 0; j < 64; j++) m_chan_est[j] = std::complex<double>(0.0,0.0);
             }
 
@@ -57,6 +67,26 @@ namespace fun
                     m_chan_est[j] += ref_lts_sample / rec_lts_sample / 2.0;
                 }
 
+                if(m_lts_flag == 1)
+                {
+                    memcpy(m_lts1, input_buffer[i].samples, sizeof(m_lts1));
+                }
+                else if(m_frame_table != nullptr)
+                {
+                    double sum = 0, diff = 0;
+                    int used = 0;
+                    for(int j = 0; j < 64; j++)
+                    {
+                        if(LTS_FREQ_DOMAIN[j] == 0.0) continue;
+                        sum += std::norm(m_lts1[j] + input_buffer[i].samples[j]);
+                        diff += std::norm(m_lts1[j] - input_buffer[i].samples[j]);
+                        used++;
+                    }
+                    double noise = diff / used / 2.0;
+                    double signal = std::max(sum / used / 4.0 - noise / 2.0, 1e-30);
+                    m_frame_table[m_frame_id % FRAME_TABLE_SIZE].snr_db = 10.0 * std::log10(signal / std::max(noise, 1e-30));
+                }
+
                 m_lts_flag++;
                 if(m_lts_flag == 3) // No more LTS symbols
                 {
@@ -70,6 +100,7 @@ namespace fun
                 if(m_frame_start)
                 {
                     symbol.tag = START_OF_FRAME;
+                    symbol.frame_id = m_frame_id;
                     m_frame_start = false;
                 }
 
@@ -0,0 +1,153 @@
+/*! \file channel_model.cpp
+ *  \brief C++ file for the channel_model class.
+ *
+ *  The channel_model class applies the impairments of a radio link to baseband samples.
+ */
+
+#include "channel_model.h"
+
+#define INTERP_HALF_WIDTH 8     //!< The fractional delay interpolator uses 2 * INTERP_HALF_WIDTH taps
+#define INTERP_PHASES 256       //!< Fractional delays the interpolator table is computed for
+
+namespace fun
+{
+    /*!
+     * - Initializations:
+     *   + #m_taps -> exponential power delay profile with Rayleigh distributed taps, drawn from
+     *     the seed, 5 delay spreads long and normalized to unit power; a single 1 if flat
+     *   + #m_interpolator -> Blackman windowed sinc, INTERP_PHASES fractional delays
+     *   + #m_iq_direct, #m_iq_image -> y = K1 x + K2 conj(x) with K1 = (1 + g e^-jp) / 2 and
+     *     K2 = (1 - g e^jp) / 2
+     */
+    channel_model::channel_model(channel_params params, double sample_rate) :
+        m_params(params),
+        m_sample_rate(sample_rate),
+        m_random(params.seed),
+        m_position(INTERP_HALF_WIDTH - 1),
+        m_phase(0)
+    {
+        if(params.delay_spread > 0)
+        {
+            int num_taps = int(std::ceil(5 * params.delay_spread)) + 1;
+            double power = 0;
+            for(int x = 0; x < num_taps; x++)
+            {
+                m_taps.push_back(gaussian() * std::sqrt(std::exp(-x / params.delay_spread)));
+                power += std::norm(m_taps.back());
+            }
+            for(int x = 0; x < num_taps; x++) m_taps[x] /= std::sqrt(power);
+        }
+        else
+        {
+            m_taps.push_back(1);
+        }
+        m_history.resize(m_taps.size() - 1);
+
+        m_step = 1 + params.sampling_offset_ppm * 1e-6;
+        m_pending.resize(INTERP_HALF_WIDTH - 1);
+        m_interpolator.resize((INTERP_PHASES + 1) * 2 * INTERP_HALF_WIDTH);
+        for(int p = 0; p <= INTERP_PHASES; p++)
+        {
+            double frac = double(p) / INTERP_PHASES;
+            for(int k = 0; k < 2 * INTERP_HALF_WIDTH; k++)
+            {
+                double u = k - (INTERP_HALF_WIDTH - 1) - frac;
+                double sinc = u == 0 ? 1 : std::sin(M_PI * u) / (M_PI * u);
+                double w = 0.42 + 0.5 * std::cos(M_PI * u / INTERP_HALF_WIDTH) + 0.08 * std::cos(2 * M_PI * u / INTERP_HALF_WIDTH);
+                m_interpolator[p * 2 * INTERP_HALF_WIDTH + k] = sinc * w;
+            }
+        }
+
+        m_phase_step = 2 * M_PI * params.cfo_hz / sample_rate;
+        m_phase_noise_std = std::sqrt(2 * M_PI * params.phase_noise_hz / sample_rate);
+        m_noise_std = std::sqrt(params.signal_power / std::pow(10, params.snr_db / 10));
+
+        double g = std::pow(10, params.iq_gain_db / 20);
+        double p = params.iq_phase_deg * M_PI / 180;
+        m_iq_direct = (1.0 + g * std::polar(1.0, -p)) / 2.0;
+        m_iq_image = (1.0 - g * std::polar(1.0, p)) / 2.0;
+    }
+
+    std::complex<double> channel_model::gaussian()
+    {
+        const double scale = 1.0 / 18446744073709551616.0; // 2^-64
+        double u1 = (m_random() + 0.5) * scale;
+        double u2 = m_random() * scale;
+        double r = std::sqrt(-std::log(u1)); // unit power: each component has variance 1/2
+        return std::polar(r, 2 * M_PI * u2);
+    }
+
+    void channel_model::apply(const std::complex<double> * in, int count, std::vector<std::complex<double> > & out)
+    {
+        // Multipath
+        int num_taps = m_taps.size();
+        m_filtered.resize(count);
+        for(int x = 0; x < count; x++)
+        {
+            std::complex<double> sum = 0;
+            for(int t = 0; t < num_taps; t++)
+                sum += m_taps[t] * (x - t >= 0 ? in[x - t] : m_history[num_taps - 1 + x - t]);
+            m_filtered[x] = sum;
+        }
+        for(int t = 0; t < num_taps - 1; t++)
+            m_history[t] = count - (num_taps - 1) + t >= 0 ? in[count - (num_taps - 1) + t]
+                                                           : m_history[t + count];
+
+        // Sampling offset
+        if(m_params.sampling_offset_ppm != 0)
+        {
+            m_pending.insert(m_pending.end(), m_filtered.begin(), m_filtered.end());
+            out.clear();
+            resample(out);
+        }
+        else
+        {
+            out.swap(m_filtered);
+        }
+
+        // CFO, phase noise, noise and IQ imbalance
+        for(size_t x = 0; x < out.size(); x++)
+        {
+            std::complex<double> s = out[x] * std::polar(1.0, m_phase);
+            m_phase += m_phase_step;
+            if(m_phase_noise_std > 0) m_phase += m_phase_noise_std * std::sqrt(2.0) * gaussian().real();
+            if(m_phase > M_PI) m_phase -= 2 * M_PI;
+            else if(m_phase < -M_PI) m_phase += 2 * M_PI;
+
+            if(m_noise_std > 0) s += m_noise_std * gaussian();
+            out[x] = m_iq_direct * s + m_iq_image * std::conj(s);
+        }
+    }
+
+    /*!
+     *  Output sample n is the input interpolated at n * (1 + ppm * 1e-6). A windowed sinc keeps
+     *  the interpolation flat across the whole OFDM band, which linear interpolation would not.
+     *  The fractional delay is rounded to 1/INTERP_PHASES of a sample.
+     */
+    void channel_model::resample(std::vector<std::complex<double> > & out)
+    {
+        while(size_t(m_position) + INTERP_HALF_WIDTH < m_pending.size())
+        {
+            int i = int(m_position);
+            int p = int((m_position - i) * INTERP_PHASES + 0.5);
+            const double * h = &m_interpolator[p * 2 * INTERP_HALF_WIDTH];
+            const std::complex<double> * x = &m_pending[i - (INTERP_HALF_WIDTH - 1)];
+
+            std::complex<double> sum = 0;
+            for(int k = 0; k < 2 * INTERP_HALF_WIDTH; k++) sum += h[k] * x[k];
+            out.push_back(sum);
+            m_position += m_step;
+        }
+
+        int consumed = int(m_position) - (INTERP_HALF_WIDTH - 1);
+        m_pending.erase(m_pending.begin(), m_pending.begin() + consumed);
+        m_position -= consumed;
+    }
+
+    double channel_model::mean_power(const std::complex<double> * samples, int count)
+    {
+        double power = 0;
+        for(int x = 0; x < count; x++) power += std::norm(samples[x]);
+        return count ? power / count : 0;
+    }
+}
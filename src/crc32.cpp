@@ -0,0 +1,212 @@
+/*! \file crc32.cpp
+ *  \brief C++ file for the crc32 class.
+ *
+ *  The crc32 class computes the IEEE CRC-32 appended to every PPDU payload, either
+ *  with PCLMULQDQ folding or with slicing-by-16 tables.
+ */
+
+#include <cstring>
+#include <cstdint>
+#include <immintrin.h>
+
+#include "crc32.h"
+
+namespace fun
+{
+    namespace
+    {
+        /*!
+         * \brief Slicing-by-16 tables for the reflected polynomial 0xEDB88320.
+         *
+         *  table[0] is the usual byte-at-a-time table. table[k][i] is the CRC of byte i
+         *  followed by k zero bytes, so 16 lookups advance the CRC by 16 bytes at once.
+         */
+        struct slicing_tables
+        {
+            uint32_t table[16][256];
+
+            slicing_tables()
+            {
+                for(int i = 0; i < 256; i++)
+                {
+                    uint32_t c = i;
+                    for(int b = 0; b < 8; b++) c = (c >> 1) ^ (0xEDB88320 & (0 - (c & 1)));
+                    table[0][i] = c;
+                }
+                for(int k = 1; k < 16; k++)
+                    for(int i = 0; i < 256; i++)
+                        table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xFF];
+            }
+        };
+
+        const slicing_tables TABLES;
+
+        /*!
+         * \brief Updates the CRC register with slicing-by-16.
+         */
+        uint32_t update_slicing16(uint32_t crc, const unsigned char * buf, size_t len)
+        {
+            const uint32_t (*t)[256] = TABLES.table;
+            while(len >= 16)
+            {
+                uint32_t a, b, c, d;
+                memcpy(&a, buf, 4);
+                memcpy(&b, buf + 4, 4);
+                memcpy(&c, buf + 8, 4);
+                memcpy(&d, buf + 12, 4);
+                a ^= crc;
+
+                crc = t[15][a & 0xFF] ^ t[14][(a >> 8) & 0xFF] ^ t[13][(a >> 16) & 0xFF] ^ t[12][a >> 24] ^
+                      t[11][b & 0xFF] ^ t[10][(b >> 8) & 0xFF] ^ t[9][(b >> 16) & 0xFF]  ^ t[8][b >> 24] ^
+                      t[7][c & 0xFF]  ^ t[6][(c >> 8) & 0xFF]  ^ t[5][(c >> 16) & 0xFF]  ^ t[4][c >> 24] ^
+                      t[3][d & 0xFF]  ^ t[2][(d >> 8) & 0xFF]  ^ t[1][(d >> 16) & 0xFF]  ^ t[0][d >> 24];
+
+                buf += 16;
+                len -= 16;
+            }
+
+            while(len--) crc = (crc >> 8) ^ t[0][(crc ^ *buf++) & 0xFF];
+            return crc;
+        }
+
+        /*!
+         * \brief Updates the CRC register by folding with carry-less multiplication.
+         *
+         *  Follows "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+         *  (Intel, 2009) with the bit-reflected constants for 0xEDB88320. Four 128 bit lanes are
+         *  folded 64 bytes at a time, reduced to one lane, folded 16 bytes at a time and finally
+         *  Barrett reduced to 32 bits.
+         *
+         *  len must be at least 64 and a multiple of 16.
+         */
+        __attribute__((target("pclmul,sse4.1")))
+        uint32_t update_pclmul(uint32_t crc, const unsigned char * buf, size_t len)
+        {
+            alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+            alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+            alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+            alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+            __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+            x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+            x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+            x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+            x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+            x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+            x0 = _mm_load_si128((const __m128i *)k1k2);
+            buf += 64;
+            len -= 64;
+
+            // Fold 64 bytes at a time
+            while(len >= 64)
+            {
+                x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+                x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+                x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+                x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+                x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+                x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+                x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+                x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+                x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(buf + 0x00)));
+                x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(buf + 0x10)));
+                x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(buf + 0x20)));
+                x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(buf + 0x30)));
+
+                buf += 64;
+                len -= 64;
+            }
+
+            // Fold the four lanes into one
+            x0 = _mm_load_si128((const __m128i *)k3k4);
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+            // Fold 16 bytes at a time
+            while(len >= 16)
+            {
+                x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+                x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+                x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)buf)), x5);
+                buf += 16;
+                len -= 16;
+            }
+
+            // Fold 128 bits to 64 bits
+            x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+            x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+            x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+            x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+            x2 = _mm_srli_si128(x1, 4);
+            x1 = _mm_and_si128(x1, x3);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_xor_si128(x1, x2);
+
+            // Barrett reduction to 32 bits
+            x0 = _mm_load_si128((const __m128i *)poly);
+            x2 = _mm_and_si128(x1, x3);
+            x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+            x2 = _mm_and_si128(x2, x3);
+            x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+            x1 = _mm_xor_si128(x1, x2);
+
+            return _mm_extract_epi32(x1, 1);
+        }
+    }
+
+    /*!
+     * - Initializations:
+     *   + #m_register -> 0xFFFFFFFF
+     *   + #m_engine -> the requested engine, resolved against what the CPU supports
+     */
+    crc32::crc32(engine e) :
+        m_register(0xFFFFFFFF),
+        m_engine(e)
+    {
+        if(m_engine == AUTO || m_engine == PCLMUL)
+            m_engine = pclmul_supported() ? PCLMUL : SLICING_BY_16;
+    }
+
+    void crc32::reset()
+    {
+        m_register = 0xFFFFFFFF;
+    }
+
+    bool crc32::pclmul_supported()
+    {
+        static const bool supported = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+        return supported;
+    }
+
+    /*!
+     *  With the #PCLMUL engine the largest multiple of 16 bytes is folded when there are at
+     *  least 64 bytes and the remainder goes through the tables.
+     */
+    void crc32::process_bytes(const void * data, size_t length)
+    {
+        const unsigned char * buf = static_cast<const unsigned char *>(data);
+
+        if(m_engine == PCLMUL && length >= 64)
+        {
+            size_t chunk = length & ~size_t(15);
+            m_register = update_pclmul(m_register, buf, chunk);
+            buf += chunk;
+            length -= chunk;
+        }
+
+        m_register = update_slicing16(m_register, buf, length);
+    }
+}
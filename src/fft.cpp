@@ -35,6 +35,35 @@ namespace fun
         m_fftw_out_inverse = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fft_length);
         m_fftw_plan_forward = fftw_plan_dft_1d(m_fft_length, m_fftw_in_forward, m_fftw_out_forward, FFTW_FORWARD, FFTW_MEASURE);
         m_fftw_plan_inverse = fftw_plan_dft_1d(m_fft_length, m_fftw_in_inverse, m_fftw_out_inverse, FFTW_BACKWARD, FFTW_MEASURE);
+
+        // 批量方案：输出跨度为带循环前缀的符号长度，并跳过前缀位置。
+        // FFTW_UNALIGNED 允许以后在调用者的缓冲区上执行，因此规划用的缓冲区可以立即释放。
+        int prefixed_length = m_fft_length * 5 / 4;
+        int prefix_length = prefixed_length - m_fft_length;
+        fftw_complex * plan_in = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fft_length * INVERSE_BATCH);
+        fftw_complex * plan_out = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * prefixed_length * INVERSE_BATCH);
+        m_fftw_plan_inverse_batch = fftw_plan_many_dft(1, &m_fft_length, INVERSE_BATCH,
+                                                       plan_in, nullptr, 1, m_fft_length,
+                                                       plan_out + prefix_length, nullptr, 1, prefixed_length,
+                                                       FFTW_BACKWARD, FFTW_MEASURE | FFTW_UNALIGNED);
+        m_fftw_plan_inverse_single = fftw_plan_many_dft(1, &m_fft_length, 1,
+                                                        plan_in, nullptr, 1, m_fft_length,
+                                                        plan_out + prefix_length, nullptr, 1, prefixed_length,
+                                                        FFTW_BACKWARD, FFTW_MEASURE | FFTW_UNALIGNED);
+        fftw_free(plan_in);
+        fftw_free(plan_out);
+    }
+
+    fft::~fft()
+    {
+        fftw_destroy_plan(m_fftw_plan_forward);
+        fftw_destroy_plan(m_fftw_plan_inverse);
+        fftw_destroy_plan(m_fftw_plan_inverse_batch);
+        fftw_destroy_plan(m_fftw_plan_inverse_single);
+        fftw_free(m_fftw_in_forward);
+        fftw_free(m_fftw_out_forward);
+        fftw_free(m_fftw_in_inverse);
+        fftw_free(m_fftw_out_inverse);
     }
 
 
@@ -89,6 +118,31 @@ namespace fun
             data[x] /= m_fft_length;
         }
     }
-}
 
+    /*!
+     * 每次对 #INVERSE_BATCH 个符号执行一次批量方案，剩余的符号逐个处理。
+     * IFFT 的结果直接写入每个符号的循环前缀之后，然后把最后 1/4 复制到前缀位置，
+     * 因此不需要中间缓冲区，也没有单独的缩放步骤。
+     */
+    void fft::inverse_prefixed(const std::complex<double> * data, int num_symbols, std::complex<double> * out)
+    {
+        int prefixed_length = m_fft_length * 5 / 4;
+        int prefix_length = prefixed_length - m_fft_length;
 
+        for(int x = 0; x < num_symbols; )
+        {
+            bool batch = num_symbols - x >= INVERSE_BATCH;
+            fftw_execute_dft(batch ? m_fftw_plan_inverse_batch : m_fftw_plan_inverse_single,
+                             (fftw_complex *)(data + x * m_fft_length),
+                             (fftw_complex *)(out + x * prefixed_length + prefix_length));
+            x += batch ? INVERSE_BATCH : 1;
+        }
+
+        // 添加循环前缀
+        for(int x = 0; x < num_symbols; x++)
+        {
+            std::complex<double> * symbol = out + x * prefixed_length;
+            memcpy(symbol, symbol + m_fft_length, prefix_length * sizeof(std::complex<double>));
+        }
+    }
+}
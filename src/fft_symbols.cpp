@@ -47,6 +47,7 @@ namespace fun
 
                 // Start a new vector
                 m_current_vector.tag = LTS_START;
+                m_current_vector.frame_id = input_buffer[x].frame_id;
                 m_offset = 16;
             }
 
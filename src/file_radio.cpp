@@ -0,0 +1,84 @@
+/*! \file file_radio.cpp
+ *  \brief C++ file for the file_radio class.
+ *
+ *  The file_radio class is a radio that reads received samples from a file and writes
+ *  transmitted samples to a file.
+ */
+
+#include <algorithm>
+#include <unistd.h>
+
+#include "file_radio.h"
+#include "sample_convert.h"
+
+#define FILE_RADIO_CHUNK 8192   //!< Samples converted per fread/fwrite call
+
+namespace fun
+{
+    file_radio::file_radio(std::string source, std::string sink, double rate, double tx_amp, bool loop) :
+        m_source(nullptr),
+        m_sink(nullptr),
+        m_rate(rate),
+        m_tx_amp(tx_amp),
+        m_loop(loop),
+        m_rx_index(0),
+        m_tx_index(0),
+        m_tx_buffer(FILE_RADIO_CHUNK),
+        m_rx_buffer(FILE_RADIO_CHUNK)
+    {
+        if(!source.empty()) m_source = fopen(source.c_str(), "rb");
+        if(!sink.empty()) m_sink = fopen(sink.c_str(), "wb");
+    }
+
+    file_radio::~file_radio()
+    {
+        stop_rx_stream();
+        if(m_source) fclose(m_source);
+        if(m_sink) fclose(m_sink);
+    }
+
+    void file_radio::send_samples(const std::complex<double> * samples, int num_samples, bool /*start_of_burst*/, bool end_of_burst)
+    {
+        m_tx_index += num_samples;
+        if(m_sink == nullptr) return;
+        for(int sent = 0; sent < num_samples; sent += FILE_RADIO_CHUNK)
+        {
+            int count = std::min(num_samples - sent, FILE_RADIO_CHUNK);
+            sample_convert::to_fc32(samples + sent, count, m_tx_amp, m_tx_buffer.data());
+            fwrite(m_tx_buffer.data(), sizeof(std::complex<float>), count, m_sink);
+        }
+        if(end_of_burst) fflush(m_sink);
+    }
+
+    /*!
+     *  At end of file (and with no source at all) this behaves like a radio that stopped
+     *  receiving: it sleeps for the usual 100 ms recv timeout and counts a timeout.
+     */
+    int file_radio::receive(int num_samples, std::complex<double> * buffer, bool & has_time, double & time)
+    {
+        has_time = true;
+        time = m_rx_index / m_rate;
+
+        int received = 0;
+        while(m_source && received < num_samples)
+        {
+            int count = std::min(num_samples - received, FILE_RADIO_CHUNK);
+            int got = fread(m_rx_buffer.data(), sizeof(std::complex<float>), count, m_source);
+            sample_convert::from_fc32(m_rx_buffer.data(), got, buffer + received);
+            received += got;
+            if(got < count)
+            {
+                if(!m_loop || (got == 0 && received == 0 && ftell(m_source) == 0)) break;
+                rewind(m_source);
+            }
+        }
+
+        if(received == 0)
+        {
+            m_timeouts++;
+            usleep(100000);
+        }
+        m_rx_index += received;
+        return received;
+    }
+}
@@ -15,7 +15,8 @@
  */
 
 #include <arpa/inet.h>
-#include <boost/crc.hpp>
+#include <algorithm>
+#include <cstring>
 
 #include "frame_builder.h"
 #include "interleaver.h"
@@ -38,50 +39,84 @@ namespace fun
     /*!
     * -Initializations
     *  + #m_ifft -> 64 point IFFT object
+    *  + workspaces -> sized for the longest frame (MAX_FRAME_SIZE bytes) at any rate
     */
     frame_builder::frame_builder() :
         m_ifft(64)
     {
+        // The DATA field is padded to whole symbols, so the higher rates need more data bits
+        int max_symbols = 0, max_data_bits = 0, max_bits = 0;
+        for(int r = RATE_1_2_BPSK; r <= RATE_3_4_QAM64; r++)
+        {
+            int num_symbols = ppdu::data_symbol_count(MAX_FRAME_SIZE, Rate(r));
+            max_symbols = std::max(max_symbols, num_symbols);
+            max_data_bits = std::max(max_data_bits, num_symbols * RateParams(Rate(r)).dbps);
+            max_bits = std::max(max_bits, num_symbols * RateParams(Rate(r)).cbps);
+        }
+
+        m_data.resize(max_data_bits / 8 + 1);
+        m_coded.resize(max_data_bits * 2);
+        m_bits.resize(48 + max_bits);
+        m_points.resize(48 * (max_symbols + 1));
+        m_symbols.resize(64 * (max_symbols + 1));
     }
 
     /*!
     *  build_frame 函数是主要函数，它将输入数据转换为原始输出样本。
-*  ppdu 类用于附加 PHY 头、加扰、卷积编码、交织并调制输入数据。
-*  符号映射器将调制后的数据转换为符号，并将数据、导频和空载波映射到各自的子载波。
-*  IFFT 执行逆快速傅里叶变换（IFFT）。
-*  循环前缀被添加，最后前导码被附加在帧的开头以完成帧的构建，
-*  然后返回该帧以传递给 USRP 块。
+    *  它只是分配输出向量并调用 #build_frame_into。负载太长时返回空向量，而不是全零的样本。
+     */
+    std::vector<std::complex<double> > frame_builder::build_frame(const std::vector<unsigned char> & payload, Rate rate, unsigned short service)
+    {
+        std::vector<std::complex<double> > frame(frame_length(payload.size(), rate));
+        if(build_frame_into(payload.data(), payload.size(), rate, frame.data(), frame.size(), service) == 0) frame.clear();
+        return frame;
+    }
+
+    int frame_builder::frame_length(int length, Rate rate)
+    {
+        return 320 + 80 * (1 /* SIGNAL */ + ppdu::data_symbol_count(length, rate));
+    }
 
+    /*!
+    *  ppdu 的静态编码函数在工作区中附加 PHY 头、加扰、卷积编码、打孔并交织输入数据。
+    *  调制时星座点直接乘以 1/64，这样 IFFT 之后不需要再缩放一遍。
+    *  符号映射器按 IFFT 的顺序放置数据、导频和空载波，批量 IFFT 把每个符号直接写到
+    *  输出缓冲区中循环前缀之后的位置，最后前导码被复制到帧的开头。
      */
-    std::vector<std::complex<double> > frame_builder::build_frame(std::vector<unsigned char> payload, Rate rate)
+    int frame_builder::build_frame_into(const unsigned char * payload, int length, Rate rate, std::complex<double> * frame, int capacity,
+                                        unsigned short service)
     {
-        //Append header, scramble, code, interleave, & modulate
-        ppdu ppdu_frame(payload, rate);        
-        std::vector<std::complex<double> > samples = ppdu_frame.encode();
+        return build_frame_into(nullptr, 0, payload, length, rate, frame, capacity, service);
+    }
 
-        // Map the subcarriers and insert pilots
-        symbol_mapper mapper = symbol_mapper();
-        std::vector<std::complex<double> > mapped = mapper.map(samples);
+    int frame_builder::build_frame_into(const unsigned char * header, int header_length, const unsigned char * body, int body_length,
+                                        Rate rate, std::complex<double> * frame, int capacity, unsigned short service)
+    {
+        int length = header_length + body_length;
+        int samples = frame_length(length, rate);
+        if(length > MAX_FRAME_SIZE || samples > capacity) return 0;
 
-        // Perform the IFFT
-        m_ifft.inverse(mapped);
+        RateParams rate_params = RateParams(rate);
+        int num_symbols = ppdu::data_symbol_count(length, rate);
+        const double scale = 1.0 / 64;
 
-        // Add the cyclic prefixes
-        std::vector<std::complex<double> > prefixed(mapped.size() * 80 / 64);
-        for(int x = 0; x < mapped.size() / 64; x++)
-        {
-            memcpy(&prefixed[x*80], &mapped[x*64+48], 16*sizeof(std::complex<double>));
-            memcpy(&prefixed[x*80+16], &mapped[x*64], 64*sizeof(std::complex<double>));
-        }
+        // Append header, scramble, code, puncture & interleave
+        ppdu::encode_header_bits(rate, length, &m_bits[0]);
+        ppdu::encode_data_bits(header, header_length, body, body_length, rate, m_data.data(), m_coded.data(), &m_bits[48], service);
 
-        // Prepend the preamble
-        std::vector<std::complex<double> > frame(prefixed.size() + 320);
+        // Modulate with the IFFT normalization folded into the constellation
+        modulator::modulate(&m_bits[0], 48, RATE_1_2_BPSK, &m_points[0], scale);
+        modulator::modulate(&m_bits[48], num_symbols * rate_params.cbps, rate, &m_points[48], scale);
 
+        // Map the subcarriers and insert pilots
+        m_mapper.map_fft_order(m_points.data(), num_symbols + 1, scale, m_symbols.data());
+
+        // Perform the IFFT and add the cyclic prefixes
+        m_ifft.inverse_prefixed(m_symbols.data(), num_symbols + 1, &frame[320]);
+
+        // Prepend the preamble
         memcpy(&frame[0], &PREAMBLE_SAMPLES[0], 320 * sizeof(std::complex<double>));
-        memcpy(&frame[320], &prefixed[0], prefixed.size() * sizeof(std::complex<double>));
 
-        // Return the samples
-        return frame;
+        return samples;
     }
 }
-
@@ -7,6 +7,8 @@
 
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <cmath>
 #include <arpa/inet.h>
 #include <boost/crc.hpp>
 
@@ -20,16 +22,24 @@
 #include "puncturer.h"
 #include "interleaver.h"
 #include "ppdu.h"
+#include "aggregator.h"
 
 namespace fun
 {
     /*!
      * - Initializations:
      *   + #m_current_frame -> Reset to a frame of 0 length with RATE_1_2_BPSK
+     *   + #m_frame_table -> frame_table
      */
-    frame_decoder::frame_decoder() :
+    frame_decoder::frame_decoder(frame_measurements * frame_table) :
         block("frame_decoder"),
-        m_current_frame(FrameData(RateParams(RATE_3_4_QAM64)))
+        m_current_frame(FrameData(RateParams(RATE_3_4_QAM64))),
+        m_frame_table(frame_table),
+        m_frame_id(0),
+        m_num_symbols(0),
+        m_pilot_phase_acc(0),
+        m_pilot_error_acc(0),
+        m_pilot_symbols(0)
     {
         m_current_frame.Reset(RateParams(RATE_3_4_QAM64), 0, 0);
     }
@@ -56,15 +66,48 @@ namespace fun
             {
                 memcpy(&m_current_frame.samples[m_current_frame.samples_copied], &input_buffer[x].samples[0], 48 * sizeof(std::complex<double>));
                 m_current_frame.samples_copied += 48;
+                m_pilot_phase_acc += input_buffer[x].pilot_phase * input_buffer[x].pilot_phase;
+                m_pilot_error_acc += input_buffer[x].pilot_error;
+                m_pilot_symbols++;
             }
 
             // Decode the frame if possible
             if(m_current_frame.samples_copied >= m_current_frame.sample_count && m_current_frame.sample_count != 0)
             {
                 ppdu frame = ppdu(m_current_frame.rate_params.rate, m_current_frame.length);
+                rx_frame result;
+                result.header_ok = true;
+                fill_metadata(result);
+
                 if(frame.decode_data(m_current_frame.samples))
                 {
-                    output_buffer.push_back(frame.get_payload());
+                    result.crc_ok = true;
+                    if(frame.is_aggregated())
+                    {
+                        // Pass on every intact subframe
+                        std::vector<std::vector<unsigned char> > mpdus = aggregator::unpack(frame.get_payload());
+                        result.aggregated = true;
+                        for(size_t m = 0; m < mpdus.size(); m++)
+                        {
+                            output_buffer.push_back(result);
+                            output_buffer.back().payload.swap(mpdus[m]);
+                        }
+                        if(mpdus.size() == 0)
+                        {
+                            result.crc_ok = false;
+                            output_buffer.push_back(result);
+                        }
+                    }
+                    else
+                    {
+                        output_buffer.push_back(result);
+                        output_buffer.back().payload = frame.get_payload();
+                    }
+                }
+                else
+                {
+                    result.crc_ok = false;
+                    output_buffer.push_back(result);
                 }
                 m_current_frame.sample_count = 0;
             }
@@ -72,16 +115,31 @@ namespace fun
             // Look for a start of frame
             if(input_buffer[x].tag == START_OF_FRAME)
             {
+                m_frame_id = input_buffer[x].frame_id;
+                m_pilot_phase_acc = input_buffer[x].pilot_phase * input_buffer[x].pilot_phase;
+                m_pilot_error_acc = input_buffer[x].pilot_error;
+                m_pilot_symbols = 1;
+
                 // Attempt to decode the header
                 ppdu h = ppdu();
                 std::vector<std::complex<double> > header_samples(48);
                 memcpy(header_samples.data(), input_buffer[x].samples, 48 * sizeof(std::complex<double>));
-                if(!h.decode_header(header_samples)) continue;
+                if(!h.decode_header(header_samples))
+                {
+                    rx_frame result;
+                    result.header_ok = false;
+                    result.crc_ok = false;
+                    m_num_symbols = 0;
+                    fill_metadata(result);
+                    output_buffer.push_back(result);
+                    continue;
+                }
 
                 // Calculate the frame sample count
                 int length = h.get_length();
                 RateParams rate_params = RateParams(h.get_rate());
                 int frame_sample_count = h.get_num_symbols() * 48;
+                m_num_symbols = h.get_num_symbols();
 
                 // Start a new frame
                 m_current_frame.Reset(rate_params, frame_sample_count, length);
@@ -90,6 +148,34 @@ namespace fun
             }
         }
     }
-}
 
+    /*!
+     *  The EVM is taken over the 4 pilots of every symbol in the frame (SIGNAL included) after
+     *  the phase correction, relative to the unit pilot power. This is cheap and available for
+     *  frames that fail to decode, which is when it is most wanted.
+     */
+    void frame_decoder::fill_metadata(rx_frame & frame)
+    {
+        frame.aggregated = false;
+        frame.rate = m_current_frame.rate_params.rate;
+        frame.length = frame.header_ok ? m_current_frame.length : 0;
+        frame.num_symbols = m_num_symbols;
+        frame.evm_db = 10 * std::log10(std::max(m_pilot_error_acc / m_pilot_symbols, 1e-30));
+        frame.pilot_phase_rms = std::sqrt(m_pilot_phase_acc / m_pilot_symbols);
 
+        if(m_frame_table)
+        {
+            const frame_measurements & m = m_frame_table[m_frame_id % FRAME_TABLE_SIZE];
+            frame.start_sample = m.start_sample;
+            frame.rssi_dbfs = m.rssi_dbfs;
+            frame.snr_db = m.snr_db;
+            frame.cfo = m.cfo;
+            frame.decode_latency_us = (boost::posix_time::microsec_clock::local_time() - m.detected).total_microseconds();
+        }
+        else
+        {
+            frame.start_sample = 0;
+            frame.rssi_dbfs = frame.snr_db = frame.cfo = frame.decode_latency_us = NAN;
+        }
+    }
+}
@@ -5,8 +5,10 @@
  * short training sequence in the preamble.
  */
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <cmath>
 
 #include "frame_detector.h"
 
@@ -19,17 +21,38 @@ namespace fun
      *   + #m_carryover      -> #STS_LENGTH (16 samples)
      *   + #m_plateau_length -> 0
      *   + #m_plateau_flag   -> false
+     *   + #m_frame_id       -> 0
+     *   + #m_input          -> nullptr
      */
-    frame_detector::frame_detector() :
+    frame_detector::frame_detector(frame_measurements * frame_table) :
         block("frame_detector"),
         m_power_acc(STS_LENGTH),
         m_corr_acc(STS_LENGTH),
         m_carryover(STS_LENGTH, 0),
         m_plateau_length(0),
-        m_plateau_flag(false)
+        m_plateau_flag(false),
+        m_frame_table(frame_table),
+        m_frame_id(0),
+        m_input(nullptr),
+        m_input_count(0)
     {
     }
 
+    void frame_detector::set_input(const std::complex<double> * samples, int count)
+    {
+        m_input = samples;
+        m_input_count = count;
+    }
+
+    void frame_detector::reset()
+    {
+        std::fill(m_carryover.begin(), m_carryover.end(), std::complex<double>(0, 0));
+        m_corr_acc.clear();
+        m_power_acc.clear();
+        m_plateau_length = 0;
+        m_plateau_flag = false;
+    }
+
     /*!
      *  该块使用自相关来检测短训练序列。
 *  这种自相关是通过移动窗口平均值实现的，
@@ -40,24 +63,30 @@ namespace fun
      */
     void frame_detector::work()
     {
-        if(input_buffer.size() == 0) return;
-        output_buffer.resize(input_buffer.size());
+        // The samples come either from the caller's buffer (see #set_input()) or from input_buffer
+        const std::complex<double> * input = m_input ? m_input : input_buffer.data();
+        int count = m_input ? m_input_count : input_buffer.size();
+        m_input = nullptr;
+
+        if(count == 0) return;
+        output_buffer.resize(count);
+        boost::posix_time::ptime now;
 
         // Step through the samples
-        for(int x = 0; x < input_buffer.size(); x++)
+        for(int x = 0; x < count; x++)
         {
             output_buffer[x].tag = NONE;
 
             // Get the delayed samples
             std::complex<double> delayed;
             if(x < STS_LENGTH) delayed = m_carryover[x];
-            else delayed = input_buffer[x-STS_LENGTH];
+            else delayed = input[x-STS_LENGTH];
 
             // Update the correlation accumulators
-            m_corr_acc.add(input_buffer[x] * std::conj(delayed));
+            m_corr_acc.add(input[x] * std::conj(delayed));
 
             // Update the power accumulator
-            m_power_acc.add(std::norm(input_buffer[x]));
+            m_power_acc.add(std::norm(input[x]));
 
             // Calculate the normalized correlations
             double corr = std::abs(m_corr_acc.sum) / m_power_acc.sum;
@@ -69,6 +98,17 @@ namespace fun
                 {
                     output_buffer[x].tag = STS_START;
                     m_plateau_flag = true;
+
+                    // Start the measurements of a new frame
+                    m_frame_id++;
+                    output_buffer[x].frame_id = m_frame_id;
+                    if(m_frame_table)
+                    {
+                        if(now.is_not_a_date_time()) now = boost::posix_time::microsec_clock::local_time();
+                        frame_measurements & frame = m_frame_table[m_frame_id % FRAME_TABLE_SIZE];
+                        frame.detected = now;
+                        frame.rssi_dbfs = 10 * std::log10(m_power_acc.sum / STS_LENGTH);
+                    }
                 }
             }
             else
@@ -76,18 +116,19 @@ namespace fun
                 if(m_plateau_flag)
                 {
                     output_buffer[x].tag = STS_END;
+                    output_buffer[x].frame_id = m_frame_id;
                     m_plateau_flag = false;
                 }
                 m_plateau_length = 0;
             }
 
             // Pass through the sample
-            output_buffer[x].sample = input_buffer[x];
+            output_buffer[x].sample = input[x];
         }
 
         // Carryover the last 16 output samples
         memcpy(&m_carryover[0],
-               &input_buffer[input_buffer.size() - STS_LENGTH],
+               &input[count - STS_LENGTH],
                STS_LENGTH * sizeof(std::complex<double>));
     }
 
@@ -11,30 +11,69 @@
 
 namespace fun
 {
+    namespace
+    {
+        /*!
+         * \brief Forward and inverse permutation for one (cbps, bpsc) pair, built at compile time.
+         */
+        template<int Cbps, int Bpsc>
+        struct interleave_table
+        {
+            unsigned short forward[Cbps];
+            unsigned short inverse[Cbps];
+
+            constexpr interleave_table() : forward(), inverse()
+            {
+                for(int k = 0; k < Cbps; k++)
+                {
+                    unsigned int j = BitInterleave(Cbps / Bpsc, Bpsc).index(k);
+                    forward[k] = j;
+                    inverse[j] = k;
+                }
+            }
+        };
+
+        constexpr interleave_table<48, 1> TABLE_BPSK;
+        constexpr interleave_table<96, 2> TABLE_QPSK;
+        constexpr interleave_table<192, 4> TABLE_QAM16;
+        constexpr interleave_table<288, 6> TABLE_QAM64;
+    }
+
+    // Look up the permutation for a rate
+    interleave_map interleaver::get_map(Rate rate)
+    {
+        switch(RateParams(rate).bpsc)
+        {
+            case 2: return interleave_map{TABLE_QPSK.forward, TABLE_QPSK.inverse, 96};
+            case 4: return interleave_map{TABLE_QAM16.forward, TABLE_QAM16.inverse, 192};
+            case 6: return interleave_map{TABLE_QAM64.forward, TABLE_QAM64.inverse, 288};
+            default: return interleave_map{TABLE_BPSK.forward, TABLE_BPSK.inverse, 48};
+        }
+    }
+
     // Interleave some data
-    std::vector<unsigned char> interleaver::interleave(std::vector<unsigned char> data)
+    std::vector<unsigned char> interleaver::interleave(const std::vector<unsigned char> & data, Rate rate)
     {
-        std::vector<unsigned int> interleave_map;
-        BitInterleave(48, 1).fill(interleave_map, false);
+        interleave_map map = get_map(rate);
+        assert(data.size() % map.cbps == 0);
 
         std::vector<unsigned char> data_interleaved(data.size());
-        for(int x = 0; x < data.size(); x += interleave_map.size())
-            for(int y = 0; y < interleave_map.size(); y++)
-                data_interleaved[x + interleave_map[y]] = data[x + y];
+        for(int x = 0; x < data.size(); x += map.cbps)
+            for(int y = 0; y < map.cbps; y++)
+                data_interleaved[x + map.forward[y]] = data[x + y];
         return data_interleaved;
     }
 
     // Deinterleave some data
-    std::vector<unsigned char> interleaver::deinterleave(std::vector<unsigned char> data)
+    std::vector<unsigned char> interleaver::deinterleave(const std::vector<unsigned char> & data, Rate rate)
     {
-        std::vector<unsigned int> deinterleave_map;
-        BitInterleave(48, 1).fill(deinterleave_map, true);
+        interleave_map map = get_map(rate);
+        assert(data.size() % map.cbps == 0);
 
         std::vector<unsigned char>data_deinterleaved(data.size());
-        for(int s = 0; s < data.size(); s += deinterleave_map.size())
-            for(int t = 0; t < deinterleave_map.size(); t++)
-                data_deinterleaved[s + deinterleave_map[t]] = data[s + t];
+        for(int s = 0; s < data.size(); s += map.cbps)
+            for(int t = 0; t < map.cbps; t++)
+                data_deinterleaved[s + map.inverse[t]] = data[s + t];
         return data_deinterleaved;
     }
 }
-
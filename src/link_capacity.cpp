@@ -0,0 +1,85 @@
+/*! \file link_capacity.cpp
+ *  \brief C++ file for the link_capacity class.
+ *
+ *  link_capacity 根据 PHY 速率估算链路能承载的有效载荷吞吐量。
+ */
+
+#include "link_capacity.h"
+#include "aggregator.h"
+#include "frame_builder.h"
+#include "ppdu.h"
+
+namespace fun
+{
+    link_capacity::link_capacity(double samp_rate, int gap_samples) :
+        m_samp_rate(samp_rate),
+        m_gap_samples(gap_samples)
+    {
+    }
+
+    double link_capacity::symbol_duration() const
+    {
+        return 80 / m_samp_rate;
+    }
+
+    /*!
+     *  frame_builder::frame_length() 已经包括前导码、SIGNAL 符号，以及 SERVICE、CRC、tail
+     *  和填充到整数个符号之后的数据符号。
+     */
+    double link_capacity::ppdu_airtime(int length, Rate rate) const
+    {
+        return (frame_builder::frame_length(length, rate) + m_gap_samples) / m_samp_rate;
+    }
+
+    int link_capacity::padding_bits(int length, Rate rate)
+    {
+        int bits = 16 /* service */ + 8 * (length + 4 /* CRC */) + 6 /* tail */;
+        return ppdu::data_symbol_count(length, rate) * RateParams(rate).dbps - bits;
+    }
+
+    int link_capacity::aligned_length(int max_length, Rate rate, int extra_length)
+    {
+        int dbps = RateParams(rate).dbps;
+        int overhead = 16 /* service */ + 32 /* CRC */ + 6 /* tail */;
+        // max_length 本身可能已经在最后一个符号里只留下不到一个字节的填充
+        int symbols = (overhead + 8 * (max_length + extra_length) + dbps - 1) / dbps;
+        int length = (symbols * dbps - overhead) / 8 - extra_length;
+        if(length > max_length) length = ((symbols - 1) * dbps - overhead) / 8 - extra_length;
+        return length > 0 ? length : max_length;
+    }
+
+    /*!
+     *  除最后一个子帧外都填充到 4 字节边界，与 aggregator::pack() 相同。
+     */
+    int link_capacity::mpdus_per_ppdu(int mpdu_length)
+    {
+        int last = AGGREGATE_DELIMITER_SIZE + mpdu_length + 4 /* CRC */;
+        if(mpdu_length > 0xFFF || last > MAX_FRAME_SIZE) return 0;
+        return 1 + (MAX_FRAME_SIZE - last) / aggregator::subframe_length(mpdu_length);
+    }
+
+    double link_capacity::payload_throughput(Rate rate, int mpdu_length, bool aggregate) const
+    {
+        if(mpdu_length <= 0) return 0;
+
+        if(!aggregate)
+        {
+            if(mpdu_length > MAX_FRAME_SIZE) return 0;
+            return 8.0 * mpdu_length / ppdu_airtime(mpdu_length, rate);
+        }
+
+        int count = mpdus_per_ppdu(mpdu_length);
+        if(count == 0) return 0;
+        int length = (count - 1) * aggregator::subframe_length(mpdu_length) +
+                     AGGREGATE_DELIMITER_SIZE + mpdu_length + 4 /* CRC */;
+        return 8.0 * count * mpdu_length / ppdu_airtime(length, rate);
+    }
+
+    double link_capacity::video_bitrate(Rate rate, int mpdu_length, int header_length, double headroom,
+                                        bool aggregate) const
+    {
+        if(mpdu_length <= header_length) return 0;
+        double video_fraction = double(mpdu_length - header_length) / mpdu_length;
+        return payload_throughput(rate, mpdu_length, aggregate) * video_fraction * headroom;
+    }
+}
@@ -0,0 +1,105 @@
+/*! \file loopback_radio.cpp
+ *  \brief C++ file for the loopback_radio class.
+ *
+ *  The loopback_radio class is an in-process radio whose receiver gets exactly the samples its
+ *  transmitter sent.
+ */
+
+#include <algorithm>
+#include <chrono>
+
+#include "loopback_radio.h"
+#include "sample_convert.h"
+
+namespace fun
+{
+    loopback_radio::loopback_radio(double rate, double tx_amp, int capacity) :
+        m_rate(rate),
+        m_tx_amp(tx_amp),
+        m_fifo(capacity),
+        m_write(0),
+        m_read(0)
+    {
+    }
+
+    loopback_radio::~loopback_radio()
+    {
+        stop_rx_stream();
+    }
+
+    /*!
+     *  The samples are copied in as many contiguous pieces as the ring needs, the lock is
+     *  only held to update the positions so the receiver can copy out at the same time.
+     */
+    void loopback_radio::send_samples(const std::complex<double> * samples, int num_samples, bool /*start_of_burst*/, bool /*end_of_burst*/)
+    {
+        int capacity = m_fifo.size();
+        int sent = 0;
+        while(sent < num_samples)
+        {
+            unsigned long long write;
+            int count;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_not_full.wait(lock, [&]{ return m_write - m_read < (unsigned long long)capacity; });
+                write = m_write;
+                count = std::min<unsigned long long>(num_samples - sent, capacity - (m_write - m_read));
+            }
+
+            int offset = write % capacity;
+            count = std::min(count, capacity - offset);
+            sample_convert::scale_fc64(samples + sent, count, m_tx_amp, &m_fifo[offset]);
+            sent += count;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_write += count;
+            }
+            m_not_empty.notify_one();
+        }
+    }
+
+    unsigned long long loopback_radio::get_tx_samples()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_write;
+    }
+
+    /*!
+     *  Like a UHD recv, this waits until the whole request can be filled. On a timeout the
+     *  samples that are already there stay queued for the next call.
+     */
+    int loopback_radio::receive(int num_samples, std::complex<double> * buffer, bool & has_time, double & time)
+    {
+        int capacity = m_fifo.size();
+        unsigned long long read;
+        int count;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            num_samples = std::min(num_samples, capacity);
+            if(!m_not_empty.wait_for(lock, std::chrono::milliseconds(100), [&]{ return m_write - m_read >= (unsigned long long)num_samples; }))
+            {
+                m_timeouts++;
+                has_time = false;
+                return 0;
+            }
+            read = m_read;
+            count = num_samples;
+        }
+
+        has_time = true;
+        time = read / m_rate;
+
+        int offset = read % capacity;
+        int first = std::min(count, capacity - offset);
+        std::copy(&m_fifo[offset], &m_fifo[offset] + first, buffer);
+        std::copy(&m_fifo[0], &m_fifo[0] + (count - first), buffer + first);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_read += count;
+        }
+        m_not_full.notify_one();
+        return count;
+    }
+}
@@ -11,92 +11,296 @@
  */
 
 #include <cstring>
+#include <immintrin.h>
 
 #include "modulator.h"
+#include "interleaver.h"
 #include "qam.h"
 
 namespace fun
 {
-
-    /*!
-     *  Modulates the input data vector using one of the following modulations
-     *  based on the given rate:
-     *  -BPSK
-     *  -QPSK
-     *  -16 QAM
-     *  -64 QAM
-     */
-    std::vector<std::complex<double> > modulator::modulate(std::vector<unsigned char> data, Rate rate)
+    namespace
     {
-        // Modualate the data
-        int modulated_sample_count = data.size();
-        std::vector<double> data_mod_buffer;
-        switch(rate)
+        /*!
+         * \brief Precomputed constellation for one modulation.
+         *
+         *  points[i] is the subcarrier value for the bpsc coded bits whose
+         *  binary value (first bit is the MSB) is i.
+         */
+        struct constellation
+        {
+            int bpsc;                           //!< Bits per subcarrier
+            std::complex<double> points[64];    //!< One point per bit combination
+        };
+
+        /*!
+         * \brief Encodes every combination of NumBits bits with the QAM template
+         *  so that the table is identical to per-bit encoding.
+         */
+        template<int NumBits>
+        void fill_axis(double power, double * axis)
         {
-            // BPSK
-            case RATE_1_2_BPSK: case RATE_2_3_BPSK: case RATE_3_4_BPSK:
+            QAM<NumBits> qam(power);
+            for(int i = 0; i < (1 << NumBits); i++)
             {
-                QAM<1> bpsk(1.0);
-                data_mod_buffer = std::vector<double>(modulated_sample_count * 2, 0);
-                for(int x = 0; x < modulated_sample_count; x++)
-                {
-                    bpsk.encode((const char *)&data[x], &data_mod_buffer[x*2]);
-                }
+                char bits[NumBits];
+                for(int b = 0; b < NumBits; b++) bits[b] = (i >> (NumBits - 1 - b)) & 1;
+                qam.encode(bits, &axis[i]);
+            }
+        }
 
-                break;
+        /*!
+         * \brief Builds the constellation table for bpsc bits per subcarrier.
+         *  The first half of the bits select the in-phase value and the second half
+         *  the quadrature value (BPSK only uses the in-phase axis).
+         */
+        constellation make_constellation(int bpsc)
+        {
+            constellation c;
+            c.bpsc = bpsc;
+            double axis[8] = {0};
+            int n = bpsc / 2;
+            switch(bpsc)
+            {
+                case 1: fill_axis<1>(1.0, axis); break;
+                case 2: fill_axis<1>(0.5, axis); break;
+                case 4: fill_axis<2>(0.5, axis); break;
+                case 6: fill_axis<3>(0.5, axis); break;
             }
 
-            // QPSK
-            case RATE_1_2_QPSK: case RATE_2_3_QPSK: case RATE_3_4_QPSK:
+            for(int i = 0; i < (1 << bpsc); i++)
             {
-                QAM<1> qpsk(0.5);
-                modulated_sample_count /= 2;
-                data_mod_buffer = std::vector<double>(modulated_sample_count * 2, 0);
-                for(int x = 0; x < modulated_sample_count; x++)
-                {
-                    qpsk.encode((const char *)&data[x*2], &data_mod_buffer[x*2]);
-                    qpsk.encode((const char *)&data[x*2+1], &data_mod_buffer[x*2+1]);
-                }
+                if(bpsc == 1) c.points[i] = std::complex<double>(axis[i], 0);
+                else c.points[i] = std::complex<double>(axis[i >> n], axis[i & ((1 << n) - 1)]);
+            }
+            return c;
+        }
 
-                break;
+        /*!
+         * \brief Gets the constellation table for the modulation used by rate.
+         */
+        const constellation & get_constellation(Rate rate)
+        {
+            static const constellation bpsk = make_constellation(1);
+            static const constellation qpsk = make_constellation(2);
+            static const constellation qam16 = make_constellation(4);
+            static const constellation qam64 = make_constellation(6);
+
+            switch(RateParams(rate).bpsc)
+            {
+                case 2: return qpsk;
+                case 4: return qam16;
+                case 6: return qam64;
+                default: return bpsk;
+            }
+        }
+
+        /*!
+         * \brief Maps groups of Bpsc bits through the table. The bit count is a template
+         *  parameter so that the index gather is fully unrolled.
+         */
+        template<int Bpsc>
+        void map_bits(const constellation & table, const unsigned char * bits, int count, std::complex<double> * symbols)
+        {
+            for(int x = 0; x < count; x++)
+            {
+                int index = 0;
+                for(int b = 0; b < Bpsc; b++) index = (index << 1) | (bits[b] & 1);
+                symbols[x] = table.points[index];
+                bits += Bpsc;
             }
+        }
+
+        /*!
+         * \brief Checks once whether the CPU can run the AVX2 demapper.
+         */
+        bool has_avx2()
+        {
+            static const bool avx2 = __builtin_cpu_supports("avx2");
+            return avx2;
+        }
+
+        /*!
+         * \brief Vectorized version of QAM::decode().
+         *
+         *  Decodes 8 real valued components (4 subcarriers, or 8 for BPSK where only the
+         *  in-phase component is used) per iteration. The recursion of QAM::decode() is
+         *  done on 32 bit lanes with the +-1 multiplies replaced by sign masks and the
+         *  clamp to 0 - 255 done by the saturating packs.
+         *
+         *  When inverse is given the soft bits are scattered straight to their
+         *  deinterleaved positions within each OFDM symbol of cbps bits. A symbol is
+         *  always a whole number of 8 component groups (48 or 96 components).
+         *
+         * \return The number of components decoded. The caller decodes the remainder.
+         */
+        __attribute__((target("avx2")))
+        int demap_avx2(const double * comp, bool real_only, int comp_count, double scale, int amp, int levels,
+                       const unsigned short * inverse, int cbps, unsigned char * bits)
+        {
+            const __m256d vscale = _mm256_set1_pd(scale);
+            const __m256i offset = _mm256_set1_epi32(128);
+            const __m256i ones = _mm256_set1_epi32(-1);
 
-            // QAM16
-            case RATE_1_2_QAM16: case RATE_2_3_QAM16: case RATE_3_4_QAM16:
+            int c = 0;
+            for(; c + 8 <= comp_count; c += 8)
             {
-                QAM<2> qam16(0.5);
-                modulated_sample_count /= 4;
-                data_mod_buffer = std::vector<double>(modulated_sample_count * 2, 0);
-                for(int x = 0; x < modulated_sample_count; x++)
+                __m256d a, b;
+                if(real_only)
                 {
-                    qam16.encode((const char *)&data[x*4], &data_mod_buffer[x*2]);
-                    qam16.encode((const char *)&data[x*4+2], &data_mod_buffer[x*2+1]);
+                    const double * p = comp + 2 * c;
+                    a = _mm256_unpacklo_pd(_mm256_loadu_pd(p), _mm256_loadu_pd(p + 4));
+                    b = _mm256_unpacklo_pd(_mm256_loadu_pd(p + 8), _mm256_loadu_pd(p + 12));
+                    a = _mm256_permute4x64_pd(a, _MM_SHUFFLE(3, 1, 2, 0));
+                    b = _mm256_permute4x64_pd(b, _MM_SHUFFLE(3, 1, 2, 0));
+                }
+                else
+                {
+                    a = _mm256_loadu_pd(comp + c);
+                    b = _mm256_loadu_pd(comp + c + 4);
+                }
+
+                __m256i pt = _mm256_set_m128i(_mm256_cvttpd_epi32(_mm256_mul_pd(b, vscale)),
+                                              _mm256_cvttpd_epi32(_mm256_mul_pd(a, vscale)));
+                __m256i flip = _mm256_setzero_si256();
+                __m256i vamp = _mm256_set1_epi32(amp);
+
+                unsigned char level_bits[3][8];
+                for(int l = 0; l < levels; l++)
+                {
+                    __m256i v = _mm256_add_epi32(_mm256_sub_epi32(_mm256_xor_si256(pt, flip), flip), offset);
+                    v = _mm256_packus_epi16(_mm256_packs_epi32(v, v), v);
+                    unsigned int lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(v));
+                    unsigned int hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(v, 1));
+                    memcpy(&level_bits[l][0], &lo, 4);
+                    memcpy(&level_bits[l][4], &hi, 4);
+
+                    __m256i sign = _mm256_srai_epi32(pt, 31);
+                    pt = _mm256_sub_epi32(pt, _mm256_sub_epi32(_mm256_xor_si256(vamp, sign), sign));
+                    flip = _mm256_xor_si256(sign, ones);
+                    vamp = _mm256_srli_epi32(vamp, 1);
                 }
 
-                break;
+                if(inverse == nullptr)
+                {
+                    unsigned char * out = bits + c * levels;
+                    for(int k = 0; k < 8; k++)
+                        for(int l = 0; l < levels; l++)
+                            *out++ = level_bits[l][k];
+                }
+                else
+                {
+                    int base = (c * levels) / cbps * cbps;
+                    const unsigned short * perm = inverse + (c * levels - base);
+                    unsigned char * out = bits + base;
+                    for(int k = 0; k < 8; k++)
+                        for(int l = 0; l < levels; l++)
+                            out[*perm++] = level_bits[l][k];
+                }
             }
+            return c;
+        }
+
+        /*!
+         * \brief Demaps count subcarriers with the QAM template, vectorizing when possible.
+         * \param real_only true for BPSK where the quadrature component is ignored.
+         * \param inverse Deinterleaving permutation of cbps bits or nullptr to keep the bits in order.
+         */
+        template<int NumBits>
+        void demap(double power, const std::complex<double> * symbols, int count, bool real_only,
+                   const unsigned short * inverse, int cbps, unsigned char * bits)
+        {
+            QAM<NumBits> qam(power);
+            const double * comp = reinterpret_cast<const double *>(symbols);
+            int comp_count = real_only ? count : count * 2;
 
-            // QAM64
-            case RATE_2_3_QAM64: case RATE_3_4_QAM64:
+            int done = 0;
+            if(has_avx2()) done = demap_avx2(comp, real_only, comp_count, qam.decode_scale(), qam.decode_amp(), NumBits, inverse, cbps, bits);
+
+            for(int c = done; c < comp_count; c++)
             {
-                QAM<3> qam64(0.5);
-                modulated_sample_count /= 6;
-                data_mod_buffer = std::vector<double>(modulated_sample_count * 2, 0);
-                for(int x = 0; x < modulated_sample_count; x++)
+                if(inverse == nullptr)
                 {
-                    qam64.encode((const char *)&data[x*6], &data_mod_buffer[x*2]);
-                    qam64.encode((const char *)&data[x*6+3], &data_mod_buffer[x*2+1]);
+                    qam.decode(real_only ? comp[2 * c] : comp[c], &bits[c * NumBits]);
+                    continue;
                 }
 
-                break;
+                unsigned char soft[NumBits];
+                qam.decode(real_only ? comp[2 * c] : comp[c], soft);
+                for(int l = 0; l < NumBits; l++)
+                {
+                    int p = c * NumBits + l;
+                    bits[p - p % cbps + inverse[p % cbps]] = soft[l];
+                }
             }
         }
 
-        std::vector<std::complex<double> > modulated_data(data_mod_buffer.size() / 2);
-        memcpy(&modulated_data[0], &data_mod_buffer[0], modulated_data.size() * sizeof(std::complex<double>));
+        /*!
+         * \brief Dispatches to the demapper for the modulation used by rate.
+         */
+        void demap_rate(const std::complex<double> * symbols, int count, Rate rate, const unsigned short * inverse, int cbps, unsigned char * bits)
+        {
+            switch(RateParams(rate).bpsc)
+            {
+                // BPSK
+                case 1: demap<1>(1.0, symbols, count, true, inverse, cbps, bits); break;
+
+                // QPSK
+                case 2: demap<1>(0.5, symbols, count, false, inverse, cbps, bits); break;
+
+                // QAM16
+                case 4: demap<2>(0.5, symbols, count, false, inverse, cbps, bits); break;
+
+                // QAM64
+                case 6: demap<3>(0.5, symbols, count, false, inverse, cbps, bits); break;
+            }
+        }
+    }
+
+    /*!
+     *  Modulates the input data vector using one of the following modulations
+     *  based on the given rate:
+     *  -BPSK
+     *  -QPSK
+     *  -16 QAM
+     *  -64 QAM
+     */
+    std::vector<std::complex<double> > modulator::modulate(const std::vector<unsigned char> & data, Rate rate)
+    {
+        int bpsc = RateParams(rate).bpsc;
+        std::vector<std::complex<double> > modulated_data(data.size() / bpsc);
+        modulate(data.data(), modulated_data.size() * bpsc, rate, modulated_data.data());
         return modulated_data;
     }
 
+    /*!
+     *  Gathers the bpsc bits of each subcarrier into a table index and looks up the
+     *  constellation point. A scaled copy of the table is made when scale is not 1, which
+     *  costs at most 64 multiplies instead of one per subcarrier.
+     */
+    void modulator::modulate(const unsigned char * bits, int bit_count, Rate rate, std::complex<double> * symbols, double scale)
+    {
+        const constellation * selected = &get_constellation(rate);
+        constellation scaled;
+        if(scale != 1.0)
+        {
+            scaled.bpsc = selected->bpsc;
+            for(int i = 0; i < (1 << scaled.bpsc); i++) scaled.points[i] = selected->points[i] * scale;
+            selected = &scaled;
+        }
+
+        const constellation & table = *selected;
+        int count = bit_count / table.bpsc;
+
+        switch(table.bpsc)
+        {
+            case 1: map_bits<1>(table, bits, count, symbols); break;
+            case 2: map_bits<2>(table, bits, count, symbols); break;
+            case 4: map_bits<4>(table, bits, count, symbols); break;
+            case 6: map_bits<6>(table, bits, count, symbols); break;
+        }
+    }
+
     /*!
     *  Demodulates the input data vector using one of the following modulations
     *  based on the given rate:
@@ -105,62 +309,29 @@ namespace fun
     *  -16 QAM
     *  -64 QAM
     */
-    std::vector<unsigned char> modulator::demodulate(std::vector<std::complex<double> > data, Rate rate)
+    std::vector<unsigned char> modulator::demodulate(const std::vector<std::complex<double> > & data, Rate rate)
     {
         RateParams rp = RateParams(rate);
+        std::vector<unsigned char> data_demodulated(data.size() * rp.bpsc, 0);
+        demodulate(data.data(), data.size(), rate, data_demodulated.data());
+        return data_demodulated;
+    }
 
-        // Demodulate the data
-        int coded_bit_count = data.size();
-        std::vector<unsigned char>data_demodulated(coded_bit_count * rp.bpsc, 0);
-        switch(rate)
-        {
-            // BPSK
-            case RATE_1_2_BPSK: case RATE_2_3_BPSK: case RATE_3_4_BPSK:
-            {
-                QAM<1> bpsk(1.0);
-                for(int s = 0; s < coded_bit_count; s++)
-                    bpsk.decode(data[s].real(), &data_demodulated[s]);
-                break;
-            }
-
-            // QPSK
-            case RATE_1_2_QPSK: case RATE_2_3_QPSK: case RATE_3_4_QPSK:
-            {
-                QAM<1> qpsk(0.5);
-                for(int s = 0; s < coded_bit_count; s++)
-                {
-                    qpsk.decode(data[s].real(), &data_demodulated[s*2]);
-                    qpsk.decode(data[s].imag(), &data_demodulated[s*2+1]);
-                }
-                break;
-            }
-
-            // QAM16
-            case RATE_1_2_QAM16: case RATE_2_3_QAM16: case RATE_3_4_QAM16:
-            {
-                QAM<2> qam16(0.5);
-                for(int s = 0; s < coded_bit_count; s++)
-                {
-                    qam16.decode(data[s].real(), &data_demodulated[s*4]);
-                    qam16.decode(data[s].imag(), &data_demodulated[s*4+2]);
-                }
-                break;
-            }
-
-            // QAM64
-            case RATE_2_3_QAM64: case RATE_3_4_QAM64:
-            {
-                QAM<3> qam64(0.5);
-                for(int s = 0; s < coded_bit_count; s++)
-                {
-                    qam64.decode(data[s].real(), &data_demodulated[s*6]);
-                    qam64.decode(data[s].imag(), &data_demodulated[s*6+3]);
-                }
-                break;
-            }
-        }
+    /*!
+     *  Produces bpsc soft bits per subcarrier, in-phase bits first.
+     */
+    void modulator::demodulate(const std::complex<double> * symbols, int symbol_count, Rate rate, unsigned char * bits)
+    {
+        demap_rate(symbols, symbol_count, rate, nullptr, 0, bits);
+    }
 
-        return data_demodulated;
+    /*!
+     *  Same as #demodulate but each soft bit is stored at its deinterleaved position,
+     *  which saves the separate interleaver::deinterleave pass and its copy.
+     */
+    void modulator::demodulate_deinterleave(const std::complex<double> * symbols, int symbol_count, Rate rate, unsigned char * bits)
+    {
+        interleave_map map = interleaver::get_map(rate);
+        demap_rate(symbols, symbol_count, rate, map.inverse, map.cbps, bits);
     }
 }
-
@@ -66,6 +66,9 @@ namespace fun
      * The phase rotation of each pilot symbol is calculated then averaged together. The inverse of this
      * rotation is the applied to each symbol. This is a fair assumption since the pilot symbols are evenly
      * dispersed throughout the symbol.
+     *
+     * The phase error and the pilot error left after correcting it are passed on with each
+     * symbol so frame_decoder can report the frame's pilot phase and EVM.
      */
     void phase_tracker::work()
     {
@@ -90,15 +93,27 @@ namespace fun
             }
 
             double angle = std::arg(phase_error);
+            std::complex<double> correction(std::cos(-angle), std::sin(-angle));
+
+            // Residual pilot error after the correction, used for the frame's EVM
+            double pilot_error = 0;
+            for(int p = 0; p < 4; p++)
+            {
+                int pilot = PILOTS[p][1] * POLARITY[m_symbol_count % 127];
+                pilot_error += std::norm(input_buffer[i].samples[PILOTS[p][0]] * correction - std::complex<double>(pilot, 0)) / 4.0;
+            }
 
             // Apply the phase correction to the data samples
             for(int s = 0; s < 48; s++)
             {
                 int index = DATA_SUBCARRIERS[s];
-                output_buffer[i].samples[s] = input_buffer[i].samples[index] * std::complex<double>(std::cos(-angle), std::sin(-angle));
+                output_buffer[i].samples[s] = input_buffer[i].samples[index] * correction;
             }
 
             output_buffer[i].tag = input_buffer[i].tag;
+            output_buffer[i].frame_id = input_buffer[i].frame_id;
+            output_buffer[i].pilot_phase = angle;
+            output_buffer[i].pilot_error = pilot_error;
             m_symbol_count++; //Keep track of the current symbol number in the frame
         }
 
@@ -8,7 +8,6 @@
  */
 
 #include <arpa/inet.h>
-#include <boost/crc.hpp>
 #include <iostream>
 
 #include "ppdu.h"
@@ -17,6 +16,8 @@
 #include "interleaver.h"
 #include "puncturer.h"
 #include "modulator.h"
+#include "scrambler.h"
+#include "crc32.h"
 
 namespace fun
 {
@@ -73,17 +74,54 @@ namespace fun
     }
 
 
+    /*!
+     * Encodes the header into coded bits and modulates it with BPSK.
+     */
+    std::vector<std::complex<double> > ppdu::encoder_header()
+    {
+        std::vector<unsigned char> interleaved(48 /* header is always a single 1/2 BPSK symbol */);
+        encode_header_bits(header.rate, header.length, interleaved.data());
+
+        // Modulate the header
+        return modulator::modulate(interleaved, RATE_1_2_BPSK);
+    }
+
+    /*!
+     * Encodes the payload into coded bits and modulates it at the rate in the header.
+     */
+    std::vector<std::complex<double> > ppdu::encode_data()
+    {
+        RateParams rate_params = RateParams(header.rate);
+        int num_symbols = data_symbol_count(payload.size(), header.rate);
+
+        std::vector<unsigned char> data(num_symbols * rate_params.dbps / 8 + 1);
+        std::vector<unsigned char> coded(num_symbols * rate_params.dbps * 2);
+        std::vector<unsigned char> interleaved(num_symbols * rate_params.cbps);
+        encode_data_bits(payload.data(), payload.size(), header.rate, data.data(), coded.data(), interleaved.data());
+
+        // Modulated the data
+        return modulator::modulate(interleaved, header.rate);
+    }
+
+    int ppdu::data_symbol_count(int length, Rate rate)
+    {
+        RateParams rate_params = RateParams(rate);
+        return std::ceil(
+                double((16 /* service */ + 8 * (length + 4 /* CRC */) + 6 /* tail */)) /
+                double(rate_params.dbps));
+    }
+
     /*!
      * Uses the rate_params to build the header. Note the header is NOT scrambled.
-     * Codes the header using a 1/2 convolutional code. Interleaves the header. And finally
+     * Codes the header using a 1/2 convolutional code and interleaves it. The caller
      * modulates the header using BPSK modulation.
      */
-    std::vector<std::complex<double> > ppdu::encoder_header()
+    void ppdu::encode_header_bits(Rate rate, int length, unsigned char * bits)
     {
         // Build the header from the rate field and length
-        RateParams rate_params = RateParams(header.rate);
+        RateParams rate_params = RateParams(rate);
         unsigned int header_field = 0;
-        header_field = ((rate_params.rate_field & 0xF) << 13) | (header.length & 0xFFF);
+        header_field = ((rate_params.rate_field & 0xF) << 13) | (length & 0xFFF);
 
         // Set the parity bit and align
         if(parity(header_field) == 1) header_field |= 131072;
@@ -95,73 +133,75 @@ namespace fun
         memcpy(header_bytes, &h, 3);
 
         // Convolutionally encode the header
-        std::vector<unsigned char> header_symbols(48 /* header is always a single 1/2 BPSK symbol */);
+        unsigned char header_symbols[48];
         viterbi v;
-        v.conv_encode(header_bytes, &header_symbols[0], 18 /* header is always 18 data bits */);
+        v.conv_encode(header_bytes, header_symbols, 18 /* header is always 18 data bits */);
 
         // Interleave the header
-        std::vector<unsigned char> interleaved = interleaver::interleave(header_symbols);
-
-        // Modulate the header
-        std::vector<std::complex<double> > modulated = modulator::modulate(interleaved, RATE_1_2_BPSK);
-
-        return modulated;
+        interleave_map map = interleaver::get_map(RATE_1_2_BPSK);
+        for(int k = 0; k < 48; k++) bits[map.forward[k]] = header_symbols[k];
+    }
 
+    /*!
+     * Appends the CRC, scrambles, codes and then punctures and interleaves in one pass:
+     * every coded bit that survives puncturing is written straight to its interleaved
+     * position within its OFDM symbol.
+     */
+    void ppdu::encode_data_bits(const unsigned char * payload, int length, Rate rate,
+                                unsigned char * data, unsigned char * coded, unsigned char * bits,
+                                unsigned short service)
+    {
+        encode_data_bits(nullptr, 0, payload, length, rate, data, coded, bits, service);
     }
 
-    std::vector<std::complex<double> > ppdu::encode_data()
+    void ppdu::encode_data_bits(const unsigned char * header, int header_length,
+                                const unsigned char * body, int body_length, Rate rate,
+                                unsigned char * data, unsigned char * coded, unsigned char * bits,
+                                unsigned short service)
     {
         // Get the RateParams
-        RateParams rate_params = RateParams(header.rate);
-
-        // Calculate the number of symbols
-        int num_symbols = std::ceil(
-                double((16 /* service */ + 8 * (payload.size() + 4 /* CRC */) + 6 /* tail */)) /
-                double(rate_params.dbps));
+        RateParams rate_params = RateParams(rate);
+        int length = header_length + body_length;
+        int num_symbols = data_symbol_count(length, rate);
 
         // Calculate the number of data bits/bytes (including padding bits)
         int num_data_bits = num_symbols * rate_params.dbps;
         int num_data_bytes = num_data_bits / 8;
 
-        unsigned short service_field = 0;
-
         // Concatenate the service and payload
-        std::vector<unsigned char> data(num_data_bytes+1, 0);
-        memcpy(&data[0], &service_field, 2);
-        memcpy(&data[2], payload.data(), payload.size());
+        memset(data, 0, num_data_bytes + 1);
+        memcpy(&data[0], &service, 2);
+        if(header_length > 0) memcpy(&data[2], header, header_length);
+        memcpy(&data[2 + header_length], body, body_length);
 
         // Calcualate and append the CRC
-        boost::crc_32_type crc;
-        crc.process_bytes(&data[0], 2 + payload.size());
+        crc32 crc;
+        crc.process_bytes(&data[0], 2 + length);
         unsigned int calculated_crc = crc.checksum();
-        memcpy(&data[2 + payload.size()], &calculated_crc, 4);
+        memcpy(&data[2 + length], &calculated_crc, 4);
 
-        // Scramble the data
-        std::vector<unsigned char> scrambled(num_data_bytes+1, 0);
-        int state = 93, feedback = 0;
-        for(int x = 0; x < num_data_bytes; x++)
-        {
-           feedback = (!!(state & 64)) ^ (!!(state & 8));
-           scrambled[x] = feedback ^ data[x];
-           state = ((state << 1) & 0x7E) | feedback;
-        }
-        data.swap(scrambled);
+        // Scramble the data, then zero the 6 tail bits so the encoder ends in state 0
+        scrambler::get(SCRAMBLER_DEFAULT_SEED).apply(&data[0], (num_data_bits + 7) / 8);
+        for(int x = num_data_bits - 6; x < num_data_bits; x++) data[x / 8] &= ~(0x80 >> (x % 8));
 
         // Convolutionally encode the data
-        std::vector<unsigned char> data_encoded(num_data_bits * 2, 0);
         viterbi v;
-        v.conv_encode(&data[0], data_encoded.data(), num_data_bits-6);
-
-        // Puncture the data
-        std::vector<unsigned char> data_punctured = puncturer::puncture(data_encoded, header.rate);
-
-        // Interleave the data
-        std::vector<unsigned char> data_interleaved = interleaver::interleave(data_punctured);
+        v.conv_encode(&data[0], coded, num_data_bits-6);
 
-        // Modulated the data
-        std::vector<std::complex<double> > data_modulated = modulator::modulate(data_interleaved, header.rate);
-
-        return data_modulated;
+        // Puncture and interleave the data
+        puncture_pattern punc = puncturer::pattern(rate_params);
+        interleave_map map = interleaver::get_map(rate);
+        int out = 0, k = 0;
+        for(int x = 0; x < num_data_bits * 2; x++)
+        {
+            if(punc.keep != nullptr && !punc.keep[x % punc.period]) continue;
+            bits[out + map.forward[k]] = coded[x];
+            if(++k == map.cbps)
+            {
+                k = 0;
+                out += map.cbps;
+            }
+        }
     }
 
     // Decode a PLCP header from 48 complex samples
@@ -169,11 +209,9 @@ namespace fun
     {
         assert(samples.size() == 48);
 
-        // Demodulate the header
-        std::vector<unsigned char> demodulated = modulator::demodulate(samples, RATE_1_2_BPSK);
-
-        // Deinterleave the header
-        std::vector<unsigned char> deinterleaved = interleaver::deinterleave(demodulated);
+        // Demodulate and deinterleave the header
+        std::vector<unsigned char> deinterleaved(48);
+        modulator::demodulate_deinterleave(samples.data(), samples.size(), RATE_1_2_BPSK, deinterleaved.data());
 
         // Convolutionally decode the header        
         std::vector<unsigned char> header_bytes(4);
@@ -234,44 +272,38 @@ namespace fun
         int num_data_bits = num_symbols * rate_params.dbps;
         int num_data_bytes = num_data_bits / 8;
 
-        // 数据解调：
-        std::vector<unsigned char> demodulated = modulator::demodulate(samples, header.rate);
-
-        // 反交织 (Deinterleaving)：
-        std::vector<unsigned char> deinterleaved = interleaver::deinterleave(demodulated);
+        // 数据解调与反交织（软比特直接写入反交织后的位置）：
+        std::vector<unsigned char> deinterleaved(samples.size() * rate_params.bpsc);
+        modulator::demodulate_deinterleave(samples.data(), samples.size(), header.rate, deinterleaved.data());
 
-        // 反打孔 (Depuncturing)：
-        std::vector<unsigned char> depunctured = puncturer::depuncture(deinterleaved, header.rate);
-
-        // 卷积解码：
+        // 卷积解码（打孔位置在维特比分支度量中按擦除处理，无需反打孔）：
         int data_bits = 16 /* service */ + (header.length + 4 /* CRC */) * 8 + 6 /* tail bits */;
         int data_bytes = data_bits / 8 + 1;
         data_bits = num_data_bits - 6;
         data_bytes = num_data_bytes;
         std::vector<unsigned char> decoded(data_bytes);
         viterbi v;
-        v.conv_decode(&depunctured[0], &decoded[0], data_bits);
+        v.conv_decode(deinterleaved.data(), &decoded[0], data_bits, header.rate);
 
-        // 去扰码 (Descrambling)：
-        std::vector<unsigned char> descrambled(num_data_bytes+1, 0);
-        int state = 93, feedback = 0;
-        for(int x = 0; x < num_data_bytes; x++)
+        // 去扰码 (Descrambling)：扰码种子由 SERVICE 字段的前 7 个比特恢复
+        int seed = scrambler::recover_seed(decoded[0]);
+        if(seed == 0)
         {
-           feedback = (!!(state & 64)) ^ (!!(state & 8));
-           descrambled[x] = feedback ^ decoded[x];
-           state = ((state << 1) & 0x7E) | feedback;
+            return false;
         }
-        decoded.swap(descrambled);
+        scrambler::get(seed).apply(&decoded[0], num_data_bytes);
 
         // CRC 校验：
-        boost::crc_32_type crc;
+        crc32 crc;
         crc.process_bytes(&decoded[0], 2 + header.length);
         unsigned int calculated_crc = crc.checksum();
         unsigned int given_crc = 0;
         memcpy(&given_crc, &decoded[2 + header.length], 4);
+        m_crc_ok = given_crc == calculated_crc;
+        memcpy(&header.service, &decoded[0], 2);
 
-        // CRC 校验失败处理：
-        if(given_crc != calculated_crc)
+        // CRC 校验失败处理：聚合帧的子帧各有 CRC，仍然交给上层拆分
+        if(!m_crc_ok && !is_aggregated())
         {
             std::cerr << "Invalid CRC (length " << header.length << ")" << std::endl;
             // Indicate failure
@@ -280,14 +312,9 @@ namespace fun
         else
         {
             // Copy the payload
-    //        std::vector<unsigned char> payload(length);
             payload.resize(header.length);
             memcpy(&payload[0], &decoded[2 /* skip the service field */], header.length);
 
-            // Fill the output values
-    //        data_out.rate = rate;
-            memcpy(&header.service, &decoded[0], 2);
-    //        data_out.length = length;
             // Indicate success
             return true;
         }
@@ -295,4 +322,3 @@ namespace fun
     }
 
 }
-
@@ -13,6 +13,8 @@
 
 namespace fun
 {
+    static const unsigned char KEEP_3_4[6] = { 1, 1, 0, 1, 0, 1 }; //!< 3/4 keeps bits 0, 1, 3, 5 of every 6
+    static const unsigned char KEEP_2_3[4] = { 1, 0, 1, 1 };       //!< 2/3 keeps bits 0, 2, 3 of every 4
 
     /*!
      *  Punctures the convolutionally encoded data based on the desired PHY rate in rate_params.
@@ -122,5 +124,23 @@ namespace fun
         }
     }
 
-}
+    /*!
+     *  Returns the keep map matching the loops in #puncture and #depuncture so that
+     *  consumers of the punctured stream agree with them bit for bit.
+     */
+    puncture_pattern puncturer::pattern(RateParams rate_params)
+    {
+        switch(rate_params.rate)
+        {
+            case RATE_3_4_BPSK: case RATE_3_4_QPSK: case RATE_3_4_QAM16: case RATE_3_4_QAM64:
+                return puncture_pattern{KEEP_3_4, 6};
 
+            case RATE_2_3_BPSK: case RATE_2_3_QPSK: case RATE_2_3_QAM16: case RATE_2_3_QAM64:
+                return puncture_pattern{KEEP_2_3, 4};
+
+            default:
+                return puncture_pattern{nullptr, 2};
+        }
+    }
+
+}
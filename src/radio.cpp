@@ -0,0 +1,150 @@
+/*! \file radio.cpp
+ *  \brief C++ file for the radio interface.
+ *
+ *  The radio class is the interface the transmitter and receiver use to move baseband samples.
+ */
+
+#include <algorithm>
+#include <unistd.h>
+
+#include "radio.h"
+
+namespace fun
+{
+    radio::radio() :
+        m_overflows(0),
+        m_timeouts(0),
+        m_late_packets(0),
+        m_other_errors(0),
+        m_late_bursts(0),
+        m_rx_running(false),
+        m_ring_full(0),
+        m_rx_samples(0)
+    {
+    }
+
+    radio::~radio()
+    {
+        stop_rx_stream();
+    }
+
+    void radio::send_burst_sync(const std::vector<std::complex<double> > & samples)
+    {
+        send_burst(samples);
+    }
+
+    void radio::send_burst(const std::vector<std::complex<double> > & samples)
+    {
+        send_samples(samples.data(), samples.size(), true, true);
+    }
+
+    /*!
+     * 默认实现适用于以样本计时的设备：设备时间就是已发送的样本数，所以用零样本把时钟推进到
+     * time，然后发送脉冲串。time 已经过去的脉冲串会被整个丢弃，与 UHD 对迟到的定时脉冲串的
+     * 处理方式相同。
+     */
+    bool radio::send_burst_at(const std::vector<std::complex<double> > & samples, double time)
+    {
+        long long gap = time_to_samples(time) - time_to_samples(get_time_now());
+        if(gap < 0)
+        {
+            m_late_bursts++;
+            return false;
+        }
+
+        std::vector<std::complex<double> > zeros(std::min<long long>(gap, RADIO_RX_BLOCK));
+        while(gap > 0)
+        {
+            int count = std::min<long long>(gap, zeros.size());
+            send_samples(zeros.data(), count, false, false);
+            gap -= count;
+        }
+        send_samples(samples.data(), samples.size(), true, true);
+        return true;
+    }
+
+    int radio::poll_late_bursts()
+    {
+        return m_late_bursts.exchange(0);
+    }
+
+    void radio::get_samples(int num_samples, std::vector<std::complex<double> > & buffer)
+    {
+        double time;
+        get_samples(num_samples, buffer, time);
+    }
+
+    bool radio::get_samples(int num_samples, std::vector<std::complex<double> > & buffer, double & time)
+    {
+        bool has_time;
+        m_rx_samples += receive(num_samples, &buffer[0], has_time, time);
+        return has_time;
+    }
+
+    /*!
+     * 创建环形缓冲区（第一次调用时，或者块的大小改变时）并启动 RX 线程。
+     */
+    void radio::start_rx_stream(int block_samples, int num_blocks)
+    {
+        if(m_rx_running) return;
+        if(!m_rx_ring || m_rx_ring->block_samples() != block_samples || m_rx_ring->num_blocks() != num_blocks)
+            m_rx_ring.reset(new rx_ring(block_samples, num_blocks));
+
+        m_rx_running = true;
+        m_rx_thread = std::thread(&radio::run_rx_stream, this);
+    }
+
+    void radio::stop_rx_stream()
+    {
+        m_rx_running = false;
+        if(m_rx_thread.joinable()) m_rx_thread.join();
+    }
+
+    /*!
+     * 样本直接接收到环形缓冲区的下一块中，然后发布给消费者。如果消费者跟不上、
+     * 环形缓冲区已满，仍然要读出样本以免设备溢出，这些样本被丢弃并计入
+     * rx_stats::ring_full。非实时的 radio（见 #realtime()）则等待消费者释放一块。
+     */
+    void radio::run_rx_stream()
+    {
+        std::vector<std::complex<double> > discard(m_rx_ring->block_samples());
+        bool has_time;
+        double time;
+
+        while(m_rx_running)
+        {
+            std::complex<double> * block = m_rx_ring->write_block();
+            if(block == nullptr && !realtime())
+            {
+                usleep(50);
+                continue;
+            }
+            if(block == nullptr)
+            {
+                int got = receive(discard.size(), discard.data(), has_time, time);
+                m_rx_samples += got;
+                m_rx_ring->skip_samples(got);
+                m_ring_full++;
+                continue;
+            }
+
+            int got = receive(m_rx_ring->block_samples(), block, has_time, time);
+            m_rx_samples += got;
+            if(got > 0) m_rx_ring->commit(got, has_time, time);
+        }
+    }
+
+    rx_stats radio::get_rx_stats() const
+    {
+        rx_stats stats;
+        stats.overflows = m_overflows;
+        stats.timeouts = m_timeouts;
+        stats.late_packets = m_late_packets;
+        stats.other_errors = m_other_errors;
+        stats.ring_full = m_ring_full;
+        stats.samples = m_rx_samples;
+        stats.short_blocks = 0;
+        stats.discontinuities = 0;
+        return stats;
+    }
+}
@@ -0,0 +1,130 @@
+/*! \file receiver.cpp
+ *  \brief C++ file for the receiver class.
+ *
+ *  The receiver class is the public interface for the fun_ofdm receive chain.
+ *  This is the easiest way to start receiving 802.11a OFDM frames out of the box.
+ */
+
+#include "receiver.h"
+
+#define RX_BLOCK_SAMPLES 4096   //!< Samples per rx_ring block handed to the receiver_chain
+#define RX_RING_BLOCKS 512      //!< Blocks in the rx_ring, about 0.4 s at 5 MHz
+
+namespace fun {
+
+    /*!
+     *  This constructor shows exactly what parameters need to be set for the receiver
+     */
+    receiver::receiver(void(*callback)(std::vector<std::vector<unsigned char> > packets),
+                       double freq, double samp_rate, double rx_gain, std::string device_addr) :
+        receiver(callback, usrp_params(freq, samp_rate, 20, rx_gain, 1.0, device_addr))
+    {
+    }
+
+    /*!
+     *  This constructor is for those who feel more comfortable using the usrp_params struct.
+     */
+    receiver::receiver(void(*callback)(std::vector<std::vector<unsigned char> > packets), usrp_params params) :
+        receiver(callback, std::make_shared<usrp>(params))
+    {
+    }
+
+    /*!
+     *  This constructor receives from a radio that was created elsewhere.
+     *  It starts the radio's RX stream and the thread that consumes it.
+     */
+    receiver::receiver(void(*callback)(std::vector<std::vector<unsigned char> > packets), std::shared_ptr<radio> radio) :
+        m_callback(callback),
+        m_radio(radio),
+        m_rec_chain(),
+        m_running(true),
+        m_paused(false),
+        m_next_sample(0),
+        m_short_blocks(0),
+        m_discontinuities(0)
+    {
+        m_radio->start_rx_stream(RX_BLOCK_SAMPLES, RX_RING_BLOCKS);
+        m_rec_thread = std::thread(&receiver::receiver_chain_loop, this);
+    }
+
+    receiver::~receiver()
+    {
+        m_running = false;
+        if(m_rec_thread.joinable()) m_rec_thread.join();
+        m_radio->stop_rx_stream();
+    }
+
+    /*!
+     *  The blocks are decoded straight out of the rx_ring. While paused the blocks are still
+     *  released so that the ring does not fill up and the RX thread keeps draining the USRP.
+     *  Whenever a block does not start where the last decoded one ended (blocks dropped here,
+     *  while paused or because the ring was full) the receiver_chain is reset first, so that
+     *  no frame is stitched together from the samples on both sides of the gap.
+     */
+    void receiver::receiver_chain_loop()
+    {
+        rx_ring * ring = m_radio->get_rx_ring();
+        rx_view view;
+
+        while(m_running)
+        {
+            if(!ring->acquire(view, 100)) continue;
+
+            // The receiver_chain needs more than CARRYOVER_LENGTH samples per call, shorter
+            // blocks only happen when the radio timed out or overflowed part way through
+            if(!m_paused && view.count <= CARRYOVER_LENGTH) m_short_blocks++;
+            if(m_paused || view.count <= CARRYOVER_LENGTH)
+            {
+                ring->release();
+                continue;
+            }
+
+            if(view.first_sample != m_next_sample)
+            {
+                m_rec_chain.reset(view.first_sample - m_next_sample);
+                m_discontinuities++;
+            }
+            m_next_sample = view.first_sample + view.count;
+
+            std::vector<rx_frame> frames = m_rec_chain.process_frames(view.samples, view.count);
+            ring->release();
+
+            {
+                std::lock_guard<std::mutex> lock(m_frame_callback_mutex);
+                if(m_frame_callback && !frames.empty()) m_frame_callback(frames);
+            }
+
+            std::vector<std::vector<unsigned char> > packets;
+            for(int x = 0; x < frames.size(); x++)
+            {
+                if(frames[x].crc_ok) packets.push_back(std::move(frames[x].payload));
+            }
+            m_callback(packets);
+        }
+    }
+
+    rx_stats receiver::get_rx_stats() const
+    {
+        rx_stats stats = m_radio->get_rx_stats();
+        stats.short_blocks = m_short_blocks;
+        stats.discontinuities = m_discontinuities;
+        return stats;
+    }
+
+    void receiver::set_frame_callback(std::function<void(const std::vector<rx_frame> & frames)> callback)
+    {
+        std::lock_guard<std::mutex> lock(m_frame_callback_mutex);
+        m_frame_callback = callback;
+    }
+
+    void receiver::pause()
+    {
+        m_paused = true;
+    }
+
+    void receiver::resume()
+    {
+        m_paused = false;
+    }
+
+}
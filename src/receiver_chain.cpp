@@ -23,14 +23,18 @@ namespace fun
      *
      *  Adds each block to the receiver chain.
      */
-    receiver_chain::receiver_chain()
+    receiver_chain::receiver_chain() :
+        m_frame_table(FRAME_TABLE_SIZE),
+        m_stop(false),
+        m_reset_timing(false),
+        m_reset_skipped(0)
     {
-        m_frame_detector = new frame_detector();
-        m_timing_sync = new timing_sync();
+        m_frame_detector = new frame_detector(m_frame_table.data());
+        m_timing_sync = new timing_sync(m_frame_table.data());
         m_fft_symbols = new fft_symbols();
-        m_channel_est = new channel_est();
+        m_channel_est = new channel_est(m_frame_table.data());
         m_phase_tracker = new phase_tracker();
-        m_frame_decoder = new frame_decoder();
+        m_frame_decoder = new frame_decoder(m_frame_table.data());
 
         // We use semaphore references, so we don't
         // want them to move to a different memory location
@@ -47,6 +51,28 @@ namespace fun
         add_block(m_frame_decoder);
     }
 
+    /*!
+     * 唤醒每个模块的线程并让它们退出，然后释放模块。
+     */
+    receiver_chain::~receiver_chain()
+    {
+        m_stop = true;
+        for(int x = 0; x < m_wake_sems.size(); x++) sem_post(&m_wake_sems[x]);
+        for(int x = 0; x < m_threads.size(); x++) m_threads[x].join();
+        for(int x = 0; x < m_wake_sems.size(); x++)
+        {
+            sem_destroy(&m_wake_sems[x]);
+            sem_destroy(&m_done_sems[x]);
+        }
+
+        delete m_frame_detector;
+        delete m_timing_sync;
+        delete m_fft_symbols;
+        delete m_channel_est;
+        delete m_phase_tracker;
+        delete m_frame_decoder;
+    }
+
     /*!
      add_block 函数为每个模块创建一个唤醒和完成信号量。
 然后，它为模块创建一个新的线程，并将该线程添加到线程向量中以供引用。
@@ -69,6 +95,7 @@ namespace fun
         while(1)
         {
             sem_wait(&m_wake_sems[index]);
+            if(m_stop) return;
 
             boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
             block->work();
@@ -87,10 +114,59 @@ namespace fun
      该函数是接收链的主要调度器。它从 USRP 模块接收原始复数样本，并首先将它们传递到帧检测器模块的输入缓冲区。然后，它通过向每个模块的“唤醒”信号量发送信号来解锁每个线程。接着，它等待每个线程发出信号，表示它已完成对其 work() 函数的调用。一旦所有线程完成，它会将每个模块的输出缓冲区内容移到链中下一个模块的输入缓冲区，并返回帧解码器的输出缓冲区内容。
      */
     std::vector<std::vector<unsigned char> > receiver_chain::process_samples(std::vector<std::complex<double> > samples)
+    {
+        std::vector<rx_frame> frames = process_frames(samples);
+        return payloads(frames);
+    }
+
+    /*!
+     * 与上面的版本相同，但帧检测器直接读取调用者的缓冲区（例如 rx_ring 的一块），不做拷贝。
+     * 缓冲区只需要在函数返回前保持有效：帧检测器是第一个模块，之后的模块只读取它的输出。
+     */
+    std::vector<std::vector<unsigned char> > receiver_chain::process_samples(const std::complex<double> * samples, int count)
+    {
+        std::vector<rx_frame> frames = process_frames(samples, count);
+        return payloads(frames);
+    }
+
+    std::vector<rx_frame> receiver_chain::process_frames(std::vector<std::complex<double> > samples)
     {
         // samples -> sync short in
         m_frame_detector->input_buffer.swap(samples);
+        return run_chain();
+    }
 
+    std::vector<rx_frame> receiver_chain::process_frames(const std::complex<double> * samples, int count)
+    {
+        m_frame_detector->input_buffer.clear();
+        m_frame_detector->set_input(samples, count);
+        return run_chain();
+    }
+
+    /*!
+     * 帧检测器在下一块样本上运行，所以马上重置。定时同步比帧检测器晚一块运行，下一次
+     * run_chain() 处理的还是缺口之前的样本，所以等那一次结束后才重置（见 #run_chain()）。
+     * 调用时各模块的线程都在等待，不需要加锁。
+     */
+    void receiver_chain::reset(unsigned long long skipped)
+    {
+        m_frame_detector->reset();
+        m_reset_timing = true;
+        m_reset_skipped += skipped;
+    }
+
+    std::vector<std::vector<unsigned char> > receiver_chain::payloads(std::vector<rx_frame> & frames)
+    {
+        std::vector<std::vector<unsigned char> > payloads;
+        for(int x = 0; x < frames.size(); x++)
+        {
+            if(frames[x].crc_ok) payloads.push_back(std::move(frames[x].payload));
+        }
+        return payloads;
+    }
+
+    std::vector<rx_frame> receiver_chain::run_chain()
+    {
         // Unlock the threads
         for(int x = 0; x < m_wake_sems.size(); x++) sem_post(&m_wake_sems[x]);
 
@@ -104,6 +180,14 @@ namespace fun
         m_phase_tracker->input_buffer.swap(m_channel_est->output_buffer);
         m_frame_decoder->input_buffer.swap(m_phase_tracker->output_buffer);
 
+        // The timing_sync gets the samples after the gap next time
+        if(m_reset_timing)
+        {
+            m_timing_sync->reset(m_reset_skipped);
+            m_reset_timing = false;
+            m_reset_skipped = 0;
+        }
+
         // Return any completed packets
         return m_frame_decoder->output_buffer;
     }
@@ -0,0 +1,119 @@
+/*! \file rx_ring.cpp
+ *  \brief C++ file for the rx_ring class.
+ *
+ *  The rx_ring class is a single producer, single consumer ring of received sample blocks.
+ */
+
+#include <cstring>
+#include <ctime>
+#include <sys/mman.h>
+
+#include "rx_ring.h"
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024) //!< Size of an x86-64 huge page
+
+namespace fun
+{
+    /*!
+     * - Initializations:
+     *   + #m_samples -> num_blocks * block_samples samples, rounded up to whole huge pages
+     *   + #m_write, #m_read -> 0
+     *
+     *  Explicit huge pages (MAP_HUGETLB) are tried first. If none are reserved on the system the
+     *  ring falls back to normal pages and asks for transparent huge pages instead. Either way the
+     *  pages are populated up front and touched once.
+     */
+    rx_ring::rx_ring(int block_samples, int num_blocks) :
+        m_block_samples(block_samples),
+        m_num_blocks(num_blocks),
+        m_info(num_blocks),
+        m_total_samples(0),
+        m_write(0),
+        m_read(0)
+    {
+        size_t bytes = size_t(block_samples) * num_blocks * sizeof(std::complex<double>);
+        m_bytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+        void * memory = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        m_huge_pages = memory != MAP_FAILED;
+        if(!m_huge_pages)
+        {
+            memory = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+            if(memory != MAP_FAILED) madvise(memory, m_bytes, MADV_HUGEPAGE);
+        }
+
+        if(memory == MAP_FAILED)
+        {
+            m_samples = new std::complex<double>[size_t(block_samples) * num_blocks];
+            m_bytes = 0;
+        }
+        else
+        {
+            m_samples = static_cast<std::complex<double> *>(memory);
+            mlock(memory, m_bytes); // Best effort, needs CAP_IPC_LOCK or a high enough RLIMIT_MEMLOCK
+        }
+
+        // Pre-fault
+        memset((void *)m_samples, 0, bytes);
+
+        sem_init(&m_available, 0, 0);
+    }
+
+    rx_ring::~rx_ring()
+    {
+        if(m_bytes == 0) delete[] m_samples;
+        else munmap(m_samples, m_bytes);
+        sem_destroy(&m_available);
+    }
+
+    std::complex<double> * rx_ring::write_block()
+    {
+        unsigned long long write = m_write.load(std::memory_order_relaxed);
+        if(write - m_read.load(std::memory_order_acquire) >= (unsigned long long)m_num_blocks) return nullptr;
+        return m_samples + (write % m_num_blocks) * m_block_samples;
+    }
+
+    void rx_ring::commit(int count, bool has_time, double time)
+    {
+        unsigned long long write = m_write.load(std::memory_order_relaxed);
+        block_info & info = m_info[write % m_num_blocks];
+        info.count = count;
+        info.first_sample = m_total_samples;
+        info.has_time = has_time;
+        info.time = time;
+        m_total_samples += count;
+
+        m_write.store(write + 1, std::memory_order_release);
+        sem_post(&m_available);
+    }
+
+    bool rx_ring::acquire(rx_view & view, int timeout_ms)
+    {
+        timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += timeout_ms / 1000;
+        timeout.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if(timeout.tv_nsec >= 1000000000L)
+        {
+            timeout.tv_sec++;
+            timeout.tv_nsec -= 1000000000L;
+        }
+        if(sem_timedwait(&m_available, &timeout) != 0) return false;
+
+        unsigned long long read = m_read.load(std::memory_order_relaxed);
+        const block_info & info = m_info[read % m_num_blocks];
+        view.samples = m_samples + (read % m_num_blocks) * m_block_samples;
+        view.count = info.count;
+        view.first_sample = info.first_sample;
+        view.has_time = info.has_time;
+        view.time = info.time;
+        return true;
+    }
+
+    void rx_ring::release()
+    {
+        m_read.store(m_read.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+}
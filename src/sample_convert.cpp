@@ -0,0 +1,165 @@
+/*! \file sample_convert.cpp
+ *  \brief C++ file for the sample_convert class.
+ *
+ *  The sample_convert class converts between the complex doubles used by the PHY and
+ *  the compact host sample formats handed to UHD.
+ */
+
+#include <cmath>
+#include <immintrin.h>
+
+#include "sample_convert.h"
+
+namespace fun
+{
+    namespace
+    {
+        /*!
+         * \brief 4 samples (8 doubles) per iteration.
+         * \return The number of samples converted. The caller converts the remainder.
+         */
+        __attribute__((target("avx2")))
+        int to_fc32_avx2(const double * in, int count, double scale, float * out)
+        {
+            __m256d s = _mm256_set1_pd(scale);
+            int x = 0;
+            for(; x + 4 <= count; x += 4)
+            {
+                __m128 a = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_loadu_pd(in + 2 * x), s));
+                __m128 b = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_loadu_pd(in + 2 * x + 4), s));
+                _mm256_storeu_ps(out + 2 * x, _mm256_set_m128(b, a));
+            }
+            return x;
+        }
+
+        /*!
+         * \brief 8 samples (16 doubles) per iteration. The clamp happens in double precision
+         *  because out of range conversions to int32 do not saturate.
+         */
+        __attribute__((target("avx2")))
+        int to_sc16_avx2(const double * in, int count, double scale, short * out)
+        {
+            __m256d s = _mm256_set1_pd(scale * SC16_SCALE);
+            __m256d hi = _mm256_set1_pd(SC16_SCALE);
+            __m256d lo = _mm256_set1_pd(-SC16_SCALE - 1);
+            int x = 0;
+            for(; x + 8 <= count; x += 8)
+            {
+                __m128i v[4];
+                for(int k = 0; k < 4; k++)
+                {
+                    __m256d d = _mm256_mul_pd(_mm256_loadu_pd(in + 2 * x + 4 * k), s);
+                    d = _mm256_min_pd(_mm256_max_pd(d, lo), hi);
+                    v[k] = _mm256_cvtpd_epi32(d);
+                }
+                __m256i a = _mm256_set_m128i(v[2], v[0]);
+                __m256i b = _mm256_set_m128i(v[3], v[1]);
+                // packs works per 128 bit lane: lane 0 gets v[0], v[1]; lane 1 gets v[2], v[3]
+                _mm256_storeu_si256((__m256i *)(out + 2 * x), _mm256_packs_epi32(a, b));
+            }
+            return x;
+        }
+
+        __attribute__((target("avx2")))
+        int scale_fc64_avx2(const double * in, int count, double scale, double * out)
+        {
+            __m256d s = _mm256_set1_pd(scale);
+            int x = 0;
+            for(; x + 2 <= count; x += 2)
+                _mm256_storeu_pd(out + 2 * x, _mm256_mul_pd(_mm256_loadu_pd(in + 2 * x), s));
+            return x;
+        }
+
+        __attribute__((target("avx2")))
+        int from_fc32_avx2(const float * in, int count, double * out)
+        {
+            int x = 0;
+            for(; x + 4 <= count; x += 4)
+            {
+                __m256 f = _mm256_loadu_ps(in + 2 * x);
+                _mm256_storeu_pd(out + 2 * x, _mm256_cvtps_pd(_mm256_castps256_ps128(f)));
+                _mm256_storeu_pd(out + 2 * x + 4, _mm256_cvtps_pd(_mm256_extractf128_ps(f, 1)));
+            }
+            return x;
+        }
+
+        __attribute__((target("avx2")))
+        int from_sc16_avx2(const short * in, int count, double * out)
+        {
+            __m256d s = _mm256_set1_pd(1.0 / SC16_SCALE);
+            int x = 0;
+            for(; x + 4 <= count; x += 4)
+            {
+                __m256i i = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(in + 2 * x)));
+                _mm256_storeu_pd(out + 2 * x, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(i)), s));
+                _mm256_storeu_pd(out + 2 * x + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(i, 1)), s));
+            }
+            return x;
+        }
+
+        short to_short(double value)
+        {
+            value = std::nearbyint(value);
+            if(value > SC16_SCALE) return SC16_SCALE;
+            if(value < -SC16_SCALE - 1) return -SC16_SCALE - 1;
+            return value;
+        }
+    }
+
+    bool sample_convert::simd_supported()
+    {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+
+    void sample_convert::to_fc32(const std::complex<double> * in, int count, double scale, std::complex<float> * out)
+    {
+        int x = simd_supported() ? to_fc32_avx2((const double *)in, count, scale, (float *)out) : 0;
+        for(; x < count; x++) out[x] = std::complex<float>(in[x] * scale);
+    }
+
+    void sample_convert::to_sc16(const std::complex<double> * in, int count, double scale, std::complex<short> * out)
+    {
+        int x = simd_supported() ? to_sc16_avx2((const double *)in, count, scale, (short *)out) : 0;
+        scale *= SC16_SCALE;
+        for(; x < count; x++) out[x] = std::complex<short>(to_short(in[x].real() * scale), to_short(in[x].imag() * scale));
+    }
+
+    void sample_convert::scale_fc64(const std::complex<double> * in, int count, double scale, std::complex<double> * out)
+    {
+        int x = simd_supported() ? scale_fc64_avx2((const double *)in, count, scale, (double *)out) : 0;
+        for(; x < count; x++) out[x] = in[x] * scale;
+    }
+
+    void sample_convert::from_fc32(const std::complex<float> * in, int count, std::complex<double> * out)
+    {
+        int x = simd_supported() ? from_fc32_avx2((const float *)in, count, (double *)out) : 0;
+        for(; x < count; x++) out[x] = std::complex<double>(in[x]);
+    }
+
+    void sample_convert::from_sc16(const std::complex<short> * in, int count, std::complex<double> * out)
+    {
+        int x = simd_supported() ? from_sc16_avx2((const short *)in, count, (double *)out) : 0;
+        for(; x < count; x++) out[x] = std::complex<double>(in[x].real() / SC16_SCALE, in[x].imag() / SC16_SCALE);
+    }
+
+    int sample_convert::sample_size(sample_format format)
+    {
+        switch(format)
+        {
+            case FORMAT_FC32: return sizeof(std::complex<float>);
+            case FORMAT_SC16: return sizeof(std::complex<short>);
+            default: return sizeof(std::complex<double>);
+        }
+    }
+
+    const char * sample_convert::uhd_name(sample_format format)
+    {
+        switch(format)
+        {
+            case FORMAT_FC32: return "fc32";
+            case FORMAT_SC16: return "sc16";
+            default: return "fc64";
+        }
+    }
+}
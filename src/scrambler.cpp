@@ -0,0 +1,97 @@
+/*! \file scrambler.cpp
+ *  \brief C++ file for the scrambler class.
+ *
+ *  The scrambler class implements the 802.11a data scrambler (section 17.3.5.4 of the
+ *  802.11a-1999 standard) with the generator polynomial x^7 + x^4 + 1.
+ */
+
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+#include "scrambler.h"
+
+namespace fun
+{
+    /*!
+     *  Runs the LFSR for 8 periods (1016 bits = 127 bytes) so the byte pattern repeats exactly.
+     *  The state holds x1 in bit 0 through x7 in bit 6; each step outputs x7 ^ x4 and shifts
+     *  it in as the new x1.
+     */
+    scrambler::scrambler(int seed) :
+        m_seed(seed & 0x7F)
+    {
+        int state = m_seed;
+        for(int x = 0; x < SCRAMBLER_PERIOD; x++)
+        {
+            unsigned char byte = 0;
+            for(int b = 0; b < 8; b++)
+            {
+                int feedback = ((state >> 6) ^ (state >> 3)) & 1;
+                state = ((state << 1) & 0x7E) | feedback;
+                byte = (byte << 1) | feedback;
+            }
+            m_pattern[x] = byte;
+        }
+        memcpy(&m_pattern[SCRAMBLER_PERIOD], &m_pattern[0], 8);
+    }
+
+    /*!
+     *  All 127 non-zero seeds are built on first use (about 17 KB).
+     */
+    const scrambler & scrambler::get(int seed)
+    {
+        static const std::vector<scrambler> scramblers = []()
+        {
+            std::vector<scrambler> s;
+            s.reserve(128);
+            for(int x = 0; x < 128; x++) s.push_back(scrambler(x));
+            return s;
+        }();
+        return scramblers[seed & 0x7F];
+    }
+
+    /*!
+     *  The SERVICE field starts with 7 zero bits, so the first 7 scrambled bits are the first 7
+     *  outputs of the LFSR, which is also its state after 7 steps. Stepping the LFSR backwards
+     *  7 times from there gives the seed.
+     */
+    int scrambler::recover_seed(unsigned char first_byte)
+    {
+        int state = 0;
+        for(int b = 0; b < 7; b++) state |= ((first_byte >> (7 - b)) & 1) << (6 - b);
+
+        for(int x = 0; x < 7; x++)
+        {
+            int x7 = (state ^ (state >> 4)) & 1; // x7 = x1' ^ x4 and x4 = x5'
+            state = (state >> 1) | (x7 << 6);
+        }
+        return state;
+    }
+
+    /*!
+     *  XORs 8 bytes at a time with the pattern. The pattern position advances by 8 bytes each
+     *  step and wraps modulo the 127 byte period.
+     */
+    void scrambler::apply(unsigned char * data, int num_bytes) const
+    {
+        int pos = 0;
+        int x = 0;
+        for(; x + 8 <= num_bytes; x += 8)
+        {
+            uint64_t word, pattern;
+            memcpy(&word, &data[x], 8);
+            memcpy(&pattern, &m_pattern[pos], 8);
+            word ^= pattern;
+            memcpy(&data[x], &word, 8);
+
+            pos += 8;
+            if(pos >= SCRAMBLER_PERIOD) pos -= SCRAMBLER_PERIOD;
+        }
+
+        for(; x < num_bytes; x++)
+        {
+            data[x] ^= m_pattern[pos++];
+        }
+    }
+}
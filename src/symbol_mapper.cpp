@@ -118,6 +118,31 @@ namespace fun
         return samples;
     }
 
+    /*!
+     *  Same mapping as #map() but subcarrier s of the active map is written to index (s + 32) % 64
+     *  so that the output can go to the IFFT without the fft_map shuffle, and the pilots are scaled
+     *  by pilot_scale. Writes straight to the caller's buffer.
+     */
+    void symbol_mapper::map_fft_order(const std::complex<double> * data_samples, int num_symbols, double pilot_scale, std::complex<double> * samples)
+    {
+        for(int x = 0; x < num_symbols; x++)
+        {
+            double pilot = POLARITY[x % 127] * pilot_scale;
+            int pilot_index = 0;
+            for(int s = 0; s < 64; s++)
+            {
+                std::complex<double> & out = samples[(s + 32) & 63];
+                switch(m_active_map[s])
+                {
+                    case 0: out = 0; break;
+                    case 1: out = *data_samples++; break;
+                    case 2: out = PILOTS[pilot_index++] * pilot; break;
+                }
+            }
+            samples += 64;
+        }
+    }
+
     // Remove pilots and null subcarriers, leaving only data subcarriers
     /*!
      *  Takes in a vector of samples and extracts the 48 data subcarriers while throwing away the nulls
@@ -22,12 +22,15 @@ namespace fun
      *   + #m_phase_acc -> 0.0
      *   + #m_phase_offset -> 0.0
      *   + #m_carryover -> 160 blank tagged samples
+     *   + #m_sample_count -> 0
      */
-    timing_sync::timing_sync() :
+    timing_sync::timing_sync(frame_measurements * frame_table) :
         block("timing_sync"),
         m_phase_acc(0),
         m_phase_offset(0),
-        m_carryover(CARRYOVER_LENGTH, tagged_sample())
+        m_carryover(CARRYOVER_LENGTH, tagged_sample()),
+        m_frame_table(frame_table),
+        m_sample_count(0)
     {}
 
     int lts_count = 0;
@@ -104,14 +107,25 @@ namespace fun
 
                             input[lts_offset+24].tag = LTS1; // First sample in the LTS
                             input[lts_offset+24+64].tag = LTS2; // First sample in the LTS
+                            input[lts_offset+24].frame_id = input[x].frame_id;
+                            input[lts_offset+24+64].frame_id = input[x].frame_id;
 
+                            // The two LTS symbols are identical, so any rotation between them is the CFO
                             std::complex<double> auto_corr_acc(0.0, 0.0);
-                            for(int k = LTS1; k < LTS1; k++)
+                            for(int k = lts_offset + 32; k < lts_offset + 32 + LTS_LENGTH; k++)
                             {
                                 auto_corr_acc += input[k].sample * std::conj(input[k+LTS_LENGTH].sample);
                             }
 
                             m_phase_offset = std::arg(auto_corr_acc) / 64.0;
+
+                            if(m_frame_table)
+                            {
+                                frame_measurements & frame = m_frame_table[input[x].frame_id % FRAME_TABLE_SIZE];
+                                frame.cfo = -m_phase_offset / (2 * M_PI);
+                                long long start = (long long)m_sample_count - CARRYOVER_LENGTH + lts_offset - 160 /* STS */;
+                                frame.start_sample = std::max(start, 0LL);
+                            }
                             m_phase_acc = std::arg(input[lts_offset + 32 + LTS_LENGTH*2 -1].sample * LTS_TIME_DOMAIN_CONJ[63]);
                         }
                     }
@@ -136,6 +150,20 @@ namespace fun
                &input[input_buffer.size()],
                CARRYOVER_LENGTH * sizeof(tagged_sample));
 
+        m_sample_count += input_buffer.size();
+
+    }
+
+    void timing_sync::reset(unsigned long long skipped)
+    {
+        for(int x = 0; x < m_carryover.size(); x++)
+        {
+            m_carryover[x].sample = 0;
+            m_carryover[x].tag = NONE;
+        }
+        m_phase_acc = 0;
+        m_phase_offset = 0;
+        m_sample_count += skipped;
     }
 
 
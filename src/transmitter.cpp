@@ -5,7 +5,13 @@
  *  This is the easiest way to start transmitting 802.11a OFDM frames out of the box.
  */
 
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+
 #include "transmitter.h"
+#include "ppdu.h"
+#include "aggregator.h"
 
 namespace fun {
 
@@ -13,8 +19,14 @@ namespace fun {
      *  This constructor shows exactly what parameters need to be set for the transmitter
      */
     transmitter::transmitter(double freq, double samp_rate, double tx_gain, double tx_amp, std::string device_addr) :
-        m_usrp(usrp_params(freq, samp_rate, tx_gain, 20, tx_amp, device_addr)),
-        m_frame_builder()
+        m_radio(std::make_shared<usrp>(usrp_params(freq, samp_rate, tx_gain, 20, tx_amp, device_addr))),
+        m_frame_builder(),
+        m_queue(nullptr),
+        m_head(0),
+        m_build_next(0),
+        m_tx_next(0),
+        m_running(false),
+        m_submitters(0)
     {
     }
 
@@ -22,18 +34,423 @@ namespace fun {
      * This construct is for those who feel more comfortable using the usrp_params struct
      */
     transmitter::transmitter(usrp_params params) :
-        m_usrp(params),
-        m_frame_builder()
+        m_radio(std::make_shared<usrp>(params)),
+        m_frame_builder(),
+        m_queue(nullptr),
+        m_head(0),
+        m_build_next(0),
+        m_tx_next(0),
+        m_running(false),
+        m_submitters(0)
+    {
+    }
+
+    /*!
+     * This constructor sends through a radio that was created elsewhere
+     */
+    transmitter::transmitter(std::shared_ptr<radio> radio) :
+        m_radio(radio),
+        m_frame_builder(),
+        m_queue(nullptr),
+        m_head(0),
+        m_build_next(0),
+        m_tx_next(0),
+        m_running(false),
+        m_submitters(0)
     {
     }
 
     /*!
      *  Transmits a single frame, blocking until the frame is sent.
+     *  A payload longer than MAX_FRAME_SIZE is not sent.
      */
     void transmitter::send_frame(std::vector<unsigned char> payload, Rate phy_rate)
     {
         std::vector<std::complex<double> > samples = m_frame_builder.build_frame(payload, phy_rate);
-        m_usrp.send_burst_sync(samples);
+        if(samples.empty()) return;
+        m_radio->send_burst_sync(samples);
+    }
+
+    bool transmitter::send_frame_at(const std::vector<unsigned char> & payload, Rate phy_rate, double time)
+    {
+        std::vector<std::complex<double> > samples = m_frame_builder.build_frame(payload, phy_rate);
+        if(samples.empty()) return false;
+        return m_radio->send_burst_at(samples, time);
+    }
+
+    transmitter::~transmitter()
+    {
+        stop_async();
+    }
+
+    /*!
+     *  Allocates the slots and the frame builders up front (FFTW planning is not thread safe,
+     *  so the builders are created here rather than in their threads), then starts the threads.
+     */
+    void transmitter::start_async(int num_builders, int queue_depth, int gap_samples)
+    {
+        if(m_running) return;
+
+        int max_samples = frame_builder::frame_length(MAX_FRAME_SIZE, RATE_1_2_BPSK);
+        m_slots = std::vector<tx_slot>(queue_depth);
+        for(int x = 0; x < queue_depth; x++)
+        {
+            m_slots[x].payload.reserve(MAX_FRAME_SIZE);
+            m_slots[x].packet = nullptr;
+            m_slots[x].samples.resize(max_samples);
+            m_slots[x].num_samples = 0;
+            sem_init(&m_slots[x].ready, 0, 0);
+        }
+        m_gap.assign(gap_samples, std::complex<double>(0, 0));
+
+        sem_init(&m_free_sem, 0, queue_depth);
+        sem_init(&m_build_sem, 0, 0);
+        m_head = 0;
+        m_build_next = 0;
+        m_tx_next = 0;
+        m_stats = tx_stats();
+        m_running = true;
+
+        m_builders.clear();
+        for(int x = 0; x < num_builders; x++) m_builders.push_back(std::unique_ptr<frame_builder>(new frame_builder()));
+        for(int x = 0; x < num_builders; x++) m_builder_threads.push_back(std::thread(&transmitter::run_builder, this, m_builders[x].get()));
+        m_streamer_thread = std::thread(&transmitter::run_streamer, this);
+    }
+
+    /*!
+     *  Tracks a submit_frame() or submit_aggregate() call for stop_async(), which does not
+     *  destroy the semaphores until every call has returned.
+     */
+    struct submitter_guard
+    {
+        std::atomic<int> & m_count;
+        submitter_guard(std::atomic<int> & count) : m_count(count) { m_count++; }
+        ~submitter_guard() { m_count--; }
+    };
+
+    /*!
+     *  The pipeline is marked stopped under #m_submit_mutex, so no submitter fills a slot after
+     *  this point. Submitters still waiting for a free slot are woken up and all of them have
+     *  returned before any semaphore is destroyed. The builder threads are woken up so they can
+     *  see that the pipeline stopped. The streaming thread sends whatever is already built and
+     *  then ends the burst. Packets from the attached queue whose frames were never sent are
+     *  released afterwards, in order.
+     */
+    void transmitter::stop_async()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_submit_mutex);
+            if(!m_running) return;
+            m_running = false;
+        }
+
+        while(m_submitters > 0)
+        {
+            sem_post(&m_free_sem);
+            usleep(1000);
+        }
+
+        if(m_feeder_thread.joinable()) m_feeder_thread.join();
+        for(int x = 0; x < m_builder_threads.size(); x++) sem_post(&m_build_sem);
+        for(int x = 0; x < m_builder_threads.size(); x++) m_builder_threads[x].join();
+        m_streamer_thread.join();
+        m_builder_threads.clear();
+
+        for(unsigned long long x = m_tx_next; x < m_head; x++)
+        {
+            tx_slot & slot = m_slots[x % m_slots.size()];
+            if(slot.packet) m_queue->release();
+            slot.packet = nullptr;
+        }
+        m_queue = nullptr;
+
+        for(int x = 0; x < m_slots.size(); x++) sem_destroy(&m_slots[x].ready);
+        sem_destroy(&m_free_sem);
+        sem_destroy(&m_build_sem);
+    }
+
+    /*!
+     *  Copies the payload into the next free slot. Submitters are serialized so that slots are
+     *  filled in sequence order; the builders are only told about a slot once it is complete.
+     *  The submitter is counted before #m_running is checked, so stop_async() either sees it
+     *  or it sees that the pipeline stopped.
+     */
+    bool transmitter::submit_frame(const std::vector<unsigned char> & payload, Rate phy_rate, bool wait)
+    {
+        submitter_guard guard(m_submitters);
+        if(!m_running || payload.size() > MAX_FRAME_SIZE) return false;
+
+        if(wait)
+        {
+            if(!wait_free_slot()) return false;
+        }
+        else if(sem_trywait(&m_free_sem) != 0)
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            m_stats.frames_rejected++;
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_submit_mutex);
+            if(!m_running) return false;
+            tx_slot & slot = m_slots[m_head % m_slots.size()];
+            slot.payload.assign(payload.begin(), payload.end());
+            slot.packet = nullptr;
+            slot.rate = phy_rate;
+            slot.service = 0;
+            slot.enqueued = boost::posix_time::microsec_clock::local_time();
+            m_head++;
+            sem_post(&m_build_sem);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            m_stats.frames_submitted++;
+        }
+
+        return true;
+    }
+
+    /*!
+     *  Same as #submit_frame but the MPDUs are packed straight into the slot's payload buffer.
+     */
+    int transmitter::submit_aggregate(const std::vector<std::vector<unsigned char> > & mpdus, int first, Rate phy_rate, bool wait)
+    {
+        submitter_guard guard(m_submitters);
+        if(!m_running || first >= mpdus.size()) return 0;
+
+        if(wait)
+        {
+            if(!wait_free_slot()) return 0;
+        }
+        else if(sem_trywait(&m_free_sem) != 0)
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            m_stats.frames_rejected++;
+            return 0;
+        }
+
+        int count;
+        {
+            std::lock_guard<std::mutex> lock(m_submit_mutex);
+            if(!m_running) return 0;
+            tx_slot & slot = m_slots[m_head % m_slots.size()];
+            count = aggregator::pack(mpdus, first, slot.payload, MAX_FRAME_SIZE);
+            if(count == 0)
+            {
+                sem_post(&m_free_sem);
+                return 0;
+            }
+            slot.packet = nullptr;
+            slot.rate = phy_rate;
+            slot.service = SERVICE_AGGREGATED;
+            slot.enqueued = boost::posix_time::microsec_clock::local_time();
+            m_head++;
+            sem_post(&m_build_sem);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            m_stats.frames_submitted++;
+        }
+
+        return count;
+    }
+
+    void transmitter::attach_queue(tx_queue * queue)
+    {
+        if(!m_running || m_queue || !queue) return;
+        m_queue = queue;
+        m_feeder_thread = std::thread(&transmitter::run_feeder, this);
+    }
+
+    bool transmitter::wait_free_slot()
+    {
+        while(m_running)
+        {
+            timespec timeout;
+            clock_gettime(CLOCK_REALTIME, &timeout);
+            timeout.tv_nsec += 100000000;
+            if(timeout.tv_nsec >= 1000000000)
+            {
+                timeout.tv_sec++;
+                timeout.tv_nsec -= 1000000000;
+            }
+            if(sem_timedwait(&m_free_sem, &timeout) == 0) return true;
+        }
+        return false;
+    }
+
+    /*!
+     *  A free slot is reserved before a packet is taken from the queue, so a packet is never
+     *  acquired without a slot to put it in. The slot only records where the packet is.
+     */
+    void transmitter::run_feeder()
+    {
+        while(wait_free_slot())
+        {
+            tx_packet * packet = nullptr;
+            while(m_running && !(packet = m_queue->acquire(100)));
+            if(!packet)
+            {
+                sem_post(&m_free_sem);
+                break;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_submit_mutex);
+                tx_slot & slot = m_slots[m_head % m_slots.size()];
+                slot.packet = packet;
+                slot.rate = packet->rate;
+                slot.service = 0;
+                slot.enqueued = boost::posix_time::microsec_clock::local_time();
+                m_head++;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_stats_mutex);
+                m_stats.frames_submitted++;
+            }
+
+            sem_post(&m_build_sem);
+        }
+    }
+
+    void transmitter::flush()
+    {
+        while(m_running && m_tx_next < m_head) usleep(1000);
+    }
+
+    tx_stats transmitter::get_stats()
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        return m_stats;
+    }
+
+    /*!
+     *  Each builder builds straight into the slot's sample buffer. The transmit amplitude is
+     *  applied by the radio while it converts the samples to the host format.
+     */
+    void transmitter::run_builder(frame_builder * builder)
+    {
+        while(1)
+        {
+            sem_wait(&m_build_sem);
+            if(!m_running) break;
+
+            unsigned long long sequence;
+            {
+                std::lock_guard<std::mutex> lock(m_build_mutex);
+                sequence = m_build_next++;
+            }
+
+            tx_slot & slot = m_slots[sequence % m_slots.size()];
+            if(slot.packet)
+            {
+                const tx_packet & packet = *slot.packet;
+                slot.num_samples = builder->build_frame_into(packet.header, packet.header_length, packet.body, packet.body_length,
+                                                             slot.rate, slot.samples.data(), slot.samples.size(), slot.service);
+            }
+            else
+            {
+                slot.num_samples = builder->build_frame_into(slot.payload.data(), slot.payload.size(), slot.rate,
+                                                             slot.samples.data(), slot.samples.size(), slot.service);
+            }
+            slot.built = boost::posix_time::microsec_clock::local_time();
+            sem_post(&slot.ready);
+        }
+    }
+
+    /*!
+     *  Waits for the frames in sequence order. While the next frame is ready it is sent in the
+     *  current burst right after the previous one. When the next frame is not ready yet the burst
+     *  is ended so the radio does not underflow, and a new burst starts with the next frame.
+     */
+    void transmitter::run_streamer()
+    {
+        bool in_burst = false;
+
+        while(1)
+        {
+            tx_slot & slot = m_slots[m_tx_next % m_slots.size()];
+
+            if(sem_trywait(&slot.ready) != 0)
+            {
+                if(in_burst)
+                {
+                    m_radio->send_samples(m_gap.data(), 0, false, true);
+                    in_burst = false;
+                }
+
+                timespec timeout;
+                clock_gettime(CLOCK_REALTIME, &timeout);
+                timeout.tv_nsec += 100000000;
+                if(timeout.tv_nsec >= 1000000000)
+                {
+                    timeout.tv_sec++;
+                    timeout.tv_nsec -= 1000000000;
+                }
+                if(sem_timedwait(&slot.ready, &timeout) != 0)
+                {
+                    if(!m_running) break;
+                    continue;
+                }
+            }
+
+            bool new_burst = false;
+            if(slot.num_samples > 0)
+            {
+                new_burst = !in_burst;
+                m_radio->send_samples(slot.samples.data(), slot.num_samples, new_burst, false);
+                if(m_gap.size() > 0) m_radio->send_samples(m_gap.data(), m_gap.size(), false, false);
+                in_burst = true;
+            }
+            boost::posix_time::ptime sent = boost::posix_time::microsec_clock::local_time();
+            int underflows = m_radio->poll_underflows();
+
+            tx_frame_report report;
+            report.sequence = m_tx_next;
+            report.rate = slot.rate;
+            report.num_samples = slot.num_samples;
+            report.build_latency_us = (slot.built - slot.enqueued).total_microseconds();
+            report.air_latency_us = (sent - slot.enqueued).total_microseconds();
+            report.source_latency_us = 0;
+
+            bool from_queue = slot.packet != nullptr;
+            if(from_queue)
+            {
+                // The frame is on its way, the producer can have its buffer back
+                report.source_latency_us = tx_queue::now_us() - slot.packet->origin_us;
+                slot.packet = nullptr;
+                m_queue->release();
+            }
+
+            m_tx_next++;
+            sem_post(&m_free_sem);
+
+            {
+                std::lock_guard<std::mutex> lock(m_stats_mutex);
+                if(report.num_samples > 0)
+                {
+                    m_stats.frames_sent++;
+                    m_stats.mean_air_latency_us += (report.air_latency_us - m_stats.mean_air_latency_us) / m_stats.frames_sent;
+                    m_stats.max_air_latency_us = std::max(m_stats.max_air_latency_us, report.air_latency_us);
+                }
+                if(from_queue && report.num_samples > 0)
+                {
+                    m_stats.queue_frames++;
+                    m_stats.mean_source_latency_us += (report.source_latency_us - m_stats.mean_source_latency_us) / m_stats.queue_frames;
+                    m_stats.max_source_latency_us = std::max(m_stats.max_source_latency_us, report.source_latency_us);
+                }
+                if(new_burst) m_stats.bursts++;
+                m_stats.underflows += underflows;
+            }
+
+            if(m_report_callback) m_report_callback(report);
+        }
+
+        if(in_burst) m_radio->send_samples(m_gap.data(), 0, false, true);
     }
 
 }
@@ -0,0 +1,87 @@
+/*! \file tx_queue.cpp
+ *  \brief C++ file for the tx_queue class.
+ *
+ *  The tx_queue class is a single producer, single consumer queue of packets to transmit.
+ */
+
+#include <ctime>
+
+#include "tx_queue.h"
+
+namespace fun
+{
+    /*!
+     * - Initializations:
+     *   + #m_packets -> capacity empty slots
+     *   + #m_write, #m_read, #m_acquired -> 0
+     */
+    tx_queue::tx_queue(int capacity) :
+        m_packets(capacity < 1 ? 1 : capacity),
+        m_acquired(0),
+        m_write(0),
+        m_read(0)
+    {
+        sem_init(&m_available, 0, 0);
+    }
+
+    /*!
+     *  Both sides must have stopped using the queue by now.
+     */
+    tx_queue::~tx_queue()
+    {
+        while(m_read.load() < m_write.load()) release();
+        sem_destroy(&m_available);
+    }
+
+    int tx_queue::free_slots() const
+    {
+        return m_packets.size() - (m_write.load(std::memory_order_relaxed) - m_read.load(std::memory_order_acquire));
+    }
+
+    tx_packet * tx_queue::write_slot()
+    {
+        unsigned long long write = m_write.load(std::memory_order_relaxed);
+        if(write - m_read.load(std::memory_order_acquire) >= m_packets.size()) return nullptr;
+        return &m_packets[write % m_packets.size()];
+    }
+
+    void tx_queue::commit()
+    {
+        m_write.store(m_write.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        sem_post(&m_available);
+    }
+
+    tx_packet * tx_queue::acquire(int timeout_ms)
+    {
+        timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += timeout_ms / 1000;
+        timeout.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if(timeout.tv_nsec >= 1000000000L)
+        {
+            timeout.tv_sec++;
+            timeout.tv_nsec -= 1000000000L;
+        }
+        if(sem_timedwait(&m_available, &timeout) != 0) return nullptr;
+
+        // The acquire load pairs with the release store in commit() so the slot contents are visible
+        m_write.load(std::memory_order_acquire);
+        return &m_packets[m_acquired++ % m_packets.size()];
+    }
+
+    void tx_queue::release()
+    {
+        unsigned long long read = m_read.load(std::memory_order_relaxed);
+        tx_packet & packet = m_packets[read % m_packets.size()];
+        if(packet.release) packet.release(packet.context);
+        packet.release = nullptr;
+        m_read.store(read + 1, std::memory_order_release);
+    }
+
+    long long tx_queue::now_us()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+    }
+}
@@ -6,6 +6,8 @@ usrp 类是 UHD API 的一个包装类。它提供了一个简单的接口，用
 usrp_params 类是一个容器，用于保存 USRP 所需的参数，例如中心频率、采样率、发送/接收增益等。
  */
 
+#include <algorithm>
+
 #include "usrp.h"
 
 namespace fun
@@ -15,7 +17,11 @@ namespace fun
   * `#m_params` -> 先前初始化的 `usrp_params` 对象，包含 USRP 所需的参数。
      */
     usrp::usrp(usrp_params params) :
-        m_params(params)
+        m_params(params),
+        m_tx_buffer(USRP_CONVERT_CHUNK),
+        m_rx_buffer(USRP_CONVERT_CHUNK),
+        m_underflows(0),
+        m_late(0)
     {
         // 实例化 multi_usrp
         // m_usrp = uhd::usrp::multi_usrp::make("uhd::device_addr_t(m_params.device_addr)");
@@ -38,9 +44,12 @@ namespace fun
         // 设置接收天线
         //m_usrp->set_rx_antenna("RX2");
 
-        // 获取 TX 和 RX 流句柄
-        m_tx_streamer = m_usrp->get_tx_stream(uhd::stream_args_t("fc64"));
-        m_rx_streamer = m_usrp->get_rx_stream(uhd::stream_args_t("fc64"));
+        // 获取 TX 和 RX 流句柄（主机格式由 m_params.format 决定，转换由 sample_convert 完成）
+        m_tx_streamer = m_usrp->get_tx_stream(uhd::stream_args_t(sample_convert::uhd_name(m_params.format)));
+        m_rx_streamer = m_usrp->get_rx_stream(uhd::stream_args_t(sample_convert::uhd_name(m_params.format)));
+
+        // 设备时间从 0 开始，TX 和 RX 的时间戳都以它为准
+        m_usrp->set_time_now(uhd::time_spec_t(0.0));
 
         // 启动 RX 流
         uhd::stream_cmd_t stream_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
@@ -57,16 +66,10 @@ namespace fun
     此函数在调用后不会阻塞。由于 UHD API 的多线程特性，此函数可能会在 USRP 完成所有样本的传输之前返回。这通常是可以的，因为后续对该方法的调用会在 USRP 中缓冲更多样本。然而，如果调用速度不够快，可能会发生下溢。有关更多详细信息，请参见 [Ettus 网站的链接](http://files.ettus.com/manual/page_general.html#general_ounotes)。
     
      */
-    void usrp::send_burst(std::vector<std::complex<double> > samples)
+    void usrp::send_burst(const std::vector<std::complex<double> > & samples)
     {
         sem_wait(&m_tx_sem);
-
-        uhd::tx_metadata_t tx_metadata;
-        tx_metadata.start_of_burst = true;
-        tx_metadata.end_of_burst = true;
-        tx_metadata.has_time_spec = false;
-        m_tx_streamer->send(&samples[0], samples.size(), tx_metadata);
-
+        send_converted(samples.data(), samples.size(), true, true);
         sem_post(&m_tx_sem);
     }
 
@@ -76,19 +79,10 @@ namespace fun
 
         * 此函数使用信号量来阻塞，直到 USRP 响应确认所有样本已通过无线传输。这可以防止用户一次发送过多数据，从而使用户在传输完成时有一定的感觉。如果用户调用此函数的速度不够快，可能会发生下溢。有关更多详细信息，请参见 [Ettus 网站的链接](http://files.ettus.com/manual/page_general.html#general_ounotes)。
      */
-    void usrp::send_burst_sync(std::vector<std::complex<double> > samples)
+    void usrp::send_burst_sync(const std::vector<std::complex<double> > & samples)
     {
-        // 将样本按 `m_amp` 进行缩放。
-        if(m_params.tx_amp != 1.0)
-            for(int x = 0; x < samples.size(); x++)
-                samples[x] *= m_params.tx_amp;
-
-        // 发送样本。
-        uhd::tx_metadata_t tx_metadata;
-        tx_metadata.start_of_burst = true;
-        tx_metadata.end_of_burst = true;
-        tx_metadata.has_time_spec = false;
-        m_tx_streamer->send(&samples[0], samples.size(), tx_metadata);
+        // 将样本按 `tx_amp` 缩放并发送（缩放与格式转换在同一遍中完成）。
+        send_converted(samples.data(), samples.size(), true, true);
 
         // 等待突发结束确认（ACK）随后发生的下溢。
         bool got_ack = false;
@@ -102,14 +96,160 @@ namespace fun
     }
 
     /*!
-     从 USRP 获取 num_samples 并将其放入缓冲区参数中。如果此函数调用得“不够快”，USRP 会感到不满，因为计算机没有足够快地消费样本，无法跟上 USRP 的接收采样率。这将导致 USRP 指示溢出，从而无法保证检索数据的完整性。有关更多详细信息，请参见 Ettus 网站的链接。 *
+     * 与 #send_burst 不同，这里由调用者决定脉冲串的边界，因此多个帧可以在一个脉冲串里
+     * 背靠背发送。
+     */
+    void usrp::send_samples(const std::complex<double> * samples, int num_samples, bool start_of_burst, bool end_of_burst)
+    {
+        send_converted(samples, num_samples, start_of_burst, end_of_burst);
+    }
+
+    /*!
+     * 每次转换 #USRP_CONVERT_CHUNK 个样本到 #m_tx_buffer 并交给 UHD，因此转换后的数据
+     * 还在缓存中时就被发送，也不需要分配内存。fc64 且不需要缩放时直接发送原始样本。
+     */
+    void usrp::send_converted(const std::complex<double> * samples, int num_samples, bool start_of_burst, bool end_of_burst,
+                              const uhd::time_spec_t * time)
+    {
+        double scale = m_params.tx_amp;
+        uhd::tx_metadata_t tx_metadata;
+        tx_metadata.has_time_spec = time != nullptr;
+        if(time) tx_metadata.time_spec = *time;
+
+        int sent = 0;
+        do
+        {
+            int count = std::min(num_samples - sent, USRP_CONVERT_CHUNK);
+            const void * buffer = m_tx_buffer.data();
+            switch(m_params.format)
+            {
+                case FORMAT_FC32:
+                    sample_convert::to_fc32(samples + sent, count, scale, (std::complex<float> *)m_tx_buffer.data());
+                    break;
+                case FORMAT_SC16:
+                    sample_convert::to_sc16(samples + sent, count, scale, (std::complex<short> *)m_tx_buffer.data());
+                    break;
+                default:
+                    if(scale == 1.0) buffer = samples + sent;
+                    else sample_convert::scale_fc64(samples + sent, count, scale, m_tx_buffer.data());
+                    break;
+            }
+
+            tx_metadata.start_of_burst = start_of_burst && sent == 0;
+            tx_metadata.end_of_burst = end_of_burst && sent + count == num_samples;
+            m_tx_streamer->send(buffer, count, tx_metadata);
+            tx_metadata.has_time_spec = false;
+            sent += count;
+        }
+        while(sent < num_samples);
+    }
+
+    /*!
+     * 只有第一块带有时间戳，后面的块紧接着发送。UHD 会缓冲样本直到设备时间到达 time，
+     * 因此这里会在发送之前返回。
+     */
+    bool usrp::send_burst_at(const std::vector<std::complex<double> > & samples, uhd::time_spec_t time)
+    {
+        send_converted(samples.data(), samples.size(), true, true, &time);
+        return true;
+    }
+
+    bool usrp::send_burst_at(const std::vector<std::complex<double> > & samples, double time)
+    {
+        return send_burst_at(samples, uhd::time_spec_t(time));
+    }
+
+    /*!
+     * 超时为 0，所以只读取已经到达的消息。
+     */
+    void usrp::poll_async()
+    {
+        uhd::async_metadata_t async_metadata;
+        while(m_device->recv_async_msg(async_metadata, 0))
+        {
+            if(async_metadata.event_code == uhd::async_metadata_t::EVENT_CODE_UNDERFLOW ||
+               async_metadata.event_code == uhd::async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET)
+                m_underflows++;
+            else if(async_metadata.event_code == uhd::async_metadata_t::EVENT_CODE_TIME_ERROR)
+                m_late++;
+        }
+    }
+
+    int usrp::poll_underflows()
+    {
+        poll_async();
+        return m_underflows.exchange(0);
+    }
+
+    int usrp::poll_late_bursts()
+    {
+        poll_async();
+        return m_late.exchange(0);
+    }
+
+    usrp::~usrp()
+    {
+        stop_rx_stream();
+    }
+
+    /*!
+     从 USRP 获取样本。如果此函数调用得“不够快”，USRP 会感到不满，因为计算机没有足够快地消费样本，无法跟上 USRP 的接收采样率。这将导致 USRP 指示溢出，从而无法保证检索数据的完整性。有关更多详细信息，请参见 Ettus 网站的链接。
+
+     * fc64 直接接收到 buffer；其他格式每次接收 #USRP_CONVERT_CHUNK 个样本到 #m_rx_buffer，
+     * 趁数据还在缓存中时转换。每次 recv 的错误码都计入 rx_stats，遇到超时或溢出时提前返回。
      */
-    void usrp::get_samples(int num_samples, std::vector<std::complex<double> > & buffer)
+    int usrp::receive(int num_samples, std::complex<double> * buffer, bool & has_time, double & time)
     {
-        // Get some samples
         uhd::rx_metadata_t rx_meta;
-        m_rx_streamer->recv(&buffer[0], num_samples, rx_meta);
+        has_time = false;
+        time = 0;
+
+        int received = 0;
+        while(received < num_samples)
+        {
+            int got;
+            if(m_params.format == FORMAT_FC64)
+            {
+                got = m_rx_streamer->recv(buffer + received, num_samples - received, rx_meta);
+            }
+            else
+            {
+                int count = std::min(num_samples - received, USRP_CONVERT_CHUNK);
+                got = m_rx_streamer->recv(m_rx_buffer.data(), count, rx_meta);
+                if(m_params.format == FORMAT_FC32)
+                    sample_convert::from_fc32((const std::complex<float> *)m_rx_buffer.data(), got, buffer + received);
+                else
+                    sample_convert::from_sc16((const std::complex<short> *)m_rx_buffer.data(), got, buffer + received);
+            }
+
+            if(received == 0 && got > 0 && rx_meta.has_time_spec)
+            {
+                has_time = true;
+                time = rx_meta.time_spec.get_real_secs();
+            }
+            received += got;
+
+            switch(rx_meta.error_code)
+            {
+                case uhd::rx_metadata_t::ERROR_CODE_NONE:
+                    break;
+                case uhd::rx_metadata_t::ERROR_CODE_TIMEOUT:
+                    m_timeouts++;
+                    break;
+                case uhd::rx_metadata_t::ERROR_CODE_OVERFLOW:
+                    m_overflows++;
+                    break;
+                case uhd::rx_metadata_t::ERROR_CODE_LATE_COMMAND:
+                    m_late_packets++;
+                    break;
+                default:
+                    m_other_errors++;
+                    break;
+            }
+            if(rx_meta.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE || got == 0) break;
+        }
+
+        return received;
     }
 
 }
-
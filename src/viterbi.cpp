@@ -31,7 +31,18 @@ namespace fun
     {
       struct v * vp = viterbi_alloc(data_bits);
       viterbi_init(vp, 0);
-      viterbi_decode(vp, &symbols[0], &data[0], data_bits);
+      viterbi_decode(vp, &symbols[0], &data[0], data_bits, puncture_pattern{nullptr, 2});
+      viterbi_free(vp);
+    }
+
+    /*!
+     *  Decode function for punctured input.
+     */
+    void viterbi::conv_decode(const unsigned char * symbols, unsigned char * data, int data_bits, Rate rate)
+    {
+      struct v * vp = viterbi_alloc(data_bits);
+      viterbi_init(vp, 0);
+      viterbi_decode(vp, symbols, data, data_bits, puncturer::pattern(rate));
       viterbi_free(vp);
     }
 
@@ -161,8 +172,9 @@ namespace fun
      * \param symbols
      * \param data
      * \param nbits
+     * \param punc
      */
-    void viterbi::viterbi_decode(struct v *vp, const COMPUTETYPE *symbols, unsigned char *data, int nbits) {
+    void viterbi::viterbi_decode(struct v *vp, const COMPUTETYPE *symbols, unsigned char *data, int nbits, puncture_pattern punc) {
       // vp = viterbi decoder
       // data = decoded
       // symbols = signal
@@ -173,7 +185,7 @@ namespace fun
 
       /* Decode block */
       //vp->update_blk(vp, symbols, nbits+(K-1));
-      viterbi_update_blk_SPIRAL(vp, symbols, nbits + (K-1));
+      viterbi_update_blk_SPIRAL(vp, symbols, nbits + (K-1), punc);
 
       /* Do Viterbi chainback */
       viterbi_chainback(vp, data, nbits, 0);
@@ -185,14 +197,15 @@ namespace fun
      * \param vp
      * \param syms
      * \param nbits
+     * \param punc
      */
-    void viterbi::viterbi_update_blk_SPIRAL(struct v *vp, const COMPUTETYPE *syms, int nbits) {
+    void viterbi::viterbi_update_blk_SPIRAL(struct v *vp, const COMPUTETYPE *syms, int nbits, puncture_pattern punc) {
       decision_t *d = (decision_t *)vp->decisions;
 
       for (int s = 0; s < nbits; s++)
         memset(d+s, 0, sizeof(decision_t));
 
-      FULL_SPIRAL(nbits, vp->new_metrics->t, vp->old_metrics->t, syms, d->t, Branchtab);
+      FULL_SPIRAL(nbits, vp->new_metrics->t, vp->old_metrics->t, syms, d->t, Branchtab, punc);
     }
 
     /*!
@@ -203,11 +216,29 @@ namespace fun
      * \param syms
      * \param dec
      * \param Branchtab
+     * \param punc
+     *
+     *  Each iteration consumes 4 rate 1/2 symbols. When the input is punctured
+     *  they are gathered through the keep map first, with holes set to the
+     *  neutral value 127 (the same value puncturer::depuncture() inserts).
      */
-    void viterbi::FULL_SPIRAL(int nbits, unsigned char *Y, unsigned char *X, const unsigned char *syms, unsigned char *dec, unsigned char *Branchtab) {
+    void viterbi::FULL_SPIRAL(int nbits, unsigned char *Y, unsigned char *X, const unsigned char *syms, unsigned char *dec, unsigned char *Branchtab, puncture_pattern punc) {
+        const unsigned char *cursor = syms;
+        int phase = 0;
+        unsigned char gathered[4];
         for(int i9 = 0; i9 <= (nbits/2-1); i9++) {
+            const unsigned char *sp;
+            if (punc.keep == nullptr) {
+                sp = syms + 4 * i9;
+            } else {
+                for (int e = 0; e < 4; e++) {
+                    gathered[e] = punc.keep[phase] ? *cursor++ : 127;
+                    if (++phase == punc.period) phase = 0;
+                }
+                sp = gathered;
+            }
             unsigned char a75, a81;
-            int a73, a92;
+            int a92;
             short int s20, s21, s26, s27;
             const unsigned char  *a74, *a80, *b6;
             short int  *a110, *a111, *a91, *a93, *a94;
@@ -224,14 +255,13 @@ namespace fun
             s18 = *(a71);
             a72 = (a71 + 2);
             s19 = *(a72);
-            a73 = (4 * i9);
-            a74 = (syms + a73);
+            a74 = sp;
             a75 = *(a74);
             a76 = _mm_set1_epi8(a75);
             a77 = ((__m128i  *) Branchtab);
             a78 = *(a77);
             a79 = _mm_xor_si128(a76, a78);
-            b6 = (a73 + syms);
+            b6 = sp;
             a80 = (b6 + 1);
             a81 = *(a80);
             a82 = _mm_set1_epi8(a81);
@@ -330,7 +360,7 @@ namespace fun
                 ((__m128i  *) Y)[3] = _mm_subs_epu8(((__m128i  *) Y)[3], m6);
             }
             unsigned char a188, a194;
-            int a186, a205;
+            int a205;
             short int s48, s49, s54, s55;
             const unsigned char  *a187, *a193, *b15;
             short int  *a204, *a206, *a207, *a223, *a224, *b16;
@@ -347,8 +377,7 @@ namespace fun
             s46 = *(a184);
             a185 = (a184 + 2);
             s47 = *(a185);
-            a186 = (4 * i9);
-            b15 = (a186 + syms);
+            b15 = sp;
             a187 = (b15 + 2);
             a188 = *(a187);
             a189 = _mm_set1_epi8(a188);
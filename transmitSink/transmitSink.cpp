@@ -0,0 +1,96 @@
+#include "transmitSink.h"
+#include <cstring>
+#include "link_capacity.h"
+
+TransmitSink::TransmitSink(int capacity, size_t mtu, int fps, uint32_t ssrc, uint8_t payloadType)
+: holders_(capacity < 1 ? 1 : capacity), queue_(capacity), packetizer_(ssrc, payloadType, mtu),
+ticksPerPts_(90000 / (fps < 1 ? 1 : fps)), rate_(fun::RATE_1_2_BPSK), alignedRate_(fun::RATE_1_2_BPSK) {
+    packetizer_.setFragmentSize(fun::link_capacity::aligned_length(static_cast<int>(packetizer_.mtu()), alignedRate_));
+    packetizer_.setSink([this](const RtpPacketView* packets, size_t count) { return accept(packets, count); });
+}
+
+void TransmitSink::push(EncodedPacket packet) {
+    if (!packet) return;
+    frames_++;
+
+    // 速率变了就重新按符号对齐分片（打包器只在这个线程使用）
+    fun::Rate rate = rate_;
+    if (rate != alignedRate_) {
+        alignedRate_ = rate;
+        packetizer_.setFragmentSize(fun::link_capacity::aligned_length(static_cast<int>(packetizer_.mtu()), rate));
+    }
+
+    // 按顺序循环使用；holders_ 和队列槽一样多，正常情况下轮到时它的包早已发出。
+    // 只有前面的包被整批丢掉过才可能还在用，这时队列也满了，直接丢掉这个包
+    Holder& holder = holders_[nextHolder_];
+    if (holder.busy.load(std::memory_order_acquire)) {
+        dropped_++;
+        return;
+    }
+    nextHolder_ = (nextHolder_ + 1) % holders_.size();
+
+    uint32_t timestamp = static_cast<uint32_t>(packet.pts() * ticksPerPts_);
+    bool frameEnd = packet.frameEnd();
+    origin_us_ = fun::tx_queue::now_us() - packet.latencyUs();
+    holder.packet = std::move(packet);
+    holder.busy = true;
+    holder.refs = 1;                    // 打包期间自己持有一个引用
+    current_ = &holder;
+
+    packetizer_.packetize(holder.packet.data(), holder.packet.size(), timestamp, frameEnd);
+    if (!frameEnd) packetizer_.flush(); // 低延迟模式：slice 编码完就发，不等整帧
+
+    current_ = nullptr;
+    releaseHolder(&holder);
+}
+
+// 打包器 flush() 时调用，只拷贝 RTP 头，负载指向 holder 里的 AVPacket。
+// 头放不进 tx_packet 的整批丢掉（打包器的头最多 14 字节，正常不会发生）
+size_t TransmitSink::accept(const RtpPacketView* packets, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (packets[i].headerSize > TX_PACKET_HEADER_SIZE) {
+            dropped_ += count;
+            return 0;
+        }
+    }
+    if (static_cast<size_t>(queue_.free_slots()) < count) {
+        dropped_ += count;
+        return 0;
+    }
+
+    fun::Rate rate = alignedRate_;
+    for (size_t i = 0; i < count; i++) {
+        fun::tx_packet* slot = queue_.write_slot();
+        memcpy(slot->header, packets[i].header, packets[i].headerSize);
+        slot->header_length = static_cast<int>(packets[i].headerSize);
+        slot->body = packets[i].payload;
+        slot->body_length = static_cast<int>(packets[i].payloadSize);
+        slot->rate = rate;
+        slot->origin_us = origin_us_;
+        slot->release = &TransmitSink::releaseHolder;
+        slot->context = current_;
+        current_->refs.fetch_add(1, std::memory_order_relaxed);
+        queue_.commit();
+
+        bytes_ += packets[i].headerSize + packets[i].payloadSize;
+    }
+    packets_ += count;
+    return count;
+}
+
+void TransmitSink::releaseHolder(void* context) {
+    Holder* holder = static_cast<Holder*>(context);
+    if (holder->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        holder->packet.reset();
+        holder->busy.store(false, std::memory_order_release);
+    }
+}
+
+TransmitSinkStats TransmitSink::getStats() const {
+    TransmitSinkStats stats;
+    stats.frames = frames_;
+    stats.packets = packets_;
+    stats.bytes = bytes_;
+    stats.dropped = dropped_;
+    return stats;
+}
@@ -0,0 +1,78 @@
+#ifndef TRANSMIT_SINK_H
+#define TRANSMIT_SINK_H
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include "videoEncoder.h"
+#include "rtpPacketizer.h"
+#include "tx_queue.h"
+
+struct TransmitSinkStats {
+    uint64_t frames;          // 交给 push() 的包数（低延迟模式下是 slice 数）
+    uint64_t packets;         // 放进 tx_queue 的 RTP 包数
+    uint64_t bytes;           // 这些包的字节数
+    uint64_t dropped;         // 队列满（或 RTP 头超过 TX_PACKET_HEADER_SIZE）时丢掉的 RTP 包数
+};
+
+// 编码器到 OFDM 发射机的进程内通路，不经过 UDP 套接字，也不拷贝负载。
+// 编码器的包按 RTP 打包后放进 fun::tx_queue：RTP 头拷贝进队列的槽，负载直接指向 AVPacket 的数据。
+// EncodedPacket 被保留到它的最后一个分片发出去为止，然后回到 PacketPool。
+//
+//   TransmitSink sink;
+//   tx.start_async();
+//   tx.attach_queue(&sink.queue());
+//   encoder.start(sink.callback());
+//
+// push() 只能在一个线程（编码线程）调用；setRate() 可以在任意线程调用。
+class TransmitSink {
+    public:
+        // capacity 是 tx_queue 的槽数，要能放下发射机队列里的帧加上一帧视频的包；
+        // fps 用来把编码器的 pts 换算成 90 kHz 的 RTP 时间戳
+        TransmitSink(int capacity = 256, size_t mtu = 1400, int fps = 30,
+                     uint32_t ssrc = 0x12345678, uint8_t payloadType = 96);
+
+        TransmitSink(const TransmitSink&) = delete;
+        TransmitSink& operator=(const TransmitSink&) = delete;
+
+        fun::tx_queue& queue() { return queue_; }
+
+        // PHY 速率改变时调用。之后的包用新速率发送，FU-A 分片按新速率的 OFDM 符号对齐
+        void setRate(fun::Rate rate) { rate_ = rate; }
+
+        // 打包并入队。一次打包的包要么全部入队，要么在队列放不下时全部丢掉，不会只发半个 NAL
+        void push(EncodedPacket packet);
+
+        VideoEncoder::EncodeCallback callback() {
+            return [this](EncodedPacket packet) { push(std::move(packet)); };
+        }
+
+        TransmitSinkStats getStats() const;
+
+    private:
+        // 一个 EncodedPacket 和引用它的队列槽数。数量与队列槽数相同，按顺序循环使用
+        struct Holder {
+            EncodedPacket packet;
+            std::atomic<int> refs{0};
+            std::atomic<bool> busy{false};   // packet 归还之后才清除
+        };
+
+        static void releaseHolder(void* context);   // 由发射机的发送线程调用
+        size_t accept(const RtpPacketView* packets, size_t count);
+
+        // holders_ 要在 queue_ 之后析构，队列析构时会释放还没发出的包
+        std::vector<Holder> holders_;
+        size_t nextHolder_ = 0;
+        fun::tx_queue queue_;
+        RtpPacketizer packetizer_;
+
+        int ticksPerPts_;
+        std::atomic<fun::Rate> rate_;
+        fun::Rate alignedRate_;
+        Holder* current_ = nullptr;     // 正在打包的包
+        long long origin_us_ = 0;       // 当前包进入编码器的时间
+
+        std::atomic<uint64_t> frames_{0}, packets_{0}, bytes_{0}, dropped_{0};
+};
+
+#endif //TRANSMIT_SINK_H
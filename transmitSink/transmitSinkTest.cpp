@@ -0,0 +1,86 @@
+// 摄像头 -> 编码器 -> TransmitSink -> OFDM 发射机，测量从帧进入编码器到最后一个采样点交给无线电的延迟。
+// 用法：transmitSinkTest [usrp]
+//   默认使用 loopback_radio，接收机收到的 RTP 包经 RtpDepacketizer 重组成帧；加 usrp 参数则通过 USRP 发送。
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstring>
+#include "cameraCapture.h"
+#include "videoEncoder.h"
+#include "transmitSink.h"
+#include "transmitter.h"
+#include "receiver.h"
+#include "loopback_radio.h"
+#include "link_capacity.h"
+#include "rtpDepacketizer.h"
+
+using namespace std;
+
+static RtpDepacketizer depacketizer;
+
+static void on_packets(vector<vector<unsigned char>> packets) {
+    depacketizer.push(packets);
+}
+
+int main(int argc, char* argv[]) {
+    bool use_usrp = argc > 1 && strcmp(argv[1], "usrp") == 0;
+    const double samp_rate = 5e6;
+    const fun::Rate rate = fun::RATE_1_2_QAM16;
+
+    try {
+        shared_ptr<fun::radio> radio;
+        unique_ptr<fun::receiver> rx;
+        if (use_usrp) {
+            radio = make_shared<fun::usrp>(fun::usrp_params(5.72e9, samp_rate));
+        } else {
+            radio = make_shared<fun::loopback_radio>(samp_rate);
+            rx.reset(new fun::receiver(&on_packets, radio));
+        }
+
+        fun::transmitter tx(radio);
+        tx.start_async();
+
+        TransmitSink sink;
+        sink.setRate(rate);
+        tx.attach_queue(&sink.queue());
+
+        // 码率按链路能力设置，分片大小和 TransmitSink 的 MTU 一致
+        fun::link_capacity capacity(samp_rate);
+        VideoEncoder encoder(640, 480);
+        encoder.set_low_latency(true, 4);
+        encoder.set_bitrate(static_cast<int64_t>(capacity.video_bitrate(rate, 1400)));
+        encoder.init();
+        encoder.start(sink.callback());
+
+        CameraCapture camera(640, 480, "/dev/video0");
+        camera.start([&encoder](FrameLease lease) { encoder.process_frame(std::move(lease)); });
+
+        for (int second = 1; second <= 10; second++) {
+            this_thread::sleep_for(chrono::seconds(1));
+            EncoderStats es = encoder.get_stats();
+            TransmitSinkStats ss = sink.getStats();
+            fun::tx_stats ts = tx.get_stats();
+            cout << second << " s: 编码 " << es.framesEncoded << " 帧，入队 " << ss.packets << " 包（丢弃 " << ss.dropped
+                 << "），发送 " << ts.queue_frames << " 包，编码到空口延迟 平均 " << ts.mean_source_latency_us
+                 << " us 最大 " << ts.max_source_latency_us << " us";
+            if (rx) {
+                AccessUnit au;
+                while (depacketizer.pop(au, 0)) {}
+                DepacketizerStats ds = depacketizer.getStats();
+                cout << "，收到 " << ds.packets << " 包 " << ds.accessUnits << " 帧（丢帧 " << ds.framesDropped
+                     << "，丢包 " << ds.lost << "）";
+            }
+            cout << endl;
+        }
+
+        camera.stop();
+        encoder.stop();
+        tx.flush();
+        tx.stop_async();
+    } catch (const exception& e) {
+        cerr << "TransmitSink 测试失败: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,28 +1,116 @@
 #include "videoEncoder.h"
 
-VideoEncoder::VideoEncoder(int width = 640, int height = 480, AVPixelFormat in_pix_fmt = AV_PIX_FMT_YUYV422,
-    AVPixelFormat out_pix_fmt = AV_PIX_FMT_YUV420P)
+#include <chrono>
+
+PacketPool::~PacketPool() {
+    for (AVPacket* pkt : free_) av_packet_free(&pkt);
+}
+
+AVPacket* PacketPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            AVPacket* pkt = free_.back();
+            free_.pop_back();
+            return pkt;
+        }
+    }
+    return av_packet_alloc();
+}
+
+void PacketPool::release(AVPacket* pkt) {
+    av_packet_unref(pkt);
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(pkt);
+}
+
+FramePool::~FramePool() {
+    for (AVFrame* frame : free_) av_frame_free(&frame);
+}
+
+AVFrame* FramePool::acquire() {
+    AVFrame* frame = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_.empty()) {
+            frame = free_.back();
+            free_.pop_back();
+        }
+    }
+
+    if (!frame) {
+        frame = av_frame_alloc();
+        if (!frame) return nullptr;
+    }
+
+    // 编码器还引用着这块缓冲区（lookahead 等）时换一块新的，内容反正会被覆盖，不需要拷贝
+    if (frame->buf[0] && !av_frame_is_writable(frame)) av_frame_unref(frame);
+    if (!frame->buf[0]) {
+        frame->width = width_;
+        frame->height = height_;
+        frame->format = pix_fmt_;
+        if (av_frame_get_buffer(frame, 0) < 0) {
+            av_frame_free(&frame);
+            return nullptr;
+        }
+    }
+    return frame;
+}
+
+void FramePool::release(AVFrame* frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(frame);
+}
+
+EncodedPacket& EncodedPacket::operator=(EncodedPacket&& other) noexcept {
+    if (this == &other) return *this;
+    reset();
+    pkt_ = other.pkt_;
+    pool_ = std::move(other.pool_);
+    data_ = other.data_;
+    size_ = other.size_;
+    frameEnd_ = other.frameEnd_;
+    latencyUs_ = other.latencyUs_;
+    other.pkt_ = nullptr;
+    return *this;
+}
+
+void EncodedPacket::reset() {
+    if (!pkt_) return;
+    if (pool_) pool_->release(pkt_);
+    else av_packet_free(&pkt_);
+    pkt_ = nullptr;
+    pool_.reset();
+}
+
+VideoEncoder::VideoEncoder(int width, int height, AVPixelFormat in_pix_fmt, AVPixelFormat out_pix_fmt, int queue_depth)
 : width_(width), height_(height), in_pix_fmt_(in_pix_fmt), out_pix_fmt_(out_pix_fmt),
-sws_ctx_(nullptr), codec_context_(nullptr), encode_thread_(), running_(false) {}
+sws_ctx_(nullptr), codec_context_(nullptr), encode_thread_(), running_(false),
+queue_depth_(queue_depth < 1 ? 1 : queue_depth),
+out_width_(width), out_height_(height),
+in_pool_(width, height, in_pix_fmt),
+packet_pool_(std::make_shared<PacketPool>()) {}
 
 VideoEncoder::~VideoEncoder() {
     stop();
     if (sws_ctx_) sws_freeContext(sws_ctx_);
     avcodec_free_context(&codec_context_);
-    av_frame_free(&out_frame_);
 }
 
 void VideoEncoder::init() {
-    // 初始化 Swscale 上下文
-    sws_ctx_ = sws_getContext(width_, height_, in_pix_fmt_, width_, height_, out_pix_fmt_,
-                             SWS_BILINEAR, nullptr, nullptr, nullptr);
-    if (!sws_ctx_) throw std::runtime_error("创建转换上下文失败");
+    out_width_ = downscale_ ? width_ / 2 : width_;
+    out_height_ = downscale_ ? height_ / 2 : height_;
+    out_pool_.reset(new FramePool(out_width_, out_height_, out_pix_fmt_));
 
-    // 分配输出帧
-    out_frame_ = av_frame_alloc();
-    if (!out_frame_) throw std::runtime_error("分配输出帧失败");
-    int ret = av_image_alloc(out_frame_->data, out_frame_->linesize, width_, height_, out_pix_fmt_, 1);
-    if (ret < 0) throw std::runtime_error("分配图像数据失败");
+    if (in_pix_fmt_ == AV_PIX_FMT_YUYV422 && out_pix_fmt_ == AV_PIX_FMT_YUV420P) {
+        // 摄像头的常见情况用专门的转换，一次遍历完成（包括缩小）
+        converter_.reset(new YuyvConverter(width_, height_, downscale_, convert_threads_));
+    } else {
+        // 初始化 Swscale 上下文
+        sws_ctx_ = sws_getContext(width_, height_, in_pix_fmt_, out_width_, out_height_, out_pix_fmt_,
+                                 SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!sws_ctx_) throw std::runtime_error("创建转换上下文失败");
+    }
 
     // 查找 H.264 编码器
     const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_H264);
@@ -33,111 +121,356 @@ void VideoEncoder::init() {
     if (!codec_context_) throw std::runtime_error("创建编码器上下文失败");
 
     // 设置编码参数
-    codec_context_->bit_rate = 400000;
-    codec_context_->width = width_;
-    codec_context_->height = height_;
+    codec_context_->width = out_width_;
+    codec_context_->height = out_height_;
     codec_context_->time_base = {1, 30};
     codec_context_->framerate = {30, 1};
     codec_context_->gop_size = 10;
     codec_context_->max_b_frames = 1;
     codec_context_->pix_fmt = out_pix_fmt_;
 
-    av_opt_set(codec_context_->priv_data, "preset", "fast", 0);
+    if (low_latency_) {
+        // B 帧每帧增加一帧的重排延迟；周期 IDR 造成的码率突发 PHY 承载不了，
+        // 改为帧内刷新：每帧只有一列宏块是帧内编码，refresh_period_ 帧刷新一轮
+        codec_context_->max_b_frames = 0;
+        codec_context_->gop_size = refresh_period_;
+        codec_context_->thread_type = FF_THREAD_SLICE;
+        codec_context_->thread_count = slices_;
+        codec_context_->slices = slices_;
+
+        av_opt_set(codec_context_->priv_data, "preset", "veryfast", 0);
+        av_opt_set(codec_context_->priv_data, "tune", "zerolatency", 0);
+        av_opt_set_int(codec_context_->priv_data, "intra-refresh", 1, 0);
+    } else {
+        av_opt_set(codec_context_->priv_data, "preset", "fast", 0);
+    }
+
+    // 一开始就打开 VBV，libx264 不允许在运行中从无到有地打开它
+    rate_changed_ = false;
+    apply_rate_control();
 
     // 打开编码器
     if (avcodec_open2(codec_context_, codec, nullptr) < 0)
         throw std::runtime_error("打开编码器失败");
 }
 
+void VideoEncoder::set_bitrate(int64_t bitrate, int vbv_ms) {
+    std::lock_guard<std::mutex> lock(rate_mutex_);
+    bit_rate_ = bitrate < 1000 ? 1000 : bitrate;
+    vbv_ms_ = vbv_ms < 0 ? 0 : vbv_ms;
+    rate_changed_ = true;
+}
+
+// 在 init() 和编码线程调用。libx264 在下一次编码时发现参数变化，调用 x264_encoder_reconfig
+void VideoEncoder::apply_rate_control() {
+    std::lock_guard<std::mutex> lock(rate_mutex_);
+    int vbv_ms = vbv_ms_;
+    if (vbv_ms == 0) {
+        vbv_ms = low_latency_ ? 1000 * codec_context_->framerate.den / codec_context_->framerate.num : 1000;
+    }
+    codec_context_->bit_rate = bit_rate_;
+    codec_context_->rc_max_rate = bit_rate_;
+    codec_context_->rc_buffer_size = static_cast<int>(bit_rate_ * vbv_ms / 1000);
+}
+
+void VideoEncoder::set_conversion(bool downscale, int threads) {
+    downscale_ = downscale;
+    convert_threads_ = threads < 1 ? 1 : threads;
+}
+
+void VideoEncoder::set_low_latency(bool enable, int slices, int refresh_period) {
+    low_latency_ = enable;
+    slices_ = slices < 1 ? 1 : slices;
+    refresh_period_ = refresh_period < 1 ? 1 : refresh_period;
+}
+
 void VideoEncoder::start(EncodeCallback callback) {
     std::lock_guard<std::mutex> lock(mutex_);
     if (running_) return;
 
     encode_callback_ = std::move(callback);
+    start_time_ = now_us();
     running_ = true;
     encode_thread_ = std::thread(&VideoEncoder::encode_loop, this);
 }
 
 void VideoEncoder::stop() {
     std::lock_guard<std::mutex> lock(mutex_);
-            if (!running_) return;
-    
-            running_ = false;
-            if (encode_thread_.joinable()) encode_thread_.join();
+    if (!running_) return;
+
+    {
+        std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+        running_ = false;
+    }
+    queue_cv_.notify_all();
+    if (encode_thread_.joinable()) encode_thread_.join();
 }
 
 void VideoEncoder::process_frame(const std::vector<uint8_t>& frame) {
-    std::lock_guard<std::mutex> lock(mutex_);
     if (!running_) return;
 
-    // 创建输入 AVFrame
-    AVFrame* in_frame = av_frame_alloc();
+    // vector 在调用返回后就不再有效，拷贝到池里的帧
+    AVFrame* in_frame = in_pool_.acquire();
     if (!in_frame) return;
 
-    in_frame->width = width_;
-    in_frame->height = height_;
-    in_frame->format = in_pix_fmt_;
-
-    int ret = av_image_fill_arrays(in_frame->data, in_frame->linesize,
-                                   frame.data(), in_pix_fmt_, width_, height_, 1);
-    if (ret < 0) {
-        av_frame_free(&in_frame);
+    uint8_t* src_data[4];
+    int src_linesize[4];
+    int ret = av_image_fill_arrays(src_data, src_linesize, frame.data(), in_pix_fmt_, width_, height_, 1);
+    if (ret < 0 || frame.size() < size_t(ret)) {
+        in_pool_.release(in_frame);
         return;
     }
+    av_image_copy(in_frame->data, in_frame->linesize, const_cast<const uint8_t**>(src_data), src_linesize,
+                  in_pix_fmt_, width_, height_);
+
+    enqueue(in_frame, true);
+}
 
-    // 转换像素格式
-    sws_scale(sws_ctx_, in_frame->data, in_frame->linesize,
-              0, height_, out_frame_->data, out_frame_->linesize);
+void VideoEncoder::process_frame(FrameLease lease) {
+    if (!running_) return;
 
-    av_frame_unref(out_frame_);
+    AVFrame* in_frame = wrap_frame(std::move(lease));
+    if (!in_frame) return;
 
-    // 编码帧
-    encode_frame(out_frame_);
-    av_frame_free(&in_frame);
+    enqueue(in_frame, false);
 }
 
-void VideoEncoder::encode_loop() {
-    std::ofstream outfile("output.h264", std::ios::binary);
-            if (!outfile) throw std::runtime_error("无法打开输出文件");
-    
-            while (running_) {
-                std::this_thread::sleep_for(std::chrono::microseconds(10000)); // 适当休眠避免忙等待
+static void release_lease(void* opaque, uint8_t*) {
+    delete static_cast<FrameLease*>(opaque);
+}
+
+AVFrame* VideoEncoder::wrap_frame(FrameLease lease) {
+    int size = av_image_get_buffer_size(in_pix_fmt_, width_, height_, 1);
+    if (!lease || size < 0 || lease.size() < size_t(size)) return nullptr;
+
+    AVFrame* frame = av_frame_alloc();
+    if (!frame) return nullptr;
+
+    frame->width = width_;
+    frame->height = height_;
+    frame->format = in_pix_fmt_;
+
+    // 租约移到堆上交给 AVBufferRef，释放回调里析构租约即重新入队
+    uint8_t* data = const_cast<uint8_t*>(lease.data());
+    FrameLease* owner = new FrameLease(std::move(lease));
+    frame->buf[0] = av_buffer_create(data, size, release_lease, owner, AV_BUFFER_FLAG_READONLY);
+    if (!frame->buf[0]) {
+        delete owner;
+        av_frame_free(&frame);
+        return nullptr;
+    }
+
+    if (av_image_fill_arrays(frame->data, frame->linesize, data, in_pix_fmt_, width_, height_, 1) < 0) {
+        av_frame_free(&frame);
+        return nullptr;
+    }
+    return frame;
+}
+
+void VideoEncoder::enqueue(AVFrame* frame, bool pooled) {
+    QueuedFrame dropped{nullptr, false, 0};
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (!running_) {
+            dropped = {frame, pooled, 0};
+        } else {
+            // 队列满时丢掉最旧的帧，实时链路上新帧比完整更重要
+            if (queue_.size() >= queue_depth_) {
+                dropped = queue_.front();
+                queue_.pop_front();
+                frames_dropped_++;
             }
-    
-            // 刷新编码器
-            this->encode_frame(nullptr);
+            frame->pts = current_pts_++;
+            queue_.push_back({frame, pooled, now_us()});
+            frames_queued_++;
+        }
+    }
+    queue_cv_.notify_one();
+
+    // 在锁外释放，租约重新入队要做 ioctl
+    if (dropped.frame) release_input(dropped);
 }
 
-void VideoEncoder::encode_frame(AVFrame* frame) {
-    if (!frame) {
-        AVPacket* pkt = av_packet_alloc();
-        if (!pkt) return;
-        av_packet_unref(pkt);
-        return;
+void VideoEncoder::release_input(QueuedFrame& item) {
+    if (item.pooled) in_pool_.release(item.frame);
+    else av_frame_free(&item.frame);
+}
+
+void VideoEncoder::encode_loop() {
+    while (true) {
+        QueuedFrame item;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+            if (!running_) break;
+            item = queue_.front();
+            queue_.pop_front();
+        }
+
+        if (in_pix_fmt_ == out_pix_fmt_ && !downscale_) {
+            // 编码器直接接受输入格式，不需要转换，编码器自己持有需要的引用
+            encode_frame(item.frame, item.enqueueUs);
+            release_input(item);
+            continue;
+        }
+
+        // 转换像素格式，转换完成后输入帧（和它的租约）立即释放
+        AVFrame* out_frame = out_pool_->acquire();
+        if (!out_frame) {
+            release_input(item);
+            continue;
+        }
+        if (converter_) {
+            converter_->convert(item.frame->data[0], item.frame->linesize[0], out_frame->data, out_frame->linesize);
+        } else {
+            sws_scale(sws_ctx_, item.frame->data, item.frame->linesize,
+                      0, height_, out_frame->data, out_frame->linesize);
+        }
+        out_frame->pts = item.frame->pts;
+        int64_t enqueueUs = item.enqueueUs;
+        release_input(item);
+
+        encode_frame(out_frame, enqueueUs);
+        out_pool_->release(out_frame);
+    }
+
+    // 丢弃没来得及编码的帧
+    std::deque<QueuedFrame> remaining;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        remaining.swap(queue_);
     }
+    for (auto& item : remaining) release_input(item);
+
+    // 刷新编码器
+    this->encode_frame(nullptr, 0);
+}
+
+// 只在编码线程调用。frame 为 nullptr 时冲刷编码器。
+// 帧的入队时间随帧一起传进来，按 pts 找回对应的包（有 B 帧时包的顺序和帧不同）
+void VideoEncoder::encode_frame(AVFrame* frame, int64_t enqueueUs) {
+    if (frame && rate_changed_.exchange(false)) apply_rate_control();
 
-    frame->pts = current_pts_++;
     int ret = avcodec_send_frame(codec_context_, frame);
     if (ret < 0) {
-        std::cerr << "发送帧失败" << std::endl;
+        if (frame) std::cerr << "发送帧失败" << std::endl;
         return;
     }
+    if (frame) {
+        frames_encoded_++;
+        in_encoder_.emplace_back(frame->pts, enqueueUs);
+    }
 
     while (true) {
-        AVPacket* pkt = av_packet_alloc();
+        AVPacket* pkt = packet_pool_->acquire();
         if (!pkt) break;
 
         ret = avcodec_receive_packet(codec_context_, pkt);
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-            av_packet_free(&pkt);
+            packet_pool_->release(pkt);
             break;
         } else if (ret < 0) {
             std::cerr << "接收编码数据失败" << std::endl;
-            av_packet_free(&pkt);
+            packet_pool_->release(pkt);
             break;
         }
 
-        encode_callback_(std::vector<uint8_t>(pkt->data, pkt->data + pkt->size));
-        av_packet_unref(pkt);
+        int64_t latency = 0;
+        for (auto it = in_encoder_.begin(); it != in_encoder_.end(); ++it) {
+            if (it->first == pkt->pts) {
+                latency = now_us() - it->second;
+                in_encoder_.erase(it);
+                break;
+            }
+        }
+        frames_out_++;
+        bytes_ += pkt->size;
+        last_latency_us_ = latency;
+        if (latency > max_latency_us_) max_latency_us_ = latency;
+        total_latency_us_ += latency;
+
+        if (low_latency_) {
+            deliver_slices(pkt, latency);
+            continue;
+        }
+
+        EncodedPacket packet;
+        packet.pkt_ = pkt;
+        packet.pool_ = packet_pool_;
+        packet.data_ = pkt->data;
+        packet.size_ = pkt->size;
+        packet.latencyUs_ = latency;
+
+        packets_++;
+        encode_callback_(std::move(packet));
     }
-}
\ No newline at end of file
+}
+
+// 返回从 pos 开始的下一个 Annex B 起始码（00 00 01 或 00 00 00 01）的位置，没有则返回 size
+static size_t next_start_code(const uint8_t* data, size_t pos, size_t size) {
+    for (size_t i = pos; i + 3 <= size; i++) {
+        if (data[i] == 0 && data[i + 1] == 0) {
+            if (data[i + 2] == 1) return i;
+            if (data[i + 2] == 0 && i + 3 < size && data[i + 3] == 1) return i;
+        }
+    }
+    return size;
+}
+
+// 把一帧的包按 NAL 单元拆开，每个 slice（以及 SPS/PPS/SEI）单独交给回调，
+// 每段引用同一块包数据，不拷贝。
+void VideoEncoder::deliver_slices(AVPacket* pkt, int64_t latency) {
+    const uint8_t* data = pkt->data;
+    size_t size = pkt->size;
+
+    size_t start = next_start_code(data, 0, size);
+    while (start < size) {
+        size_t end = next_start_code(data, start + 3, size);
+
+        AVPacket* ref = packet_pool_->acquire();
+        if (!ref || av_packet_ref(ref, pkt) < 0) {
+            if (ref) packet_pool_->release(ref);
+            break;
+        }
+
+        EncodedPacket packet;
+        packet.pkt_ = ref;
+        packet.pool_ = packet_pool_;
+        packet.data_ = data + start;
+        packet.size_ = end - start;
+        packet.frameEnd_ = end == size;
+        packet.latencyUs_ = latency;
+
+        packets_++;
+        encode_callback_(std::move(packet));
+        start = end;
+    }
+
+    packet_pool_->release(pkt);
+}
+
+EncoderStats VideoEncoder::get_stats() const {
+    EncoderStats stats;
+    stats.framesQueued = frames_queued_;
+    stats.framesDropped = frames_dropped_;
+    stats.framesEncoded = frames_encoded_;
+    stats.packets = packets_;
+    stats.bytes = bytes_;
+    double elapsed = start_time_ ? (now_us() - start_time_) / 1e6 : 0.0;
+    stats.encodeFps = elapsed > 0 ? stats.framesEncoded / elapsed : 0.0;
+    stats.bitrate = elapsed > 0 ? stats.bytes * 8 / elapsed : 0.0;
+    {
+        std::lock_guard<std::mutex> lock(rate_mutex_);
+        stats.targetBitrate = bit_rate_;
+    }
+    stats.lastLatencyUs = last_latency_us_;
+    stats.maxLatencyUs = max_latency_us_;
+    uint64_t frames_out = frames_out_;
+    stats.meanLatencyUs = frames_out ? double(total_latency_us_) / frames_out : 0.0;
+    return stats;
+}
+
+int64_t VideoEncoder::now_us() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -11,41 +11,198 @@ extern "C" {
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <deque>
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <mutex>
+#include <condition_variable>
+#include "cameraCapture.h"
+#include "yuyvConverter.h"
+
+// AVPacket 的对象池，避免每个包都 av_packet_alloc。线程安全：包在编码线程取出，在回调的任意线程归还。
+class PacketPool {
+    public:
+        ~PacketPool();
+        AVPacket* acquire();
+        void release(AVPacket* pkt);   // 解引用数据后放回池里
+    private:
+        std::mutex mutex_;
+        std::vector<AVPacket*> free_;
+};
+
+// 固定格式和尺寸的 AVFrame 对象池，帧缓冲区只在第一次取出时分配。
+// 取出的帧保证可写：编码器还持有旧缓冲区的引用时换一块新的（不拷贝旧内容）。
+class FramePool {
+    public:
+        FramePool(int width, int height, AVPixelFormat pix_fmt) : width_(width), height_(height), pix_fmt_(pix_fmt) {}
+        ~FramePool();
+        AVFrame* acquire();
+        void release(AVFrame* frame);
+    private:
+        int width_, height_;
+        AVPixelFormat pix_fmt_;
+        std::mutex mutex_;
+        std::vector<AVFrame*> free_;
+};
+
+// 编码器输出的一个包，只能移动。析构时 AVPacket 归还到 PacketPool。
+class EncodedPacket {
+    public:
+        EncodedPacket() = default;
+        ~EncodedPacket() { reset(); }
+
+        EncodedPacket(EncodedPacket&& other) noexcept { *this = std::move(other); }
+        EncodedPacket& operator=(EncodedPacket&& other) noexcept;
+
+        EncodedPacket(const EncodedPacket&) = delete;
+        EncodedPacket& operator=(const EncodedPacket&) = delete;
+
+        // 低延迟模式下是一个 NAL 单元（包括起始码），data() 指向 AVPacket 数据中的一段
+        const uint8_t* data() const { return data_; }
+        size_t size() const { return size_; }
+        int64_t pts() const { return pkt_->pts; }
+        bool keyframe() const { return pkt_->flags & AV_PKT_FLAG_KEY; }
+        bool frameEnd() const { return frameEnd_; }        // 是否是这一帧的最后一个包（RTP marker）
+        int64_t latencyUs() const { return latencyUs_; }   // 从 process_frame() 到编码完成的时间
+        AVPacket* get() const { return pkt_; }
+        explicit operator bool() const { return pkt_ != nullptr; }
+
+        void reset();
+
+    private:
+        friend class VideoEncoder;
+
+        AVPacket* pkt_ = nullptr;
+        std::shared_ptr<PacketPool> pool_;
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+        bool frameEnd_ = true;
+        int64_t latencyUs_ = 0;
+};
+
+struct EncoderStats {
+    uint64_t framesQueued;    // 进入队列的帧数
+    uint64_t framesDropped;   // 队列满时丢掉的最旧帧数
+    uint64_t framesEncoded;   // 送进编码器的帧数
+    uint64_t packets;         // 输出的包数（低延迟模式下是 slice/NAL 数）
+    uint64_t bytes;           // 输出的字节数
+    double encodeFps;         // 自 start() 以来每秒编码的帧数
+    double bitrate;           // 自 start() 以来的输出码率，bit/s
+    int64_t targetBitrate;    // 当前的目标码率，bit/s
+    int64_t lastLatencyUs;    // 最近一帧从 process_frame() 到输出包的延迟
+    int64_t maxLatencyUs;
+    double meanLatencyUs;
+};
 
 class VideoEncoder {
     public:
-        using EncodeCallback = std::function<void(const std::vector<uint8_t>&)>;
-    
-        VideoEncoder(int width, int height, AVPixelFormat in_pix_fmt, AVPixelFormat out_pix_fmt);
+        // 包通过移动交给回调，回调可以保留它，释放后 AVPacket 回到池里
+        using EncodeCallback = std::function<void(EncodedPacket packet)>;
+
+        // queue_depth 是输入队列的最大帧数，队列满时丢掉最旧的帧，保证编码的总是较新的帧
+        VideoEncoder(int width = 640, int height = 480, AVPixelFormat in_pix_fmt = AV_PIX_FMT_YUYV422,
+                     AVPixelFormat out_pix_fmt = AV_PIX_FMT_YUV420P, int queue_depth = 4);
         ~VideoEncoder();
-    
+
+        // 低延迟配置，必须在 init() 之前调用：zerolatency、无 B 帧、周期性帧内刷新代替 IDR、
+        // 按 slice 多线程编码，并且每个 slice 单独交给 EncodeCallback。
+        // slices 是每帧的 slice 数（也是编码线程数），refresh_period 是帧内刷新一轮的帧数。
+        void set_low_latency(bool enable, int slices = 4, int refresh_period = 30);
+
+        // 像素格式转换的设置，必须在 init() 之前调用。downscale 时编码分辨率是输入的一半，
+        // threads 是转换用的线程数。YUYV422 -> YUV420P 使用 YuyvConverter，其他格式用 swscale。
+        void set_conversion(bool downscale, int threads = 1);
+
+        // 目标码率和 VBV 缓冲区，init() 之前或运行中都可以调用，运行中修改在下一帧编码前生效。
+        // 链路的 PHY 速率改变时用 fun::link_capacity::video_bitrate() 算出新码率再调用这里，
+        // 编码器就不会产生空口送不出去的数据。vbv_ms 是 VBV 缓冲区对应的时长，0 表示自动
+        // （低延迟模式下一帧的时长，否则 1 秒）；缓冲区越小，码率突发越小。
+        // 运行中修改依赖编码器支持重新配置（libx264 支持）。
+        void set_bitrate(int64_t bitrate, int vbv_ms = 0);
+
         void init();
-    
+
         void start(EncodeCallback callback);
-    
+
+        // 停止编码线程，丢弃队列中剩下的帧并冲刷编码器
         void stop();
-    
+
+        // 以下函数只入队，转换和编码都在编码线程进行
         void process_frame(const std::vector<uint8_t>& frame);
-    
+
+        // 零拷贝输入：租约包装成 AVFrame 入队，编码线程转换完成后释放租约（缓冲区重新入队）
+        void process_frame(FrameLease lease);
+
+        // 把租约包装成引用计数的 AVFrame（in_pix_fmt_, width_ x height_），不拷贝像素。
+        // 租约由 AVFrame 的 AVBufferRef 持有，最后一个引用释放时缓冲区才重新入队。
+        // 失败返回 nullptr（此时租约已释放）。
+        AVFrame* wrap_frame(FrameLease lease);
+
+        EncoderStats get_stats() const;
+
     private:
+        struct QueuedFrame {
+            AVFrame* frame;
+            bool pooled;         // 是否来自 in_pool_，否则是 wrap_frame() 的帧
+            int64_t enqueueUs;   // 入队时间，用于计算延迟
+        };
+
+        void enqueue(AVFrame* frame, bool pooled);
+        void release_input(QueuedFrame& item);
+
         void encode_loop();
-    
-        void encode_frame(AVFrame* frame);
-    
+
+        void encode_frame(AVFrame* frame, int64_t enqueueUs);
+
+        void deliver_slices(AVPacket* pkt, int64_t latency);
+
+        void apply_rate_control();
+
+        int64_t now_us() const;
+
         int width_, height_;
         AVPixelFormat in_pix_fmt_, out_pix_fmt_;
         SwsContext* sws_ctx_;
         AVCodecContext* codec_context_;
-        AVFrame* out_frame_;
         std::thread encode_thread_;
         std::atomic<bool> running_;
-        std::function<void(const std::vector<uint8_t>&)> encode_callback_;
+        EncodeCallback encode_callback_;
         uint64_t current_pts_ = 0;
         std::mutex mutex_;
+
+        int out_width_, out_height_;             // 编码分辨率
+        bool downscale_ = false;
+        int convert_threads_ = 1;
+        std::unique_ptr<YuyvConverter> converter_;
+
+        // 码率控制，set_bitrate() 可能在其他线程调用，编码线程在下一帧前应用
+        int64_t bit_rate_ = 400000;
+        int vbv_ms_ = 0;
+        mutable std::mutex rate_mutex_;
+        std::atomic<bool> rate_changed_{false};
+
+        bool low_latency_ = false;
+        int slices_ = 1;
+        int refresh_period_ = 30;
+
+        // 输入队列
+        size_t queue_depth_;
+        std::deque<QueuedFrame> queue_;
+        std::mutex queue_mutex_;
+        std::condition_variable queue_cv_;
+
+        FramePool in_pool_;                      // vector 输入拷贝到这里
+        std::unique_ptr<FramePool> out_pool_;    // 转换的输出，init() 中按编码分辨率创建
+        std::shared_ptr<PacketPool> packet_pool_;
+
+        // 已送进编码器、还没有输出的帧的 (pts, 入队时间)，只在编码线程访问
+        std::deque<std::pair<int64_t, int64_t>> in_encoder_;
+
+        int64_t start_time_ = 0;
+        std::atomic<uint64_t> frames_queued_{0}, frames_dropped_{0}, frames_encoded_{0}, frames_out_{0}, packets_{0}, bytes_{0};
+        std::atomic<int64_t> last_latency_us_{0}, max_latency_us_{0}, total_latency_us_{0};
     };
 
-#endif //VIDEO_ENCODER_H
\ No newline at end of file
+#endif //VIDEO_ENCODER_H
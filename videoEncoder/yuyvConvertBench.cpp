@@ -0,0 +1,101 @@
+// YUYV422 -> YUV420P 转换的基准：swscale 与 YuyvConverter（标量 / SSSE3 / AVX2、不同线程数）对比
+// 用法：yuyvConvertBench [iterations]
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+#include "yuyvConverter.h"
+
+using namespace std;
+
+static double now_us() {
+    return chrono::duration<double, micro>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Planes {
+    vector<uint8_t> y, u, v;
+    uint8_t* data[3];
+    int linesize[3];
+
+    Planes(int w, int h) : y(w * h), u(w * h / 4), v(w * h / 4) {
+        data[0] = y.data(); data[1] = u.data(); data[2] = v.data();
+        linesize[0] = w; linesize[1] = w / 2; linesize[2] = w / 2;
+    }
+};
+
+static void print_row(const char* name, int w, int h, bool down, double us) {
+    cout << setw(10) << name << setw(6) << w << "x" << left << setw(5) << h << right
+         << (down ? "  2:1 " : "  1:1 ")
+         << fixed << setprecision(1) << setw(10) << us << " us/frame"
+         << setw(10) << 1e6 / us << " fps" << endl;
+}
+
+static double bench_sws(int w, int h, bool down, const vector<uint8_t>& src, int iterations) {
+    int ow = down ? w / 2 : w, oh = down ? h / 2 : h;
+    SwsContext* sws = sws_getContext(w, h, AV_PIX_FMT_YUYV422, ow, oh, AV_PIX_FMT_YUV420P,
+                                     SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!sws) {
+        cerr << "无法创建转换上下文" << endl;
+        return 0;
+    }
+    Planes out(ow, oh);
+    const uint8_t* in_data[1] = { src.data() };
+    int in_linesize[1] = { w * 2 };
+
+    sws_scale(sws, in_data, in_linesize, 0, h, out.data, out.linesize);   // 预热
+    double t0 = now_us();
+    for (int i = 0; i < iterations; i++)
+        sws_scale(sws, in_data, in_linesize, 0, h, out.data, out.linesize);
+    double us = (now_us() - t0) / iterations;
+    sws_freeContext(sws);
+    return us;
+}
+
+static double bench_converter(int w, int h, bool down, int threads, YuyvConverter::Simd simd,
+                              const vector<uint8_t>& src, int iterations) {
+    YuyvConverter conv(w, h, down, threads);
+    conv.setSimd(simd);
+    Planes out(conv.outWidth(), conv.outHeight());
+
+    conv.convert(src.data(), w * 2, out.data, out.linesize);   // 预热
+    double t0 = now_us();
+    for (int i = 0; i < iterations; i++)
+        conv.convert(src.data(), w * 2, out.data, out.linesize);
+    return (now_us() - t0) / iterations;
+}
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 200;
+    const int sizes[][2] = { {640, 480}, {1280, 720}, {1920, 1080} };
+    YuyvConverter::Simd best = YuyvConverter::detectSimd();
+
+    cout << "CPU 支持: " << YuyvConverter::simdName(best) << "，每项 " << iterations << " 次" << endl;
+
+    for (auto& s : sizes) {
+        int w = s[0], h = s[1];
+        vector<uint8_t> src(w * h * 2);
+        for (size_t i = 0; i < src.size(); i++)
+            src[i] = static_cast<uint8_t>(i * 7 + (i >> 11));
+
+        for (bool down : { false, true }) {
+            print_row("swscale", w, h, down, bench_sws(w, h, down, src, iterations));
+            for (int simd = YuyvConverter::SIMD_NONE; simd <= best; simd++) {
+                auto level = static_cast<YuyvConverter::Simd>(simd);
+                print_row(YuyvConverter::simdName(level), w, h, down,
+                          bench_converter(w, h, down, 1, level, src, iterations));
+            }
+            for (int threads : { 2, 4 }) {
+                string name = string(YuyvConverter::simdName(best)) + " x" + to_string(threads);
+                print_row(name.c_str(), w, h, down,
+                          bench_converter(w, h, down, threads, best, src, iterations));
+            }
+        }
+        cout << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,286 @@
+#include "yuyvConverter.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <immintrin.h>
+
+namespace {
+
+    // 与 _mm_avg_epu8 / _mm_avg_epu16 相同的舍入，标量和 SIMD 的结果才能逐字节一致
+    inline uint8_t avg(int a, int b) { return uint8_t((a + b + 1) >> 1); }
+
+    // 每一行 YUYV 按像素对排列：Y(2p) U(p) Y(2p+1) V(p)
+
+    // 两行输入 -> 两行 Y、一行 U/V，从像素 x 开始做到行尾
+    void full_scalar(const uint8_t* r0, const uint8_t* r1, uint8_t* y0, uint8_t* y1,
+                     uint8_t* u, uint8_t* v, int x, int width) {
+        for (int p = x / 2; p < width / 2; p++) {
+            y0[2 * p] = r0[4 * p];
+            y0[2 * p + 1] = r0[4 * p + 2];
+            y1[2 * p] = r1[4 * p];
+            y1[2 * p + 1] = r1[4 * p + 2];
+            u[p] = avg(r0[4 * p + 1], r1[4 * p + 1]);
+            v[p] = avg(r0[4 * p + 3], r1[4 * p + 3]);
+        }
+    }
+
+    // 四行输入 -> 两行缩小的 Y、一行缩小的 U/V，从输入像素 x 开始做到行尾
+    void down_scalar(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, const uint8_t* r3,
+                     uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int x, int width) {
+        for (int i = x / 2; i < width / 2; i++) {
+            y0[i] = avg(avg(r0[4 * i], r1[4 * i]), avg(r0[4 * i + 2], r1[4 * i + 2]));
+            y1[i] = avg(avg(r2[4 * i], r3[4 * i]), avg(r2[4 * i + 2], r3[4 * i + 2]));
+        }
+        for (int j = x / 4; j < width / 4; j++) {
+            int c[2][2];   // [像素对][U/V]
+            for (int k = 0; k < 2; k++) {
+                int p = 2 * j + k;
+                for (int s = 0; s < 2; s++) {
+                    int o = 4 * p + 1 + 2 * s;
+                    c[k][s] = avg(avg(r0[o], r1[o]), avg(r2[o], r3[o]));
+                }
+            }
+            u[j] = avg(c[0][0], c[1][0]);
+            v[j] = avg(c[0][1], c[1][1]);
+        }
+    }
+
+    // 每 128 位内：偶数字节（Y）放低 8 字节，奇数字节（UV 或 V）放高 8 字节
+    #define SPLIT_MASK 0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15
+
+    // 16 个像素一次：返回处理的像素数，余下的由调用者用标量完成
+    __attribute__((target("ssse3")))
+    int full_ssse3(const uint8_t* r0, const uint8_t* r1, uint8_t* y0, uint8_t* y1,
+                   uint8_t* u, uint8_t* v, int width) {
+        const __m128i mask = _mm_setr_epi8(SPLIT_MASK);
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m128i a0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(r0 + 2 * x)), mask);
+            __m128i b0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(r0 + 2 * x + 16)), mask);
+            __m128i a1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(r1 + 2 * x)), mask);
+            __m128i b1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(r1 + 2 * x + 16)), mask);
+
+            _mm_storeu_si128((__m128i*)(y0 + x), _mm_unpacklo_epi64(a0, b0));
+            _mm_storeu_si128((__m128i*)(y1 + x), _mm_unpacklo_epi64(a1, b1));
+
+            __m128i uv = _mm_avg_epu8(_mm_unpackhi_epi64(a0, b0), _mm_unpackhi_epi64(a1, b1));
+            uv = _mm_shuffle_epi8(uv, mask);
+            _mm_storel_epi64((__m128i*)(u + x / 2), uv);
+            _mm_storel_epi64((__m128i*)(v + x / 2), _mm_unpackhi_epi64(uv, uv));
+        }
+        return x;
+    }
+
+    // 相邻两个字节求平均：8 个 16 位字，每个是一对字节的平均
+    __attribute__((target("ssse3")))
+    inline __m128i pair_avg(__m128i a) {
+        return _mm_avg_epu16(_mm_and_si128(a, _mm_set1_epi16(0x00FF)), _mm_srli_epi16(a, 8));
+    }
+
+    __attribute__((target("ssse3")))
+    int down_ssse3(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, const uint8_t* r3,
+                   uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int width) {
+        const __m128i mask = _mm_setr_epi8(SPLIT_MASK);
+        const uint8_t* rows[4] = { r0, r1, r2, r3 };
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m128i y[4], uv[4];
+            for (int r = 0; r < 4; r++) {
+                __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(rows[r] + 2 * x)), mask);
+                __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(rows[r] + 2 * x + 16)), mask);
+                y[r] = _mm_unpacklo_epi64(a, b);
+                uv[r] = _mm_unpackhi_epi64(a, b);
+            }
+
+            __m128i h0 = pair_avg(_mm_avg_epu8(y[0], y[1]));
+            __m128i h1 = pair_avg(_mm_avg_epu8(y[2], y[3]));
+            _mm_storel_epi64((__m128i*)(y0 + x / 2), _mm_packus_epi16(h0, h0));
+            _mm_storel_epi64((__m128i*)(y1 + x / 2), _mm_packus_epi16(h1, h1));
+
+            __m128i c = _mm_avg_epu8(_mm_avg_epu8(uv[0], uv[1]), _mm_avg_epu8(uv[2], uv[3]));
+            c = pair_avg(_mm_shuffle_epi8(c, mask));   // 低 4 个字是 U，高 4 个字是 V
+            c = _mm_packus_epi16(c, c);
+            int32_t uu = _mm_cvtsi128_si32(c), vv = _mm_cvtsi128_si32(_mm_srli_si128(c, 4));
+            memcpy(u + x / 4, &uu, 4);
+            memcpy(v + x / 4, &vv, 4);
+        }
+        return x;
+    }
+
+    // 32 个像素一次。shuffle 只在 128 位内进行，之后用 permute4x64 把两半排回像素顺序
+    __attribute__((target("avx2")))
+    int full_avx2(const uint8_t* r0, const uint8_t* r1, uint8_t* y0, uint8_t* y1,
+                  uint8_t* u, uint8_t* v, int width) {
+        const __m256i mask = _mm256_setr_epi8(SPLIT_MASK, SPLIT_MASK);
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            __m256i a0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(r0 + 2 * x)), mask);
+            __m256i b0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(r0 + 2 * x + 32)), mask);
+            __m256i a1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(r1 + 2 * x)), mask);
+            __m256i b1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(r1 + 2 * x + 32)), mask);
+
+            _mm256_storeu_si256((__m256i*)(y0 + x), _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a0, b0), 0xD8));
+            _mm256_storeu_si256((__m256i*)(y1 + x), _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a1, b1), 0xD8));
+
+            // UV 的顺序不影响行平均，拆分后再一起排回去
+            __m256i uv = _mm256_avg_epu8(_mm256_unpackhi_epi64(a0, b0), _mm256_unpackhi_epi64(a1, b1));
+            uv = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(_mm256_permute4x64_epi64(uv, 0xD8), mask), 0xD8);
+            _mm_storeu_si128((__m128i*)(u + x / 2), _mm256_castsi256_si128(uv));
+            _mm_storeu_si128((__m128i*)(v + x / 2), _mm256_extracti128_si256(uv, 1));
+        }
+        return x;
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i pair_avg256(__m256i a) {
+        return _mm256_avg_epu16(_mm256_and_si256(a, _mm256_set1_epi16(0x00FF)), _mm256_srli_epi16(a, 8));
+    }
+
+    __attribute__((target("avx2")))
+    int down_avx2(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, const uint8_t* r3,
+                  uint8_t* y0, uint8_t* y1, uint8_t* u, uint8_t* v, int width) {
+        const __m256i mask = _mm256_setr_epi8(SPLIT_MASK, SPLIT_MASK);
+        const uint8_t* rows[4] = { r0, r1, r2, r3 };
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            __m256i y[4], uv[4];
+            for (int r = 0; r < 4; r++) {
+                __m256i a = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(rows[r] + 2 * x)), mask);
+                __m256i b = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(rows[r] + 2 * x + 32)), mask);
+                y[r] = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a, b), 0xD8);
+                uv[r] = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(a, b), 0xD8);
+            }
+
+            // packus 也是按 128 位进行的，取 0、2 两个 64 位得到 16 个连续的字节
+            __m256i h0 = pair_avg256(_mm256_avg_epu8(y[0], y[1]));
+            __m256i h1 = pair_avg256(_mm256_avg_epu8(y[2], y[3]));
+            h0 = _mm256_permute4x64_epi64(_mm256_packus_epi16(h0, h0), 0x08);
+            h1 = _mm256_permute4x64_epi64(_mm256_packus_epi16(h1, h1), 0x08);
+            _mm_storeu_si128((__m128i*)(y0 + x / 2), _mm256_castsi256_si128(h0));
+            _mm_storeu_si128((__m128i*)(y1 + x / 2), _mm256_castsi256_si128(h1));
+
+            __m256i c = _mm256_avg_epu8(_mm256_avg_epu8(uv[0], uv[1]), _mm256_avg_epu8(uv[2], uv[3]));
+            c = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(c, mask), 0xD8);   // 低 128 位 U，高 128 位 V
+            c = _mm256_packus_epi16(pair_avg256(c), pair_avg256(c));
+            _mm_storel_epi64((__m128i*)(u + x / 4), _mm256_castsi256_si128(c));
+            _mm_storel_epi64((__m128i*)(v + x / 4), _mm256_extracti128_si256(c, 1));
+        }
+        return x;
+    }
+}
+
+YuyvConverter::YuyvConverter(int width, int height, bool downscale, int threads)
+: width_(width), height_(height), downscale_(downscale), simd_(detectSimd()) {
+    int align = downscale ? 4 : 2;
+    if (width % align || height % align || width <= 0 || height <= 0)
+        throw std::runtime_error("YUYV 转换的尺寸不合法");
+
+    // 每块至少一组行，线程数不超过行组数
+    int groups = height / align;
+    if (threads > groups) threads = groups;
+    bands_ = threads < 1 ? 1 : threads;
+    for (int i = 1; i < bands_; i++) workers_.emplace_back(&YuyvConverter::workerLoop, this, i);
+}
+
+YuyvConverter::~YuyvConverter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exit_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_) worker.join();
+}
+
+YuyvConverter::Simd YuyvConverter::detectSimd() {
+    static const Simd simd = __builtin_cpu_supports("avx2") ? SIMD_AVX2 :
+                             __builtin_cpu_supports("ssse3") ? SIMD_SSSE3 : SIMD_NONE;
+    return simd;
+}
+
+const char* YuyvConverter::simdName(Simd simd) {
+    switch (simd) {
+    case SIMD_AVX2: return "AVX2";
+    case SIMD_SSSE3: return "SSSE3";
+    default: return "scalar";
+    }
+}
+
+void YuyvConverter::setSimd(Simd simd) {
+    simd_ = simd > detectSimd() ? detectSimd() : simd;
+}
+
+void YuyvConverter::convert(const uint8_t* src, int src_stride, uint8_t* const dst[3], const int dst_stride[3]) {
+    src_ = src;
+    src_stride_ = src_stride;
+    for (int i = 0; i < 3; i++) {
+        dst_[i] = dst[i];
+        dst_stride_[i] = dst_stride[i];
+    }
+
+    if (workers_.empty()) {
+        convertRows(0, height_);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation_++;
+        pending_ = workers_.size();
+    }
+    start_cv_.notify_all();
+
+    int align = downscale_ ? 4 : 2;
+    convertRows(0, height_ / align / bands_ * align);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void YuyvConverter::workerLoop(int index) {
+    uint64_t seen = 0;
+    int align = downscale_ ? 4 : 2;
+    int groups = height_ / align;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&] { return exit_ || generation_ != seen; });
+            if (exit_) return;
+            seen = generation_;
+        }
+
+        convertRows(groups * index / bands_ * align, groups * (index + 1) / bands_ * align);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_--;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+void YuyvConverter::convertRows(int first, int last) {
+    int step = downscale_ ? 4 : 2;
+    for (int r = first; r < last; r += step) {
+        const uint8_t* r0 = src_ + size_t(r) * src_stride_;
+        const uint8_t* r1 = r0 + src_stride_;
+        int yr = downscale_ ? r / 2 : r;     // 输出 Y 行
+        int cr = downscale_ ? r / 4 : r / 2; // 输出 U/V 行
+        uint8_t* y0 = dst_[0] + size_t(yr) * dst_stride_[0];
+        uint8_t* y1 = y0 + dst_stride_[0];
+        uint8_t* u = dst_[1] + size_t(cr) * dst_stride_[1];
+        uint8_t* v = dst_[2] + size_t(cr) * dst_stride_[2];
+
+        if (!downscale_) {
+            int x = simd_ == SIMD_AVX2 ? full_avx2(r0, r1, y0, y1, u, v, width_) :
+                    simd_ == SIMD_SSSE3 ? full_ssse3(r0, r1, y0, y1, u, v, width_) : 0;
+            full_scalar(r0, r1, y0, y1, u, v, x, width_);
+        } else {
+            const uint8_t* r2 = r1 + src_stride_;
+            const uint8_t* r3 = r2 + src_stride_;
+            int x = simd_ == SIMD_AVX2 ? down_avx2(r0, r1, r2, r3, y0, y1, u, v, width_) :
+                    simd_ == SIMD_SSSE3 ? down_ssse3(r0, r1, r2, r3, y0, y1, u, v, width_) : 0;
+            down_scalar(r0, r1, r2, r3, y0, y1, u, v, x, width_);
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef YUYV_CONVERTER_H
+#define YUYV_CONVERTER_H
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// YUYV422（打包）转 I420（YUV420P 平面）。一次遍历完成亮度分离和色度行平均，
+// 可选同时做 2:1 缩小（亮度 2x2 平均，色度 4 行平均）。
+// 有 AVX2 / SSSE3 时使用 SIMD，否则用标量实现，三者结果逐字节相同。
+// threads > 1 时按行分块，由常驻的工作线程和调用线程一起转换。
+class YuyvConverter {
+    public:
+        enum Simd { SIMD_NONE, SIMD_SSSE3, SIMD_AVX2 };
+
+        // width 必须是偶数，height 必须是偶数；downscale 时两者都必须是 4 的倍数
+        YuyvConverter(int width, int height, bool downscale = false, int threads = 1);
+        ~YuyvConverter();
+
+        YuyvConverter(const YuyvConverter&) = delete;
+        YuyvConverter& operator=(const YuyvConverter&) = delete;
+
+        // src 是 YUYV 数据，src_stride 是每行字节数；dst 是 Y、U、V 三个平面
+        void convert(const uint8_t* src, int src_stride, uint8_t* const dst[3], const int dst_stride[3]);
+
+        int outWidth() const { return downscale_ ? width_ / 2 : width_; }
+        int outHeight() const { return downscale_ ? height_ / 2 : height_; }
+
+        // 强制使用某个实现（不能超过 CPU 支持的），主要用于测试和基准
+        void setSimd(Simd simd);
+        Simd simd() const { return simd_; }
+        static Simd detectSimd();
+        static const char* simdName(Simd simd);
+
+    private:
+        void convertRows(int first, int last);   // 转换输入行 [first, last)
+        void workerLoop(int index);
+
+        int width_, height_;
+        bool downscale_;
+        Simd simd_;
+
+        // 当前任务
+        const uint8_t* src_;
+        int src_stride_;
+        uint8_t* dst_[3];
+        int dst_stride_[3];
+
+        // 工作线程：每个线程负责一块行，调用线程负责第 0 块
+        int bands_;
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable start_cv_, done_cv_;
+        uint64_t generation_ = 0;
+        int pending_ = 0;
+        bool exit_ = false;
+};
+
+#endif //YUYV_CONVERTER_H
@@ -12,9 +12,9 @@
 
 extern "C" {
 #include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
 #include <libavutil/pixfmt.h>
 }
+#include "yuyvConverter.h"
 
 struct Buffer {
     void* start;
@@ -135,21 +135,11 @@ int main() {
         return 1;
     }
 
-    // 8. 初始化 libswscale 转换上下文：将 YUYV422 转为 YUV420P
-    //    注意：V4L2 中 YUYV 格式对应的 FFmpeg 像素格式是 AV_PIX_FMT_YUYV422
+    // 8. 初始化转换：将 YUYV422 转为 YUV420P
+    //    YuyvConverter 一次遍历完成亮度分离和色度平均，比同尺寸的 sws_scale 快
     int width = 640, height = 480;
-    AVPixelFormat in_pix_fmt  = AV_PIX_FMT_YUYV422;
     AVPixelFormat out_pix_fmt = AV_PIX_FMT_YUV420P;
-    SwsContext* sws_ctx = sws_getContext(width, height,
-                                         in_pix_fmt,
-                                         width, height,
-                                         out_pix_fmt,
-                                         SWS_BILINEAR, nullptr, nullptr, nullptr);
-    if (!sws_ctx) {
-        std::cerr << "无法创建转换上下文" << std::endl;
-        close(fd);
-        return 1;
-    }
+    YuyvConverter converter(width, height);
 
     // 分配输出 AVFrame（YUV420P 格式）
     AVFrame* out_frame = av_frame_alloc();
@@ -159,7 +149,6 @@ int main() {
     int ret = av_image_alloc(out_frame->data, out_frame->linesize, width, height, out_pix_fmt, 1);
     if (ret < 0) {
         std::cerr << "无法分配输出帧内存" << std::endl;
-        sws_freeContext(sws_ctx);
         close(fd);
         return 1;
     }
@@ -177,24 +166,9 @@ int main() {
             break;
         }
 
-        // 创建一个输入 AVFrame 用来包装摄像头采集到的数据
-        AVFrame* in_frame = av_frame_alloc();
-        in_frame->width  = width;
-        in_frame->height = height;
-        in_frame->format = in_pix_fmt;
-        // 使用 av_image_fill_arrays 将缓冲区数据填充到 in_frame 中
-        ret = av_image_fill_arrays(in_frame->data, in_frame->linesize,
-                                   static_cast<uint8_t*>(buffers[buf.index].start),
-                                   in_pix_fmt, width, height, 1);
-        if (ret < 0) {
-            std::cerr << "填充输入帧数据失败" << std::endl;
-            av_frame_free(&in_frame);
-            break;
-        }
-
-        // 进行像素格式转换：YUYV422 -> YUV420P
-        sws_scale(sws_ctx, in_frame->data, in_frame->linesize,
-                  0, height, out_frame->data, out_frame->linesize);
+        // 进行像素格式转换：YUYV422 -> YUV420P，直接读 mmap 缓冲区
+        converter.convert(static_cast<const uint8_t*>(buffers[buf.index].start), width * 2,
+                          out_frame->data, out_frame->linesize);
 
         // 此时，out_frame 包含转换后的 YUV420P 数据，可供后续处理或编码使用
         std::cout << "捕获第 " << i << " 帧，并已转换为 YUV420P" << std::endl;
@@ -203,8 +177,6 @@ int main() {
         saveFrameAsYUV(out_frame, 640, 480, "output.yuv");
 
 
-        av_frame_free(&in_frame);
-
         // 将缓冲区重新入队，以便下次使用
         if (ioctl(fd, VIDIOC_QBUF, &buf) == -1) {
             perror("重新入队缓冲区失败");
@@ -218,7 +190,6 @@ int main() {
     }
 
     // 11. 释放资源
-    sws_freeContext(sws_ctx);
     av_freep(&out_frame->data[0]);
     av_frame_free(&out_frame);
     for (unsigned int i = 0; i < req.count; i++) {